@@ -0,0 +1,168 @@
+/*
+BenchPolicies:
+基准测试与轨迹回放共用的缓存策略表。每个策略按名称登记一个构造函数，
+参数为缓存容量、LRU-K访问历史容量与Hash版本的分片数；
+不继承CacheBase的LRUHashCache、LFUHashCache与编译期组合的Cache通过CacheAdapter统一为CacheBase接口。
+*/
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "CacheARC.h"
+#include "CacheARCCanonical.h"
+#include "CacheARCHash.h"
+#include "CacheBase.h"
+#include "CacheCLOCK.h"
+#include "CacheCLOCKConcurrent.h"
+#include "CacheCLOCKPro.h"
+#include "CacheCompose.h"
+#include "CacheLFU.h"
+#include "CacheLFUAvg.h"
+#include "CacheLFUHash.h"
+#include "CacheLRU.h"
+#include "CacheLRUBuffered.h"
+#include "CacheLRUHash.h"
+#include "CacheLRUK.h"
+#include "CacheLRUKHash.h"
+#include "CacheWTinyLFU.h"
+
+namespace CacheBench {
+
+// 把不继承CacheBase的分片缓存适配为CacheBase
+template <typename Key, typename Value, typename Impl>
+class CacheAdapter : public CacheMgr::CacheBase<Key, Value> {
+public:
+  template <typename... Args>
+  explicit CacheAdapter(Args &&...args) : impl_(std::forward<Args>(args)...) {}
+
+  void put(const Key &key, const Value &val) override { impl_.put(key, val); }
+  bool get(const Key &key, Value &val) override { return impl_.get(key, val); }
+  Value get(const Key &key) override { return impl_.get(key); }
+
+private:
+  Impl impl_;
+};
+
+template <typename Key, typename Value> struct Policy {
+  using CachePtr = std::unique_ptr<CacheMgr::CacheBase<Key, Value>>;
+
+  std::string name;
+  std::function<CachePtr(size_t capacity, size_t histCapacity, int slices)> make;
+};
+
+// 全部缓存策略，Hash版本排在最后
+template <typename Key, typename Value>
+std::vector<Policy<Key, Value>> allPolicies() {
+  using namespace CacheMgr;
+  using CachePtr = typename Policy<Key, Value>::CachePtr;
+  return {
+      {"LRU", [](size_t cap, size_t, int) {
+         return CachePtr(new LRUCache<Key, Value>(cap));
+       }},
+      {"LRU-Buffered", [](size_t cap, size_t, int) {
+         return CachePtr(new LRUBufferedCache<Key, Value>(cap));
+       }},
+      {"LFU", [](size_t cap, size_t, int) {
+         return CachePtr(new LFUCache<Key, Value>(cap));
+       }},
+      {"LFU-Aging", [](size_t cap, size_t, int) {
+         return CachePtr(new LFUAvgCache<Key, Value>(cap));
+       }},
+      {"ARC", [](size_t cap, size_t, int) {
+         return CachePtr(new ARCCache<Key, Value>(cap));
+       }},
+      {"ARC-Canonical", [](size_t cap, size_t, int) {
+         return CachePtr(new ARCCanonicalCache<Key, Value>(cap));
+       }},
+      {"LRU-K", [](size_t cap, size_t hist, int) {
+         return CachePtr(new LRUKCache<Key, Value>(cap, hist, 2));
+       }},
+      {"CLOCK", [](size_t cap, size_t, int) {
+         return CachePtr(new ClockCache<Key, Value>(cap));
+       }},
+      {"CLOCK-Pro", [](size_t cap, size_t, int) {
+         return CachePtr(new ClockProCache<Key, Value>(cap));
+       }},
+      {"CLOCK-Concurrent", [](size_t cap, size_t, int) {
+         return CachePtr(new ConcurrentClockCache<Key, Value>(cap));
+       }},
+      {"LRU-Composed", [](size_t cap, size_t, int) {
+         return CachePtr(new CacheAdapter<Key, Value, Cache<Key, Value>>(cap));
+       }},
+      {"CLOCK-Composed", [](size_t cap, size_t, int) {
+         return CachePtr(new CacheAdapter<Key, Value,
+                                          Cache<Key, Value, ClockPolicy,
+                                                CacheIndexMap, SharedLock>>(cap));
+       }},
+      {"W-TinyLFU", [](size_t cap, size_t, int) {
+         return CachePtr(new WTinyLFUCache<Key, Value>(cap));
+       }},
+      {"LRU-Hash", [](size_t cap, size_t, int slices) {
+         return CachePtr(
+             new CacheAdapter<Key, Value, LRUHashCache<Key, Value>>(cap, slices));
+       }},
+      {"LRU-Hash-NUMA", [](size_t cap, size_t, int slices) {
+         return CachePtr(new CacheAdapter<Key, Value, LRUHashNumaCache<Key, Value>>(
+             cap, slices, NumaRouting::ReplicateHot));
+       }},
+      {"LRU-Hash-Front", [](size_t cap, size_t, int slices) {
+         return CachePtr(new CacheAdapter<Key, Value, LRUHashFrontCache<Key, Value>>(
+             FrontOptions(), cap, slices));
+       }},
+      {"LFU-Hash", [](size_t cap, size_t, int slices) {
+         return CachePtr(
+             new CacheAdapter<Key, Value, LFUHashCache<Key, Value>>(cap, slices));
+       }},
+      {"LFU-Hash-Front", [](size_t cap, size_t, int slices) {
+         return CachePtr(new CacheAdapter<Key, Value, LFUHashFrontCache<Key, Value>>(
+             FrontOptions(), cap, slices));
+       }},
+      {"LFU-Hash-Arena", [](size_t cap, size_t, int slices) {
+         return CachePtr(
+             new CacheAdapter<Key, Value, LFUArenaHashCache<Key, Value>>(cap, slices));
+       }},
+      {"ARC-Hash", [](size_t cap, size_t, int slices) {
+         return CachePtr(new ARCHashCache<Key, Value>(cap, slices));
+       }},
+      {"LRU-K-Hash", [](size_t cap, size_t hist, int slices) {
+         return CachePtr(new LRUKHashCache<Key, Value>(cap, hist, 2, slices));
+       }},
+  };
+}
+
+// 名称在列表中，或列表为空
+inline bool selected(const std::vector<std::string> &names,
+                     const std::string &name) {
+  if (names.empty()) {
+    return true;
+  }
+  for (const std::string &item : names) {
+    if (item == name) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// 按逗号切分参数列表
+inline std::vector<std::string> splitList(const std::string &text) {
+  std::vector<std::string> items;
+  size_t begin = 0;
+  while (begin <= text.size()) {
+    size_t end = text.find(',', begin);
+    if (std::string::npos == end) {
+      end = text.size();
+    }
+    if (end > begin) {
+      items.push_back(text.substr(begin, end - begin));
+    }
+    begin = end + 1;
+  }
+  return items;
+}
+
+} // namespace CacheBench
\ No newline at end of file
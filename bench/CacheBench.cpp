@@ -0,0 +1,351 @@
+/*
+CacheBench:
+多线程吞吐量与延迟基准测试，与只统计单线程命中率的CacheSystem分开构建：
+    1. 每种缓存策略（含Hash分片版本）依次在1、2、4...N个线程下运行，
+       读写比例与访问分布（zipf、hotspot、scan、shift）均可通过参数配置
+    2. 每个线程的访问序列在计时前由固定种子生成，同样的参数两次运行的访问序列完全相同
+    3. 每次操作单独计时，记录到对数线性分桶的延迟直方图（相对误差约3%），
+       汇总后输出吞吐量（ops/s）、命中率与p50/p99/p999延迟
+用法：CacheBench [--threads=8] [--ops=1000000] [--capacity=10000] [--keys=100000]
+               [--reads=95,50] [--dists=zipf,hotspot,scan,shift] [--policies=LRU,LFU]
+               [--slices=0] [--zipf=0.99] [--value-size=8] [--seed=42]
+*/
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BenchPolicies.h"
+
+namespace {
+
+using CacheBench::splitList;
+using Key = int;
+using Value = std::string;
+using Cache = CacheMgr::CacheBase<Key, Value>;
+
+// 测试参数
+struct BenchConfig {
+  int maxThreads = static_cast<int>(std::thread::hardware_concurrency());
+  size_t ops = 1000000;              // 每个线程的操作次数
+  size_t capacity = 10000;           // 缓存容量
+  size_t keys = 100000;              // 关键字空间大小
+  std::vector<int> readPercents = {95, 50};
+  std::vector<std::string> dists = {"zipf", "hotspot", "scan", "shift"};
+  std::vector<std::string> policies; // 为空时运行全部策略
+  int slices = 0;                    // Hash版本的分片数，不大于0时取硬件线程数
+  double zipfTheta = 0.99;           // zipf分布的偏斜程度
+  size_t valueSize = 8;              // 缓存值的字节数
+  uint64_t seed = 42;                // 访问序列的随机种子
+};
+
+// 对数线性分桶的延迟直方图：每个2的幂区间再均分为32个子桶
+class LatencyRecorder {
+public:
+  LatencyRecorder() : counts_(kBucketNum, 0) {}
+
+  void record(uint64_t ns) { ++counts_[bucketOf(ns)]; }
+
+  void merge(const LatencyRecorder &other) {
+    for (size_t idx = 0; idx < kBucketNum; ++idx) {
+      counts_[idx] += other.counts_[idx];
+    }
+  }
+
+  // 分位数对应的延迟（纳秒），取所在子桶的中点
+  double percentile(double ratio) const {
+    uint64_t total = 0;
+    for (uint64_t count : counts_) {
+      total += count;
+    }
+    if (0 == total) {
+      return 0.0;
+    }
+    uint64_t rank = static_cast<uint64_t>(std::ceil(ratio * total));
+    uint64_t seen = 0;
+    for (size_t idx = 0; idx < kBucketNum; ++idx) {
+      seen += counts_[idx];
+      if (seen >= rank && 0 != counts_[idx]) {
+        return 0.5 * (lowerOf(idx) + lowerOf(idx + 1));
+      }
+    }
+    return lowerOf(kBucketNum);
+  }
+
+private:
+  static constexpr uint32_t kSubBits = 5;
+  static constexpr uint64_t kSubNum = 1u << kSubBits;
+  static constexpr size_t kBucketNum = (64 - kSubBits + 1) * kSubNum;
+
+  // 小于32纳秒的值每纳秒一个桶，之后每个2的幂区间32个桶
+  static size_t bucketOf(uint64_t ns) {
+    if (ns < kSubNum) {
+      return static_cast<size_t>(ns);
+    }
+    uint32_t exponent = CacheMgr::detail::highestBit(ns);
+    uint64_t sub = (ns >> (exponent - kSubBits)) & (kSubNum - 1);
+    return static_cast<size_t>((exponent - kSubBits + 1) * kSubNum + sub);
+  }
+
+  // 桶的下界
+  static double lowerOf(size_t bucket) {
+    if (bucket < kSubNum) {
+      return static_cast<double>(bucket);
+    }
+    uint32_t exponent = static_cast<uint32_t>(bucket / kSubNum) + kSubBits - 1;
+    uint64_t sub = bucket % kSubNum;
+    return std::ldexp(static_cast<double>(kSubNum + sub),
+                      static_cast<int>(exponent - kSubBits));
+  }
+
+private:
+  std::vector<uint64_t> counts_;
+};
+
+// 把排名打散到整个关键字空间，避免热点关键字集中在同一个分片
+Key scatter(uint64_t rank, size_t keys) {
+  return static_cast<Key>((rank * 2654435761ull) % keys);
+}
+
+// zipf分布的排名生成器，按累积分布表二分查找
+class ZipfGenerator {
+public:
+  ZipfGenerator(size_t keys, double theta) : cdf_(keys) {
+    double sum = 0.0;
+    for (size_t rank = 0; rank < keys; ++rank) {
+      sum += 1.0 / std::pow(static_cast<double>(rank + 1), theta);
+      cdf_[rank] = sum;
+    }
+    for (double &value : cdf_) {
+      value /= sum;
+    }
+  }
+
+  template <typename Gen> uint64_t next(Gen &gen) const {
+    double point = std::uniform_real_distribution<double>(0.0, 1.0)(gen);
+    auto it = std::lower_bound(cdf_.begin(), cdf_.end(), point);
+    return std::min<uint64_t>(it - cdf_.begin(), cdf_.size() - 1);
+  }
+
+private:
+  std::vector<double> cdf_;
+};
+
+// 访问序列中的一次操作，最高位表示写入
+constexpr uint32_t kPutFlag = 1u << 31;
+
+// 按分布生成一个线程的访问序列
+//   zipf：排名服从zipf分布
+//   hotspot：20%的关键字承担80%的访问
+//   scan：zipf访问中穿插顺序扫描，每10段中有1段是连续关键字
+//   shift：zipf访问的热点每过1/4的操作整体平移一次
+std::vector<uint32_t> makeStream(const BenchConfig &config,
+                                 const ZipfGenerator &zipf,
+                                 const std::string &dist, int readPercent,
+                                 int thread) {
+  std::mt19937_64 gen(config.seed * 1000003 + static_cast<uint64_t>(thread));
+  std::uniform_int_distribution<int> percent(0, 99);
+  std::uniform_int_distribution<uint64_t> anyKey(0, config.keys - 1);
+  const size_t hotKeys = std::max<size_t>(1, config.keys / 5);
+  const size_t segment = 1000;
+  uint64_t cursor = anyKey(gen);
+
+  std::vector<uint32_t> stream(config.ops);
+  for (size_t op = 0; op < config.ops; ++op) {
+    uint64_t rank;
+    if ("hotspot" == dist) {
+      rank = percent(gen) < 80 ? anyKey(gen) % hotKeys
+                               : hotKeys + anyKey(gen) % (config.keys - hotKeys);
+    } else if ("scan" == dist && 9 == (op / segment) % 10) {
+      rank = cursor++ % config.keys;
+    } else if ("shift" == dist) {
+      uint64_t phase = op * 4 / config.ops;
+      rank = (zipf.next(gen) + phase * config.keys / 4) % config.keys;
+    } else {
+      rank = zipf.next(gen);
+    }
+    uint32_t key = static_cast<uint32_t>(scatter(rank, config.keys));
+    stream[op] = percent(gen) < readPercent ? key : key | kPutFlag;
+  }
+  return stream;
+}
+
+struct RunResult {
+  double opsPerSec = 0.0;
+  double hitRate = 0.0;
+  LatencyRecorder latency;
+};
+
+// 多个线程同时回放各自的访问序列
+RunResult runOnce(Cache &cache, const std::vector<std::vector<uint32_t>> &streams,
+                  const Value &value) {
+  using Clock = std::chrono::steady_clock;
+  const size_t threadNum = streams.size();
+  std::vector<LatencyRecorder> latencies(threadNum);
+  std::vector<uint64_t> hits(threadNum, 0), gets(threadNum, 0);
+  std::atomic<size_t> ready{0};
+  std::atomic<bool> start{false};
+
+  std::vector<std::thread> workers;
+  for (size_t thread = 0; thread < threadNum; ++thread) {
+    workers.emplace_back([&, thread] {
+      LatencyRecorder &latency = latencies[thread];
+      Value result;
+      ready.fetch_add(1);
+      while (!start.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+      }
+      for (uint32_t op : streams[thread]) {
+        Key key = static_cast<Key>(op & ~kPutFlag);
+        Clock::time_point begin = Clock::now();
+        if (op & kPutFlag) {
+          cache.put(key, value);
+        } else {
+          ++gets[thread];
+          hits[thread] += cache.get(key, result) ? 1 : 0;
+        }
+        latency.record(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() -
+                                                                 begin)
+                .count()));
+      }
+    });
+  }
+  while (ready.load() != threadNum) {
+    std::this_thread::yield();
+  }
+  Clock::time_point begin = Clock::now();
+  start.store(true, std::memory_order_release);
+  for (std::thread &worker : workers) {
+    worker.join();
+  }
+  double seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+
+  RunResult result;
+  uint64_t totalOps = 0, totalHits = 0, totalGets = 0;
+  for (size_t thread = 0; thread < threadNum; ++thread) {
+    totalOps += streams[thread].size();
+    totalHits += hits[thread];
+    totalGets += gets[thread];
+    result.latency.merge(latencies[thread]);
+  }
+  result.opsPerSec = seconds > 0 ? totalOps / seconds : 0.0;
+  result.hitRate = totalGets > 0 ? 100.0 * totalHits / totalGets : 0.0;
+  return result;
+}
+
+bool parseArgs(int argc, char **argv, BenchConfig &config) {
+  for (int idx = 1; idx < argc; ++idx) {
+    std::string arg = argv[idx];
+    size_t eq = arg.find('=');
+    std::string name = arg.substr(0, eq);
+    std::string value = std::string::npos == eq ? "" : arg.substr(eq + 1);
+    if ("--threads" == name) {
+      config.maxThreads = std::max(1, std::atoi(value.c_str()));
+    } else if ("--ops" == name) {
+      config.ops = std::strtoull(value.c_str(), nullptr, 10);
+    } else if ("--capacity" == name) {
+      config.capacity = std::strtoull(value.c_str(), nullptr, 10);
+    } else if ("--keys" == name) {
+      config.keys = std::max<size_t>(2, std::strtoull(value.c_str(), nullptr, 10));
+    } else if ("--reads" == name) {
+      config.readPercents.clear();
+      for (const std::string &item : splitList(value)) {
+        config.readPercents.push_back(std::min(100, std::max(0, std::atoi(item.c_str()))));
+      }
+    } else if ("--dists" == name) {
+      config.dists = splitList(value);
+    } else if ("--policies" == name) {
+      config.policies = splitList(value);
+    } else if ("--slices" == name) {
+      config.slices = std::atoi(value.c_str());
+    } else if ("--zipf" == name) {
+      config.zipfTheta = std::atof(value.c_str());
+    } else if ("--value-size" == name) {
+      config.valueSize = std::strtoull(value.c_str(), nullptr, 10);
+    } else if ("--seed" == name) {
+      config.seed = std::strtoull(value.c_str(), nullptr, 10);
+    } else {
+      std::printf("用法: %s [--threads=N] [--ops=N] [--capacity=N] [--keys=N]\n"
+                  "       [--reads=95,50] [--dists=zipf,hotspot,scan,shift]\n"
+                  "       [--policies=LRU,LFU-Hash,...] [--slices=N] [--zipf=0.99]\n"
+                  "       [--value-size=N] [--seed=N]\n",
+                  argv[0]);
+      return false;
+    }
+  }
+  if (config.maxThreads <= 0) {
+    config.maxThreads = 1;
+  }
+  return true;
+}
+
+// 线程数依次取1、2、4...，最后一档为最大线程数
+std::vector<int> threadSteps(int maxThreads) {
+  std::vector<int> steps;
+  for (int threads = 1; threads < maxThreads; threads <<= 1) {
+    steps.push_back(threads);
+  }
+  steps.push_back(maxThreads);
+  return steps;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  BenchConfig config;
+  if (!parseArgs(argc, argv, config)) {
+    return 1;
+  }
+  int slices = config.slices > 0
+                   ? config.slices
+                   : static_cast<int>(std::thread::hardware_concurrency());
+  std::printf("容量 %zu, 关键字 %zu, 每线程操作 %zu, 分片 %d, zipf %.2f, 种子 %llu\n\n",
+              config.capacity, config.keys, config.ops, slices, config.zipfTheta,
+              static_cast<unsigned long long>(config.seed));
+  std::printf("%-14s %-8s %6s %8s %12s %8s %9s %9s %9s\n", "policy", "dist", "read%",
+              "threads", "ops/s", "hit%", "p50(ns)", "p99(ns)", "p999(ns)");
+
+  ZipfGenerator zipf(config.keys, config.zipfTheta);
+  const Value value(config.valueSize, 'v');
+  std::vector<CacheBench::Policy<Key, Value>> policies =
+      CacheBench::allPolicies<Key, Value>();
+  for (const std::string &dist : config.dists) {
+    for (int readPercent : config.readPercents) {
+      for (int threads : threadSteps(config.maxThreads)) {
+        std::vector<std::vector<uint32_t>> streams;
+        for (int thread = 0; thread < threads; ++thread) {
+          streams.push_back(makeStream(config, zipf, dist, readPercent, thread));
+        }
+        for (const auto &policy : policies) {
+          if (!CacheBench::selected(config.policies, policy.name)) {
+            continue;
+          }
+          std::unique_ptr<Cache> cache =
+              policy.make(config.capacity, config.keys, slices);
+          // 预热：按第一个线程的访问序列写入，计时前让缓存达到稳定状态
+          size_t warmup = std::min(streams[0].size(), 2 * config.capacity);
+          for (size_t op = 0; op < warmup; ++op) {
+            cache->put(static_cast<Key>(streams[0][op] & ~kPutFlag), value);
+          }
+          RunResult result = runOnce(*cache, streams, value);
+          std::printf("%-14s %-8s %6d %8d %12.0f %8.2f %9.0f %9.0f %9.0f\n",
+                      policy.name.c_str(), dist.c_str(), readPercent, threads,
+                      result.opsPerSec, result.hitRate,
+                      result.latency.percentile(0.50),
+                      result.latency.percentile(0.99),
+                      result.latency.percentile(0.999));
+        }
+      }
+    }
+  }
+  return 0;
+}
\ No newline at end of file
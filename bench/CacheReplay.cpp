@@ -0,0 +1,381 @@
+/*
+CacheReplay:
+按真实访问轨迹回放，输出各缓存策略的命中率-容量曲线：
+    1. 轨迹文件以mmap只读映射，回放时直接在映射区上解析，不复制到堆内存
+    2. 支持的格式：
+         bin64 / bin32：小端的64位 / 32位关键字数组，每个关键字一次请求
+         arc：ARC论文轨迹，每行"起始块 块数 忽略 请求号"，展开为连续块号的请求
+         lirs：LIRS轨迹，每行一个块号，非数字行跳过
+         twitter：Twitter缓存轨迹CSV，第2列为关键字，按FNV-1a哈希为64位关键字
+       文本格式可用--save-bin一次转换为bin64，之后的回放不再解析文本
+    3. 每个(策略, 容量)是一个独立任务，任务之间不共享任何缓存状态，
+       由--jobs个线程并行领取；每个请求先get，未命中时put，即按需填充
+用法：CacheReplay --trace=文件 [--format=bin64] [--capacities=1000,10000,100000]
+                 [--policies=LRU,ARC-Canonical] [--jobs=N] [--slices=1] [--limit=N]
+                 [--save-bin=文件]
+*/
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BenchPolicies.h"
+
+namespace {
+
+using Key = uint64_t;
+using Value = uint32_t;
+
+// 回放参数
+struct ReplayConfig {
+  std::string trace;                // 轨迹文件
+  std::string format = "bin64";     // 轨迹格式
+  std::vector<size_t> capacities = {1000, 10000, 100000};
+  std::vector<std::string> policies; // 为空时回放全部策略
+  int jobs = static_cast<int>(std::thread::hardware_concurrency());
+  int slices = 1;                   // Hash版本的分片数
+  uint64_t limit = UINT64_MAX;      // 最多回放的请求数
+  std::string saveBin;              // 转换为bin64的输出文件
+};
+
+// 只读映射的轨迹文件
+class MappedFile {
+public:
+  explicit MappedFile(const std::string &path) : data_(nullptr), size_(0) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return;
+    }
+    struct stat st;
+    if (0 == ::fstat(fd, &st) && st.st_size > 0) {
+      void *addr = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ,
+                          MAP_PRIVATE, fd, 0);
+      if (MAP_FAILED != addr) {
+        data_ = static_cast<const char *>(addr);
+        size_ = static_cast<size_t>(st.st_size);
+        // 回放按顺序读取，提示内核提前预读
+        ::madvise(addr, size_, MADV_SEQUENTIAL);
+      }
+    }
+    ::close(fd);
+  }
+
+  ~MappedFile() {
+    if (nullptr != data_) {
+      ::munmap(const_cast<char *>(data_), size_);
+    }
+  }
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  bool valid() const { return nullptr != data_; }
+  const char *data() const { return data_; }
+  size_t size() const { return size_; }
+
+private:
+  const char *data_; // 映射区起始地址
+  size_t size_;      // 文件字节数
+};
+
+// 解析一个无符号十进制整数，pos停在数字之后
+bool parseNumber(const char *data, size_t end, size_t &pos, uint64_t &value) {
+  while (pos < end && (' ' == data[pos] || '\t' == data[pos])) {
+    ++pos;
+  }
+  if (pos >= end || data[pos] < '0' || data[pos] > '9') {
+    return false;
+  }
+  value = 0;
+  while (pos < end && data[pos] >= '0' && data[pos] <= '9') {
+    value = value * 10 + static_cast<uint64_t>(data[pos] - '0');
+    ++pos;
+  }
+  return true;
+}
+
+// 字符串关键字的64位FNV-1a哈希
+uint64_t hashKey(const char *data, size_t len) {
+  uint64_t hash = 14695981039346656037ull;
+  for (size_t idx = 0; idx < len; ++idx) {
+    hash ^= static_cast<unsigned char>(data[idx]);
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+// 按行遍历文本，onLine(行首, 行尾)
+template <typename F> void forEachLine(const MappedFile &file, F &&onLine) {
+  const char *data = file.data();
+  size_t pos = 0;
+  while (pos < file.size()) {
+    const void *found = std::memchr(data + pos, '\n', file.size() - pos);
+    size_t end = nullptr != found
+                     ? static_cast<size_t>(static_cast<const char *>(found) - data)
+                     : file.size();
+    if (!onLine(pos, end)) {
+      return;
+    }
+    pos = end + 1;
+  }
+}
+
+// 按格式遍历轨迹中的请求，onKey返回false时提前结束；格式不支持时返回false
+template <typename F>
+bool forEachKey(const MappedFile &file, const std::string &format,
+                uint64_t limit, F &&onKey) {
+  uint64_t count = 0;
+  const char *data = file.data();
+  if ("bin64" == format || "bin32" == format) {
+    size_t width = "bin64" == format ? sizeof(uint64_t) : sizeof(uint32_t);
+    size_t num = file.size() / width;
+    for (size_t idx = 0; idx < num && count < limit; ++idx, ++count) {
+      Key key = 0;
+      std::memcpy(&key, data + idx * width, width);
+      onKey(key);
+    }
+    return true;
+  }
+  if ("arc" == format) {
+    forEachLine(file, [&](size_t pos, size_t end) {
+      uint64_t start, blocks;
+      if (parseNumber(data, end, pos, start) &&
+          parseNumber(data, end, pos, blocks)) {
+        for (uint64_t block = 0; block < blocks; ++block) {
+          if (count++ >= limit) {
+            return false;
+          }
+          onKey(start + block);
+        }
+      }
+      return count < limit;
+    });
+    return true;
+  }
+  if ("lirs" == format) {
+    forEachLine(file, [&](size_t pos, size_t end) {
+      uint64_t block;
+      if (parseNumber(data, end, pos, block)) {
+        onKey(block);
+        ++count;
+      }
+      return count < limit;
+    });
+    return true;
+  }
+  if ("twitter" == format) {
+    // timestamp,key,key size,value size,client id,operation,TTL
+    forEachLine(file, [&](size_t pos, size_t end) {
+      const void *comma = std::memchr(data + pos, ',', end - pos);
+      if (nullptr == comma) {
+        return true;
+      }
+      size_t keyBegin = static_cast<size_t>(static_cast<const char *>(comma) - data) + 1;
+      const void *next = std::memchr(data + keyBegin, ',', end - keyBegin);
+      size_t keyEnd = nullptr != next
+                          ? static_cast<size_t>(static_cast<const char *>(next) - data)
+                          : end;
+      onKey(hashKey(data + keyBegin, keyEnd - keyBegin));
+      ++count;
+      return count < limit;
+    });
+    return true;
+  }
+  return false;
+}
+
+// 一个(策略, 容量)回放任务
+struct ReplayTask {
+  size_t policy;       // 策略下标
+  size_t capacity;     // 缓存容量
+  uint64_t requests;   // 请求数
+  uint64_t hits;       // 命中数
+  double seconds;      // 回放耗时
+};
+
+bool parseArgs(int argc, char **argv, ReplayConfig &config) {
+  for (int idx = 1; idx < argc; ++idx) {
+    std::string arg = argv[idx];
+    size_t eq = arg.find('=');
+    std::string name = arg.substr(0, eq);
+    std::string value = std::string::npos == eq ? "" : arg.substr(eq + 1);
+    if ("--trace" == name) {
+      config.trace = value;
+    } else if ("--format" == name) {
+      config.format = value;
+    } else if ("--capacities" == name) {
+      config.capacities.clear();
+      for (const std::string &item : CacheBench::splitList(value)) {
+        size_t capacity = std::strtoull(item.c_str(), nullptr, 10);
+        if (capacity > 0) {
+          config.capacities.push_back(capacity);
+        }
+      }
+    } else if ("--policies" == name) {
+      config.policies = CacheBench::splitList(value);
+    } else if ("--jobs" == name) {
+      config.jobs = std::atoi(value.c_str());
+    } else if ("--slices" == name) {
+      config.slices = std::atoi(value.c_str());
+    } else if ("--limit" == name) {
+      config.limit = std::strtoull(value.c_str(), nullptr, 10);
+    } else if ("--save-bin" == name) {
+      config.saveBin = value;
+    } else {
+      config.trace.clear();
+      break;
+    }
+  }
+  if (config.trace.empty() || config.capacities.empty()) {
+    std::printf("用法: %s --trace=文件 [--format=bin64|bin32|arc|lirs|twitter]\n"
+                "       [--capacities=1000,10000] [--policies=LRU,ARC-Canonical]\n"
+                "       [--jobs=N] [--slices=N] [--limit=N] [--save-bin=文件]\n",
+                argv[0]);
+    return false;
+  }
+  if (config.jobs <= 0) {
+    config.jobs = 1;
+  }
+  return true;
+}
+
+// 把轨迹转换为bin64，返回写入的请求数
+int saveBin(const MappedFile &file, const ReplayConfig &config) {
+  FILE *out = std::fopen(config.saveBin.c_str(), "wb");
+  if (nullptr == out) {
+    std::printf("无法写入 %s\n", config.saveBin.c_str());
+    return 1;
+  }
+  std::vector<Key> buffer;
+  buffer.reserve(1 << 16);
+  uint64_t count = 0;
+  bool ok = forEachKey(file, config.format, config.limit, [&](Key key) {
+    buffer.push_back(key);
+    if (buffer.size() == buffer.capacity()) {
+      std::fwrite(buffer.data(), sizeof(Key), buffer.size(), out);
+      buffer.clear();
+    }
+    ++count;
+  });
+  std::fwrite(buffer.data(), sizeof(Key), buffer.size(), out);
+  std::fclose(out);
+  if (!ok) {
+    std::printf("不支持的格式 %s\n", config.format.c_str());
+    return 1;
+  }
+  std::printf("已写入 %llu 个请求到 %s\n", static_cast<unsigned long long>(count),
+              config.saveBin.c_str());
+  return 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  ReplayConfig config;
+  if (!parseArgs(argc, argv, config)) {
+    return 1;
+  }
+  MappedFile file(config.trace);
+  if (!file.valid()) {
+    std::printf("无法映射轨迹文件 %s\n", config.trace.c_str());
+    return 1;
+  }
+  if (!config.saveBin.empty()) {
+    return saveBin(file, config);
+  }
+
+  std::vector<CacheBench::Policy<Key, Value>> policies;
+  for (auto &policy : CacheBench::allPolicies<Key, Value>()) {
+    if (CacheBench::selected(config.policies, policy.name)) {
+      policies.push_back(std::move(policy));
+    }
+  }
+  std::vector<ReplayTask> tasks;
+  for (size_t capacity : config.capacities) {
+    for (size_t policy = 0; policy < policies.size(); ++policy) {
+      tasks.push_back({policy, capacity, 0, 0, 0.0});
+    }
+  }
+
+  // 每个任务各自构造缓存并完整回放一遍轨迹，线程之间只共享只读的映射区
+  std::atomic<size_t> nextTask{0};
+  std::atomic<bool> badFormat{false};
+  std::vector<std::thread> workers;
+  int jobs = std::min<int>(config.jobs, static_cast<int>(tasks.size()));
+  for (int job = 0; job < jobs; ++job) {
+    workers.emplace_back([&] {
+      for (size_t idx = nextTask.fetch_add(1); idx < tasks.size();
+           idx = nextTask.fetch_add(1)) {
+        ReplayTask &task = tasks[idx];
+        auto cache =
+            policies[task.policy].make(task.capacity, 2 * task.capacity, config.slices);
+        auto begin = std::chrono::steady_clock::now();
+        Value val;
+        bool ok = forEachKey(file, config.format, config.limit, [&](Key key) {
+          ++task.requests;
+          if (cache->get(key, val)) {
+            ++task.hits;
+          } else {
+            cache->put(key, 1);
+          }
+        });
+        if (!ok) {
+          badFormat = true;
+          return;
+        }
+        task.seconds = std::chrono::duration<double>(
+                           std::chrono::steady_clock::now() - begin)
+                           .count();
+      }
+    });
+  }
+  for (std::thread &worker : workers) {
+    worker.join();
+  }
+  if (badFormat) {
+    std::printf("不支持的格式 %s\n", config.format.c_str());
+    return 1;
+  }
+
+  // 每行一个容量，每列一个策略，同一列自上而下即该策略的命中率-容量曲线
+  std::printf("轨迹 %s, 格式 %s, 请求数 %llu\n\n", config.trace.c_str(),
+              config.format.c_str(),
+              tasks.empty() ? 0ull
+                            : static_cast<unsigned long long>(tasks[0].requests));
+  std::printf("%10s", "capacity");
+  for (const auto &policy : policies) {
+    std::printf(" %14s", policy.name.c_str());
+  }
+  std::printf("\n");
+  for (size_t row = 0; row < config.capacities.size(); ++row) {
+    std::printf("%10zu", config.capacities[row]);
+    for (size_t col = 0; col < policies.size(); ++col) {
+      const ReplayTask &task = tasks[row * policies.size() + col];
+      std::printf(" %13.2f%%",
+                  task.requests > 0 ? 100.0 * task.hits / task.requests : 0.0);
+    }
+    std::printf("\n");
+  }
+  // 回放速度，用于估计更大轨迹所需的时间
+  std::printf("\n%10s", "Mreq/s");
+  for (size_t col = 0; col < policies.size(); ++col) {
+    double requests = 0, seconds = 0;
+    for (size_t row = 0; row < config.capacities.size(); ++row) {
+      requests += tasks[row * policies.size() + col].requests;
+      seconds += tasks[row * policies.size() + col].seconds;
+    }
+    std::printf(" %14.2f", seconds > 0 ? requests / seconds / 1e6 : 0.0);
+  }
+  std::printf("\n");
+  return 0;
+}
\ No newline at end of file
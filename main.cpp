@@ -1,20 +1,38 @@
 #include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <iomanip>
 #include <iostream>
+#include <memory>
 #include <random>
 #include <string>
 #include <vector>
 #include <array>
+#include <atomic>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <thread>
 
 #include "CacheBase.h"
 #include "CacheARC.h"
+#include "CacheARCCanonical.h"
+#include "CacheARCHash.h"
+#include "CacheCLOCK.h"
+#include "CacheCLOCKConcurrent.h"
+#include "CacheCLOCKPro.h"
+#include "CacheCompose.h"
 #include "CacheLFU.h"
 #include "CacheLFUHash.h"
 #include "CacheLFUAvg.h"
 #include "CacheLRU.h"
 #include "CacheLRUHash.h"
 #include "CacheLRUK.h"
+#include "CacheLRUKHash.h"
+#include "CachePipeline.h"
+#include "CacheSharded.h"
+#include "CacheTiered.h"
+#include "CacheWTinyLFU.h"
 
 class Timer {
 public:
@@ -47,6 +65,10 @@ void printResults(const std::string &testName, int capacity,
     names = {"LRU", "LFU", "ARC", "LRU-K", "LFU-Aging"};
   } else if (hits.size() == 7) {
     names = {"LRU", "LFU", "ARC", "LRU-K", "LFU-Aging", "LRU-Hash", "LFU-Hash"};
+  } else if (hits.size() == 13) {
+    names = {"LRU",       "LFU",       "ARC",           "LRU-K",    "LFU-Aging",
+             "CLOCK",     "CLOCK-Pro", "W-TinyLFU",     "ARC-Canonical",
+             "ARC-Hash",  "LRU-K-Hash", "LRU-Hash",     "LFU-Hash"};
   } else {
     names.resize(hits.size());
     for (size_t i = 0; i < hits.size(); ++i) {
@@ -83,7 +105,14 @@ void testHotDataAccess() {
   // - 历史记录容量设为可能访问的所有键数量
   // - k=2表示数据被访问2次后才会进入缓存，适合区分热点和冷数据
   CacheMgr::LRUKCache<int, std::string> lruk(CAPACITY, HOT_KEYS + COLD_KEYS, 2);
+  CacheMgr::LRUKHashCache<int, std::string> lrukHash(
+      CAPACITY, HOT_KEYS + COLD_KEYS, 2, 2);
   CacheMgr::LFUAvgCache<int, std::string> lfuAging(CAPACITY, 20000);
+  CacheMgr::ClockCache<int, std::string> clock(CAPACITY);
+  CacheMgr::ClockProCache<int, std::string> clockPro(CAPACITY);
+  CacheMgr::WTinyLFUCache<int, std::string> tinyLfu(CAPACITY);
+  CacheMgr::ARCCanonicalCache<int, std::string> arcCanonical(CAPACITY);
+  CacheMgr::ARCHashCache<int, std::string> arcHash(CAPACITY, 2);
 
   CacheMgr::LRUHashCache<int, std::string> lruHash(CAPACITY, 2);
   CacheMgr::LFUHashCache<int, std::string> lfuHash(CAPACITY, 2, 10000);
@@ -91,21 +120,25 @@ void testHotDataAccess() {
   std::random_device rd;
   std::mt19937 gen(rd());
 
-  // 基类指针指向派生类对象，添加LFU-Aging
-  std::array<CacheMgr::CacheBase<int, std::string> *, 5> caches = {
-      &lru, &lfu, &arc, &lruk, &lfuAging};
-  std::vector<int> hits(7, 0);
-  std::vector<int> get_operations(7, 0);
-  std::vector<std::string> names = {"LRU", "LFU", "ARC", "LRU-K", "LFU-Aging", "LRU-Hash", "LFU-Hash"};
+  // 基类指针指向派生类对象，添加LFU-Aging、CLOCK、CLOCK-Pro、W-TinyLFU、ARC-Canonical与分片的ARC、LRU-K
+  std::array<CacheMgr::CacheBase<int, std::string> *, 11> caches = {
+      &lru,   &lfu,      &arc,     &lruk,         &lfuAging, &clock,
+      &clockPro, &tinyLfu, &arcCanonical, &arcHash, &lrukHash};
+  std::vector<int> hits(13, 0);
+  std::vector<int> get_operations(13, 0);
+  std::vector<std::string> names = {
+      "LRU",       "LFU",       "ARC",           "LRU-K",    "LFU-Aging", "CLOCK",
+      "CLOCK-Pro", "W-TinyLFU", "ARC-Canonical", "ARC-Hash", "LRU-K-Hash",
+      "LRU-Hash",  "LFU-Hash"};
 
   // 为所有的缓存对象进行相同的操作序列测试
   for (int idx = 0; idx < hits.size(); ++idx) {
     // 先预热缓存，插入一些数据
     for (int key = 0; key < HOT_KEYS; ++key) {
       std::string value = "value" + std::to_string(key);
-      if (idx < 5) // 前5个缓存算法
+      if (idx < 11) // 前11个缓存算法
         caches[idx]->put(key, value);
-      else if (idx == 5) // LRU-Hash
+      else if (idx == 11) // LRU-Hash
         lruHash.put(key, value);
       else // LFU-Hash
         lfuHash.put(key, value);
@@ -129,9 +162,9 @@ void testHotDataAccess() {
         // 执行put操作
         std::string value =
             "value" + std::to_string(key) + "_v" + std::to_string(op % 100);
-        if (idx < 5) // 前5个缓存算法
+        if (idx < 11) // 前11个缓存算法
           caches[idx]->put(key, value);
-        else if (idx == 5) // LRU-Hash
+        else if (idx == 11) // LRU-Hash
           lruHash.put(key, value);
         else // LFU-Hash
           lfuHash.put(key, value);
@@ -139,11 +172,11 @@ void testHotDataAccess() {
         // 执行get操作并记录命中情况
         std::string result;
         get_operations[idx]++;
-        if (idx < 5) { // 前5个缓存算法
+        if (idx < 11) { // 前11个缓存算法
           if (caches[idx]->get(key, result)) {
             hits[idx]++;
           }
-        } else if (idx == 5) { // LRU-Hash
+        } else if (idx == 11) { // LRU-Hash
           if (lruHash.get(key, result)) {
             hits[idx]++;
           }
@@ -174,16 +207,27 @@ void testLoopPattern() {
   // - 历史记录容量设为总循环大小的两倍，覆盖范围内和范围外的数据
   // - k=2，对于循环访问，这是一个合理的阈值
   CacheMgr::LRUKCache<int, std::string> lruk(CAPACITY, LOOP_SIZE * 2, 2);
+  CacheMgr::LRUKHashCache<int, std::string> lrukHash(CAPACITY, LOOP_SIZE * 2,
+                                                     2, 2);
   CacheMgr::LFUAvgCache<int, std::string> lfuAging(CAPACITY, 3000);
+  CacheMgr::ClockCache<int, std::string> clock(CAPACITY);
+  CacheMgr::ClockProCache<int, std::string> clockPro(CAPACITY);
+  CacheMgr::WTinyLFUCache<int, std::string> tinyLfu(CAPACITY);
+  CacheMgr::ARCCanonicalCache<int, std::string> arcCanonical(CAPACITY);
+  CacheMgr::ARCHashCache<int, std::string> arcHash(CAPACITY, 2);
 
   CacheMgr::LRUHashCache<int, std::string> lruHash(CAPACITY, 2);
   CacheMgr::LFUHashCache<int, std::string> lfuHash(CAPACITY, 2, 1500);
 
-  std::array<CacheMgr::CacheBase<int, std::string> *, 5> caches = {
-      &lru, &lfu, &arc, &lruk, &lfuAging};
-  std::vector<int> hits(7, 0);
-  std::vector<int> get_operations(7, 0);
-  std::vector<std::string> names = {"LRU", "LFU", "ARC", "LRU-K", "LFU-Aging", "LRU-Hash", "LFU-Hash"};
+  std::array<CacheMgr::CacheBase<int, std::string> *, 11> caches = {
+      &lru,   &lfu,      &arc,     &lruk,         &lfuAging, &clock,
+      &clockPro, &tinyLfu, &arcCanonical, &arcHash, &lrukHash};
+  std::vector<int> hits(13, 0);
+  std::vector<int> get_operations(13, 0);
+  std::vector<std::string> names = {
+      "LRU",       "LFU",       "ARC",           "LRU-K",    "LFU-Aging", "CLOCK",
+      "CLOCK-Pro", "W-TinyLFU", "ARC-Canonical", "ARC-Hash", "LRU-K-Hash",
+      "LRU-Hash",  "LFU-Hash"};
 
   std::random_device rd;
   std::mt19937 gen(rd());
@@ -193,9 +237,9 @@ void testLoopPattern() {
     // 先预热一部分数据（只加载20%的数据）
     for (int key = 0; key < LOOP_SIZE / 5; ++key) {
       std::string value = "loop" + std::to_string(key);
-      if (idx < 5) // 前5个缓存算法
+      if (idx < 11) // 前11个缓存算法
         caches[idx]->put(key, value);
-      else if (idx == 5) // LRU-Hash
+      else if (idx == 11) // LRU-Hash
         lruHash.put(key, value);
       else // LFU-Hash
         lfuHash.put(key, value);
@@ -224,9 +268,9 @@ void testLoopPattern() {
         // 执行put操作，更新数据
         std::string value =
             "loop" + std::to_string(key) + "_v" + std::to_string(op % 100);
-        if (idx < 5) // 前5个缓存算法
+        if (idx < 11) // 前11个缓存算法
           caches[idx]->put(key, value);
-        else if (idx == 5) // LRU-Hash
+        else if (idx == 11) // LRU-Hash
           lruHash.put(key, value);
         else // LFU-Hash
           lfuHash.put(key, value);
@@ -234,11 +278,11 @@ void testLoopPattern() {
         // 执行get操作并记录命中情况
         std::string result;
         get_operations[idx]++;
-        if (idx < 5) { // 前5个缓存算法
+        if (idx < 11) { // 前11个缓存算法
           if (caches[idx]->get(key, result)) {
             hits[idx]++;
           }
-        } else if (idx == 5) { // LRU-Hash
+        } else if (idx == 11) { // LRU-Hash
           if (lruHash.get(key, result)) {
             hits[idx]++;
           }
@@ -265,27 +309,37 @@ void testWorkloadShift() {
   CacheMgr::LFUCache<int, std::string> lfu(CAPACITY);
   CacheMgr::ARCCache<int, std::string> arc(CAPACITY);
   CacheMgr::LRUKCache<int, std::string> lruk(CAPACITY, 500, 2);
+  CacheMgr::LRUKHashCache<int, std::string> lrukHash(CAPACITY, 500, 2, 2);
   CacheMgr::LFUAvgCache<int, std::string> lfuAging(CAPACITY, 10000);
+  CacheMgr::ClockCache<int, std::string> clock(CAPACITY);
+  CacheMgr::ClockProCache<int, std::string> clockPro(CAPACITY);
+  CacheMgr::WTinyLFUCache<int, std::string> tinyLfu(CAPACITY);
+  CacheMgr::ARCCanonicalCache<int, std::string> arcCanonical(CAPACITY);
+  CacheMgr::ARCHashCache<int, std::string> arcHash(CAPACITY, 2);
 
   CacheMgr::LRUHashCache<int, std::string> lruHash(CAPACITY, 2);
   CacheMgr::LFUHashCache<int, std::string> lfuHash(CAPACITY, 2, 5000);
 
   std::random_device rd;
   std::mt19937 gen(rd());
-  std::array<CacheMgr::CacheBase<int, std::string> *, 5> caches = {
-      &lru, &lfu, &arc, &lruk, &lfuAging};
-  std::vector<int> hits(7, 0);
-  std::vector<int> get_operations(7, 0);
-  std::vector<std::string> names = {"LRU", "LFU", "ARC", "LRU-K", "LFU-Aging", "LRU-Hash", "LFU-Hash"};
+  std::array<CacheMgr::CacheBase<int, std::string> *, 11> caches = {
+      &lru,   &lfu,      &arc,     &lruk,         &lfuAging, &clock,
+      &clockPro, &tinyLfu, &arcCanonical, &arcHash, &lrukHash};
+  std::vector<int> hits(13, 0);
+  std::vector<int> get_operations(13, 0);
+  std::vector<std::string> names = {
+      "LRU",       "LFU",       "ARC",           "LRU-K",    "LFU-Aging", "CLOCK",
+      "CLOCK-Pro", "W-TinyLFU", "ARC-Canonical", "ARC-Hash", "LRU-K-Hash",
+      "LRU-Hash",  "LFU-Hash"};
 
   // 为每种缓存算法运行相同的测试
   for (int idx = 0; idx < hits.size(); ++idx) {
     // 先预热缓存，只插入少量初始数据
     for (int key = 0; key < 30; ++key) {
       std::string value = "init" + std::to_string(key);
-      if (idx < 5) // 前5个缓存算法
+      if (idx < 11) // 前11个缓存算法
         caches[idx]->put(key, value);
-      else if (idx == 5) // LRU-Hash
+      else if (idx == 11) // LRU-Hash
         lruHash.put(key, value);
       else // LFU-Hash
         lfuHash.put(key, value);
@@ -351,9 +405,9 @@ void testWorkloadShift() {
         // 执行写操作
         std::string value =
             "value" + std::to_string(key) + "_p" + std::to_string(phase);
-        if (idx < 5) // 前5个缓存算法
+        if (idx < 11) // 前11个缓存算法
           caches[idx]->put(key, value);
-        else if (idx == 5) // LRU-Hash
+        else if (idx == 11) // LRU-Hash
           lruHash.put(key, value);
         else // LFU-Hash
           lfuHash.put(key, value);
@@ -361,11 +415,11 @@ void testWorkloadShift() {
         // 执行读操作并记录命中情况
         std::string result;
         get_operations[idx]++;
-        if (idx < 5) { // 前5个缓存算法
+        if (idx < 11) { // 前11个缓存算法
           if (caches[idx]->get(key, result)) {
             hits[idx]++;
           }
-        } else if (idx == 5) { // LRU-Hash
+        } else if (idx == 11) { // LRU-Hash
           if (lruHash.get(key, result)) {
             hits[idx]++;
           }
@@ -381,9 +435,451 @@ void testWorkloadShift() {
   printResults("工作负载剧烈变化测试", CAPACITY, get_operations, hits);
 }
 
+// 正确性检查失败的次数，不为0时main返回1
+int failedChecks = 0;
+
+// 条件不成立时输出检查项并记录失败
+void check(bool ok, const std::string &what) {
+  std::cout << (ok ? "  通过: " : "  失败: ") << what << std::endl;
+  if (!ok) {
+    ++failedChecks;
+  }
+}
+
+void testLoaderStats() {
+  std::cout << "\n=== 正确性测试：读穿加载的命中统计 ===" << std::endl;
+
+  const int KEYS = 100;
+  CacheMgr::LRUCache<int, std::string> lru(KEYS);
+  CacheMgr::LFUAvgCache<int, std::string> lfuAging(KEYS);
+  CacheMgr::ClockCache<int, std::string> clock(KEYS);
+  std::array<CacheMgr::CacheBase<int, std::string> *, 3> caches = {&lru, &lfuAging,
+                                                                    &clock};
+  std::vector<std::string> names = {"LRU", "LFU-Aging", "CLOCK"};
+  auto loader = [](const int &key) { return "value" + std::to_string(key); };
+
+  for (size_t idx = 0; idx < caches.size(); ++idx) {
+    // 第一轮全部未命中并加载，第二轮全部命中
+    for (int round = 0; round < 2; ++round) {
+      for (int key = 0; key < KEYS; ++key) {
+        caches[idx]->getOrLoad(key, loader);
+      }
+    }
+    CacheMgr::CacheStats stats = caches[idx]->stats();
+    check(KEYS == stats.misses && KEYS == stats.hits,
+          names[idx] + " 每次加载只记一次未命中");
+  }
+}
+
+// 异步加载进行中时调整分片数：加载完成后的写入应落到新分片上，而不是访问已释放的旧分片
+template <typename Cache>
+void checkReshardDuringAsyncLoad(Cache &cache, const std::string &name) {
+  const int KEYS = 64;
+  std::atomic<int> started{0};
+  std::atomic<bool> released{false};
+  auto loader = [&](const int &key) {
+    ++started;
+    while (!released) {
+      std::this_thread::yield();
+    }
+    return "value" + std::to_string(key);
+  };
+
+  std::vector<std::shared_future<std::string>> futures;
+  for (int key = 0; key < KEYS; ++key) {
+    futures.push_back(cache.getOrLoadAsync(key, loader));
+  }
+  while (started < KEYS) {
+    std::this_thread::yield();
+  }
+  // 全部加载都在进行中，迁移完所有旧分片之后才放行
+  cache.reshard(8);
+  cache.waitResized();
+  released = true;
+
+  bool loadedOk = true;
+  for (int key = 0; key < KEYS; ++key) {
+    loadedOk = loadedOk && futures[key].get() == "value" + std::to_string(key);
+  }
+  int cached = 0;
+  for (int key = 0; key < KEYS; ++key) {
+    std::string value;
+    if (cache.get(key, value) && value == "value" + std::to_string(key)) {
+      ++cached;
+    }
+  }
+  check(loadedOk, name + " 迁移期间的异步加载返回正确的值");
+  check(KEYS == cached, name + " 迁移期间完成的异步加载写入新分片");
+}
+
+void testSliceRouting() {
+  std::cout << "\n=== 正确性测试：等间隔的整数关键字均匀分到各分片 ===" << std::endl;
+
+  // std::hash对整数是恒等映射，按分片数取模时间隔为8的关键字全部落在同一个分片
+  CacheMgr::LRUHashCache<int, std::string> cache(4096, 8);
+  const int KEYS = 800;
+  for (int idx = 0; idx < KEYS; ++idx) {
+    cache.put(8 * idx, "value");
+  }
+  uint64_t busiest = 0;
+  for (size_t slice = 0; slice < 8; ++slice) {
+    busiest = std::max(busiest, cache.sliceStats(slice).puts);
+  }
+  check(busiest < 2 * KEYS / 8, "任一分片的写入不超过平均值的两倍");
+}
+
+void testReshardAsyncLoad() {
+  std::cout << "\n=== 正确性测试：异步加载期间调整分片数 ===" << std::endl;
+
+  CacheMgr::LRUHashCache<int, std::string> lruHash(256, 2);
+  CacheMgr::LFUHashCache<int, std::string> lfuHash(256, 2);
+  checkReshardDuringAsyncLoad(lruHash, "LRU-Hash");
+  checkReshardDuringAsyncLoad(lfuHash, "LFU-Hash");
+}
+
+// 测试用的前端：包装LRUCache，可让指定的一次put在淘汰之后停顿，模拟写线程在降级之前被调度走
+class PausingFront {
+public:
+  explicit PausingFront(int capacity) : lru_(capacity), pauseKey_(-1) {}
+
+  void setEvictionListener(
+      CacheMgr::CacheBase<int, std::string>::EvictionListener listener) {
+    lru_.setEvictionListener(std::move(listener));
+  }
+
+  void put(const int &key, const std::string &val) {
+    lru_.put(key, val);
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (key == pauseKey_) {
+      paused_ = true;
+      cond_.notify_all();
+      // 限时停顿，持有条带锁期间其他线程的降级最多等待这么久
+      cond_.wait_for(lock, std::chrono::milliseconds(300), [this] { return resumed_; });
+      pauseKey_ = -1;
+    }
+  }
+
+  bool get(const int &key, std::string &val) { return lru_.get(key, val); }
+
+  CacheMgr::CacheStats stats() const { return lru_.stats(); }
+
+  // 之后写入key的put在淘汰之后停顿
+  void pauseOn(int key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pauseKey_ = key;
+    paused_ = false;
+    resumed_ = false;
+  }
+
+  void waitPaused() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock, [this] { return paused_; });
+  }
+
+  void resume() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    resumed_ = true;
+    cond_.notify_all();
+  }
+
+private:
+  CacheMgr::LRUCache<int, std::string> lru_;
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  int pauseKey_;
+  bool paused_ = false;
+  bool resumed_ = false;
+};
+
+void testTieredStaleDemotion() {
+  std::cout << "\n=== 正确性测试：降级与写入交错时不提升旧值 ===" << std::endl;
+
+  // 三个关键字取自不同的条带，停顿的写线程不挡住其余关键字
+  auto stripeOf = [](int key) { return CacheMgr::CacheHash<int>{}(key) >> 58; };
+  const int key = 1;
+  int other = key + 1;
+  while (stripeOf(other) == stripeOf(key)) {
+    ++other;
+  }
+  int third = other + 1;
+  while (stripeOf(third) == stripeOf(key) || stripeOf(third) == stripeOf(other)) {
+    ++third;
+  }
+
+  CacheMgr::TieredCache<int, std::string, PausingFront> tiered(
+      "tiered_check.log", 1 << 20, 1);
+  tiered.put(key, "v1");
+  // 写入other挤出v1，写线程在降级之前停顿
+  tiered.front().pauseOn(other);
+  std::thread first([&] { tiered.put(other, "other"); });
+  tiered.front().waitPaused();
+  tiered.put(key, "v2");
+  // 写入third挤出v2，写线程同样在降级之前停顿
+  tiered.front().pauseOn(third);
+  std::thread second([&] { tiered.put(third, "third"); });
+  tiered.front().waitPaused();
+
+  std::string value;
+  bool found = tiered.get(key, value);
+  tiered.front().resume();
+  first.join();
+  second.join();
+  check(found && "v2" == value, "被覆盖后淘汰的旧值不会从日志提升回前端");
+}
+
+void testPipelineExpiredLoad() {
+  std::cout << "\n=== 正确性测试：到期条目的并发加载只执行一次 ===" << std::endl;
+
+  std::atomic<int> loads(0);
+  CacheMgr::PipelineOptions<int, std::string> options;
+  options.ttl = std::chrono::milliseconds(20);
+  options.refreshAhead = 1.0; // 不提前刷新，到期后只能由getOrLoad加载
+  options.loader = [&loads](const int &key) {
+    loads.fetch_add(1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    return "value" + std::to_string(key);
+  };
+  CacheMgr::PipelinedCache<int, std::string,
+                           CacheMgr::LRUHashCache<int, CacheMgr::StampedValue<std::string>>>
+      pipeline(options, 64, 1);
+  pipeline.getOrLoad(7);
+  std::this_thread::sleep_for(std::chrono::milliseconds(40));
+
+  const int THREADS = 8;
+  std::atomic<int> correct(0);
+  std::vector<std::thread> readers;
+  for (int t = 0; t < THREADS; ++t) {
+    readers.emplace_back([&] {
+      if ("value7" == pipeline.getOrLoad(7)) {
+        correct.fetch_add(1);
+      }
+    });
+  }
+  for (std::thread &reader : readers) {
+    reader.join();
+  }
+  check(THREADS == correct.load(), "到期后并发的getOrLoad返回重新加载的值");
+  check(2 == loads.load(), "到期后并发的getOrLoad只调用一次加载函数");
+}
+
+// 在cache上运行固定种子的均匀访问，未命中时写入
+template <typename Cache> void runUniformGets(Cache &cache, int ops, unsigned seed) {
+  std::mt19937 gen(seed);
+  std::uniform_int_distribution<int> dist(0, 511);
+  for (int op = 0; op < ops; ++op) {
+    int key = dist(gen);
+    std::string value;
+    if (!cache.get(key, value)) {
+      cache.put(key, "value" + std::to_string(key));
+    }
+  }
+}
+
+// 预热之后才开启曲线估计的缓存，与一开始就开启的缓存在相同访问序列下应得到相同的曲线
+template <typename Cache>
+void checkMissRatioAfterWarmup(Cache &warmed, Cache &fresh, const std::string &name) {
+  runUniformGets(warmed, 50000, 1);
+  warmed.enableMissRatioCurve(1024, 1.0);
+  fresh.enableMissRatioCurve(1024, 1.0);
+  runUniformGets(warmed, 20000, 2);
+  runUniformGets(fresh, 20000, 2);
+  double warmedRatio = warmed.missRatioCurve().missRatioAt(256);
+  double freshRatio = fresh.missRatioCurve().missRatioAt(256);
+  check(std::abs(warmedRatio - freshRatio) < 0.01,
+        name + " 预热后开启的曲线不计入开启之前的读请求");
+}
+
+void testMissRatioAfterWarmup() {
+  std::cout << "\n=== 正确性测试：预热之后开启未命中率曲线 ===" << std::endl;
+
+  CacheMgr::LRUHashCache<int, std::string> lruWarmed(256, 4), lruFresh(256, 4);
+  checkMissRatioAfterWarmup(lruWarmed, lruFresh, "LRU-Hash");
+  CacheMgr::LFUHashCache<int, std::string> lfuWarmed(256, 4), lfuFresh(256, 4);
+  checkMissRatioAfterWarmup(lfuWarmed, lfuFresh, "LFU-Hash");
+  using Sharded = CacheMgr::ShardedCache<int, std::string, CacheMgr::LRUCache<int, std::string>>;
+  Sharded shardedWarmed(256, 4), shardedFresh(256, 4);
+  checkMissRatioAfterWarmup(shardedWarmed, shardedFresh, "Sharded-LRU");
+
+  // 按权重计容量时由权重预算推算不出条目数，未给出曲线范围时不开启
+  auto weigher = [](const int &, const std::string &val) { return val.size(); };
+  CacheMgr::LRUHashCache<int, std::string> lruWeighted(4096, 4, weigher);
+  CacheMgr::LFUHashCache<int, std::string> lfuWeighted(4096, 4, weigher);
+  lruWeighted.enableMissRatioCurve();
+  lfuWeighted.enableMissRatioCurve();
+  check(lruWeighted.missRatioCurve().capacities.empty() &&
+            lfuWeighted.missRatioCurve().capacities.empty(),
+        "按权重计容量且未给出曲线范围时不开启曲线估计");
+  lruWeighted.enableMissRatioCurve(1024);
+  lfuWeighted.enableMissRatioCurve(1024);
+  check(1024 == lruWeighted.missRatioCurve().capacities.back() &&
+            1024 == lfuWeighted.missRatioCurve().capacities.back(),
+        "按权重计容量时按给出的条目数覆盖曲线");
+}
+
+void testConcurrentClockVisit() {
+  std::cout << "\n=== 正确性测试：并发CLOCK在写入与清空期间无锁读取 ===" << std::endl;
+
+  // 容量小于关键字数，后台淘汰与写线程的替换、删除、清空同时摘除节点
+  CacheMgr::ConcurrentClockCache<int, std::string> cache(48, 2);
+  const int KEYS = 64;
+  const int READERS = 3;
+  std::atomic<bool> stop(false);
+  std::atomic<uint64_t> visits(0);
+  std::atomic<uint64_t> mismatches(0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < READERS; ++t) {
+    threads.emplace_back([&, t] {
+      std::mt19937 gen(t);
+      std::uniform_int_distribution<int> dist(0, KEYS - 1);
+      while (!stop.load(std::memory_order_relaxed)) {
+        int key = dist(gen);
+        // 节点在visitor返回之前被释放时，ASan报告释放后使用，值也可能被改写
+        cache.visit(key, [&](const std::string &value) {
+          if (0 != value.compare(0, value.find('#'), "value" + std::to_string(key))) {
+            mismatches.fetch_add(1, std::memory_order_relaxed);
+          }
+          visits.fetch_add(1, std::memory_order_relaxed);
+        });
+      }
+    });
+  }
+  threads.emplace_back([&] {
+    std::mt19937 gen(100);
+    std::uniform_int_distribution<int> dist(0, KEYS - 1);
+    for (int round = 0; !stop.load(std::memory_order_relaxed); ++round) {
+      int key = dist(gen);
+      // 值足够长，避免短字符串优化把内容放在节点内
+      cache.put(key, "value" + std::to_string(key) + "#" + std::string(32, 'x') +
+                         std::to_string(round));
+      if (0 == round % 7) {
+        cache.remove(dist(gen));
+      }
+    }
+  });
+  threads.emplace_back([&] {
+    while (!stop.load(std::memory_order_relaxed)) {
+      cache.purge();
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(500));
+  stop.store(true);
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  check(visits.load() > 0, "读线程在写入期间命中过缓存");
+  check(0 == mismatches.load(), "读线程读到的值与关键字一致");
+  check(cache.size() <= KEYS, "替换、删除与清空之后条目数不超过关键字数");
+}
+
+void testWeightedClockInsert() {
+  std::cout << "\n=== 正确性测试：按权重计容量的CLOCK不淘汰刚写入的条目 ===" << std::endl;
+
+  CacheMgr::Cache<int, std::string, CacheMgr::ClockPolicy, CacheMgr::CacheIndexMap,
+                  CacheMgr::NoLock, CacheMgr::StatsRecorder, CacheMgr::FeatureWeight>
+      cache(4, [](const int &, const std::string &val) { return val.size(); });
+  std::string value;
+  for (int key = 0; key < 4; ++key) {
+    cache.put(key, "a");
+    cache.get(key, value); // 置访问位，时钟指针转过一圈后第一个访问位为0的是新条目
+  }
+  cache.put(100, "bb");
+  check(cache.get(100, value) && "bb" == value, "超出预算时写入的条目仍在缓存中");
+  check(3 == cache.size(), "为新条目淘汰了两个旧条目");
+}
+
+// 按权重计容量的LFU：新条目在最小频次桶中，超出预算的淘汰不能选中它
+template <typename Cache> void checkWeightedLFUInsert(Cache &cache, const std::string &name) {
+  std::string value;
+  for (int key = 0; key < 3; ++key) {
+    cache.put(key, "a");
+    cache.get(key, value); // 旧条目的频次为2，高于新条目
+  }
+  cache.put(100, "bb");
+  check(cache.get(100, value) && "bb" == value, name + " 超出预算时写入的条目仍在缓存中");
+}
+
+void testWeightedLFUInsert() {
+  std::cout << "\n=== 正确性测试：按权重计容量的LFU不淘汰刚写入的条目 ===" << std::endl;
+
+  auto weigher = [](const int &, const std::string &val) { return val.size(); };
+  CacheMgr::LFUCache<int, std::string> lfu(size_t(4), weigher);
+  checkWeightedLFUInsert(lfu, "LFU");
+  CacheMgr::LFUAvgCache<int, std::string> sweep(size_t(4), weigher);
+  checkWeightedLFUInsert(sweep, "LFU-Aging");
+  CacheMgr::LFUAvgCache<int, std::string> lazy(size_t(4), weigher, 1000000,
+                                               CacheMgr::LFUAgingMode::Lazy);
+  checkWeightedLFUInsert(lazy, "LFU-Aging(Lazy)");
+}
+
+void testLRURestoreMerge() {
+  std::cout << "\n=== 正确性测试：合并多个LRU快照分片时按新旧位置交错 ===" << std::endl;
+
+  CacheMgr::LRUCache<int, std::string> first(4), second(4);
+  for (int key = 0; key < 4; ++key) {
+    first.put(key, "first");
+    second.put(10 + key, "second");
+  }
+  CacheMgr::SnapshotShard<int, std::string> merged = first.snapshot();
+  for (auto &entry : second.snapshot()) {
+    merged.push_back(std::move(entry));
+  }
+  // 容量只够一半，保留的应是两个分片各自较新的一半，而不是整个第二个分片
+  CacheMgr::LRUCache<int, std::string> target(4);
+  target.restore(std::move(merged));
+  std::string value;
+  bool kept = target.get(2, value) && target.get(3, value) && target.get(12, value) &&
+              target.get(13, value);
+  check(kept, "两个分片中较新的条目都被保留");
+}
+
+// 批量查找与逐个查找的结果一致，关键字个数超过预取距离，覆盖预取的各个阶段
+template <typename Cache> void checkBatchLookup(Cache &cache, const std::string &name) {
+  const int KEYS = 64;
+  for (int key = 0; key < KEYS; key += 2) {
+    cache.put(key, "value" + std::to_string(key));
+  }
+  std::vector<int> keys;
+  for (int key = KEYS - 1; key >= 0; --key) {
+    keys.push_back(key);
+  }
+  std::vector<std::string> vals(keys.size());
+  std::unique_ptr<bool[]> hits(new bool[keys.size()]);
+  size_t hitNum = cache.getMany(keys.data(), keys.size(), vals.data(), hits.get());
+  bool same = KEYS / 2 == static_cast<int>(hitNum);
+  for (size_t idx = 0; idx < keys.size(); ++idx) {
+    bool expected = 0 == keys[idx] % 2;
+    same = same && expected == hits[idx] &&
+           (!expected || "value" + std::to_string(keys[idx]) == vals[idx]);
+  }
+  check(same, name + " 批量查找与逐个查找的结果一致");
+}
+
+void testBatchLookup() {
+  std::cout << "\n=== 正确性测试：按索引查找的引擎批量查找 ===" << std::endl;
+
+  CacheMgr::LFUCache<int, std::string> lfu(128);
+  checkBatchLookup(lfu, "LFU");
+  CacheMgr::LFUAvgCache<int, std::string> lfuAvg(128);
+  checkBatchLookup(lfuAvg, "LFU-Aging");
+  CacheMgr::ARCCanonicalCache<int, std::string> arc(128);
+  checkBatchLookup(arc, "ARC-Canonical");
+}
+
 int main() {
   testHotDataAccess();
   testLoopPattern();
   testWorkloadShift();
-  return 0;
+  testLoaderStats();
+  testSliceRouting();
+  testReshardAsyncLoad();
+  testTieredStaleDemotion();
+  testPipelineExpiredLoad();
+  testMissRatioAfterWarmup();
+  testConcurrentClockVisit();
+  testWeightedClockInsert();
+  testWeightedLFUInsert();
+  testLRURestoreMerge();
+  testBatchLookup();
+  return 0 == failedChecks ? 0 : 1;
 }
\ No newline at end of file
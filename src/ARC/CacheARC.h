@@ -3,24 +3,30 @@
 #include <stdexcept>
 
 #include "CacheBase.h"
+#include "CacheFlatMap.h"
+#include "CacheMRC.h"
 #include "CacheARCLFUPart.h"
 #include "CacheARCLRUPart.h"
 
 namespace CacheMgr {
 
-template <typename Key, typename Value>
+template <typename Key, typename Value,
+          template <typename, typename> class Index = CacheIndexMap>
 class ARCCache : public CacheBase<Key, Value> {
 public:
   explicit ARCCache(size_t capacity = 10, size_t transformThreshold = 2)
       : capacity_(capacity), transformThreshold_(transformThreshold),
-        lruCache_(std::make_unique<ARCLRUCache<Key, Value>>(
+        lruCache_(std::make_unique<ARCLRUCache<Key, Value, Index>>(
             capacity, transformThreshold)),
-        lfuCache_(std::make_unique<ARCLFUCache<Key, Value>>(
+        lfuCache_(std::make_unique<ARCLFUCache<Key, Value, Index>>(
             capacity, transformThreshold)) {}
 
   ~ARCCache() override = default;
 
   bool get(const Key& key, Value &value) override {
+    if (nullptr != monitor_) {
+      monitor_->access(key);
+    }
     checkGhost(key); // 检查影子缓存
 
     bool shouldTransform = false;
@@ -55,6 +61,19 @@ public:
     throw std::runtime_error("Key not found in cache");
   }
 
+  /// @brief 开启未命中率曲线估计，需在并发访问开始之前调用
+  /// @param maxCapacity 曲线覆盖的最大容量，为0时取当前容量的4倍
+  /// @param sampleRate 读请求的采样率
+  void enableMissRatioCurve(size_t maxCapacity = 0, double sampleRate = 0.001) {
+    monitor_.reset(new MissRatioMonitor<Key>(
+        0 != maxCapacity ? maxCapacity : 4 * capacity_, sampleRate));
+  }
+
+  // 估计的未命中率-容量曲线（按LRU栈距离估计），未开启时为空
+  MissRatioCurve missRatioCurve() const {
+    return nullptr != monitor_ ? monitor_->curve() : MissRatioCurve();
+  }
+
 private:
   bool checkGhost(const Key &key) {
     bool inGhotst = false;
@@ -75,8 +94,9 @@ private:
 private:
   size_t capacity_;                                   // 缓存容量
   size_t transformThreshold_;                         // 转换阈值
-  std::unique_ptr<ARCLRUCache<Key, Value>> lruCache_; // LRU 部分
-  std::unique_ptr<ARCLFUCache<Key, Value>> lfuCache_; // LFU 部分
+  std::unique_ptr<ARCLRUCache<Key, Value, Index>> lruCache_; // LRU 部分
+  std::unique_ptr<ARCLFUCache<Key, Value, Index>> lfuCache_; // LFU 部分
+  std::unique_ptr<MissRatioMonitor<Key>> monitor_;    // 未命中率曲线监视器，未开启时为空
 };
 
 } // namespace CacheMgr
\ No newline at end of file
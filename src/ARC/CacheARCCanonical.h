@@ -0,0 +1,419 @@
+/*
+ARC-Canonical:
+按论文原始算法实现的ARC（Megiddo & Modha, 2003），四个队列共用一个节点池：
+    T1：只被访问过一次的常驻数据        T2：至少被访问过两次的常驻数据
+    B1：从T1淘汰的影子关键字            B2：从T2淘汰的影子关键字
+    1. 命中T1或T2：移动到T2的最新位置
+    2. 写入命中B1：T1目标p += max(|B2|/|B1|, 1)，腾出位置后作为T2的最新数据
+    3. 写入命中B2：T1目标p -= max(|B1|/|B2|, 1)，腾出位置后作为T2的最新数据
+    4. 全新关键字：按|T1|+|B1|与总量裁剪影子队列或T1，腾出位置后加入T1
+    5. 腾出位置（replace）：|T1|超过p时淘汰T1最旧的数据进入B1，否则淘汰T2最旧的数据进入B2
+与ARCCache相比，整个缓存只有一把锁，一次get/put只加锁一次；
+四个队列是同一节点池上的下标链表，影子节点只保留关键字，队列之间移动不做任何堆分配，
+每次操作都是O(1)。读操作不带值，影子命中的自适应在写入时进行。
+设置了存活时间的常驻数据到期后直接移出缓存，不进入影子队列。
+*/
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "CacheBase.h"
+#include "CacheBatch.h"
+#include "CacheFlatMap.h"
+#include "CacheSnapshot.h"
+#include "CacheTimerWheel.h"
+
+namespace CacheMgr {
+
+template <typename Key, typename Value,
+          template <typename, typename> class Index = CacheIndexMap>
+class ARCCanonicalCache : public CacheBase<Key, Value> {
+public:
+  using IndexMap = Index<Key, uint32_t>;
+  using ExpiryWheel = TimerWheel<Key>;
+
+  explicit ARCCanonicalCache(size_t capacity = 10)
+      : capacity_(capacity), target_(0), freeHead_(kNil),
+        nodes_(kListNum + 2 * capacity) {
+    for (uint32_t list = 0; list < kListNum; ++list) {
+      nodes_[list].prev = nodes_[list].next = list;
+      nodes_[list].list = static_cast<uint8_t>(list);
+      sizes_[list] = 0;
+    }
+    for (size_t idx = nodes_.size(); idx > kListNum; --idx) {
+      nodes_[idx - 1].next = freeHead_;
+      freeHead_ = static_cast<uint32_t>(idx - 1);
+    }
+    index_.reserve(2 * capacity);
+  }
+
+  ~ARCCanonicalCache() override = default;
+
+  bool get(const Key &key, Value &value) override {
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    return getLocked(key, value);
+  }
+
+  void put(const Key &key, const Value &value) override {
+    if (0 == capacity_) {
+      return;
+    }
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    putLocked(key, value);
+  }
+
+  void put(const Key &key, Value &&value) override {
+    if (0 == capacity_) {
+      return;
+    }
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    putLocked(key, std::move(value));
+  }
+
+  // 添加缓存并设置存活时间，到期后不再命中；不带存活时间的put会清除之前设置的存活时间
+  void put(const Key &key, const Value &value, std::chrono::milliseconds ttl) {
+    if (0 == capacity_) {
+      return;
+    }
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    putLocked(key, value, deadlineOf(ttl));
+  }
+
+  void put(const Key &key, Value &&value, std::chrono::milliseconds ttl) {
+    if (0 == capacity_) {
+      return;
+    }
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    putLocked(key, std::move(value), deadlineOf(ttl));
+  }
+
+  // 命中时在锁内直接读取缓存值，不产生复制
+  bool visit(const Key &key,
+             const std::function<void(const Value &)> &visitor) override {
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    auto it = index_.find(key);
+    if (it == index_.end() || isGhost(nodes_[it->second].list) ||
+        expireIfDue(it->second)) {
+      stats_.add(StatsRecorder::Miss);
+      return false;
+    }
+    stats_.add(StatsRecorder::Hit);
+    moveTo(it->second, kT2);
+    visitor(nodes_[it->second].val);
+    return true;
+  }
+
+  Value get(const Key &key) override {
+    Value value;
+    if (get(key, value)) {
+      return value; // 成功获取到值
+    }
+    throw std::runtime_error("Key not found in cache");
+  }
+
+  // 整批只加一次锁
+  void putBatch(const Key *keys, const Value *vals, const uint32_t *order,
+                size_t count) override {
+    if (0 == capacity_) {
+      return;
+    }
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    for (size_t i = 0; i < count; ++i) {
+      size_t idx = detail::batchIndex(order, i);
+      putLocked(keys[idx], vals[idx]);
+    }
+  }
+
+  // 整批只加一次锁；索引为FlatMap时提前预取后续关键字的探测组与节点
+  size_t getBatch(const Key *keys, const uint32_t *order, size_t count,
+                  Value *vals, bool *hits) override {
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    size_t hitNum = 0;
+    for (size_t i = 0; i < count; ++i) {
+      detail::prefetchLookup(index_, keys, order, count, i,
+                             [this](uint32_t slot) { return &nodes_[slot]; });
+      size_t idx = detail::batchIndex(order, i);
+      hits[idx] = getLocked(keys[idx], vals[idx]);
+      hitNum += hits[idx] ? 1 : 0;
+    }
+    return hitNum;
+  }
+
+  // 删除指定缓存，影子记录一并清除
+  void remove(const Key &key) {
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+      release(it->second);
+    }
+  }
+
+  // 立即删除所有已到期的缓存，平时到期的缓存在写入时批量清理、在读取时惰性判断
+  void purgeExpired() {
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    expireLocked(ExpiryWheel::now());
+  }
+
+  CacheStats stats() const override { return stats_.snapshot(); }
+
+  static constexpr SnapshotPolicy kSnapshotPolicy = SnapshotPolicy::ARC;
+
+  // 在锁内复制所有未到期的常驻数据：先T1后T2，队列内最旧的在前，meta为所在队列；影子不导出
+  SnapshotShard<Key, Value> snapshot() {
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    SnapshotShard<Key, Value> entries;
+    entries.reserve(sizes_[kT1] + sizes_[kT2]);
+    uint64_t now = ExpiryWheel::now();
+    for (uint8_t list : {kT1, kT2}) {
+      for (uint32_t idx = nodes_[list].next; list != idx; idx = nodes_[idx].next) {
+        const Entry &node = nodes_[idx];
+        if (expiry_.empty() || !expiry_.expired(node.key, now)) {
+          entries.push_back({node.key, node.val, list});
+        }
+      }
+    }
+    return entries;
+  }
+
+  // 整批只加一次锁，按快照中的队列直接挂到T1或T2的最新位置，不逐条执行replace；
+  // 超出剩余容量时先舍弃T1中最旧的条目；空缓存恢复时T1目标p取恢复后的|T1|
+  void restore(SnapshotShard<Key, Value> entries) {
+    if (0 == capacity_) {
+      return;
+    }
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    bool fresh = index_.empty();
+    // 多个快照分片合并到同一分片时两个队列的条目交错
+    std::stable_partition(entries.begin(), entries.end(),
+                          [](const SnapshotEntry<Key, Value> &entry) {
+                            return kT1 == entry.meta;
+                          });
+    size_t resident = sizes_[kT1] + sizes_[kT2];
+    size_t room = capacity_ > resident ? capacity_ - resident : 0;
+    size_t skip = entries.size() > room ? entries.size() - room : 0;
+    for (size_t idx = skip; idx < entries.size() && kNil != freeHead_; ++idx) {
+      SnapshotEntry<Key, Value> &entry = entries[idx];
+      if (index_.find(entry.key) != index_.end()) {
+        continue; // 已有的缓存或影子记录比快照新
+      }
+      uint32_t slot = freeHead_;
+      freeHead_ = nodes_[slot].next;
+      nodes_[slot].key = entry.key;
+      nodes_[slot].val = std::move(entry.value);
+      linkBack(slot, kT2 == entry.meta ? kT2 : kT1);
+      index_[entry.key] = slot;
+    }
+    if (fresh) {
+      target_ = std::min(capacity_, sizes_[kT1]);
+    }
+  }
+
+private:
+  static uint64_t deadlineOf(std::chrono::milliseconds ttl) {
+    return ExpiryWheel::now() +
+           static_cast<uint64_t>(ttl.count() > 0 ? ttl.count() : 0);
+  }
+
+  bool getLocked(const Key &key, Value &value) {
+    auto it = index_.find(key);
+    if (it == index_.end() || isGhost(nodes_[it->second].list) ||
+        expireIfDue(it->second)) {
+      stats_.add(StatsRecorder::Miss);
+      return false;
+    }
+    moveTo(it->second, kT2);
+    value = nodes_[it->second].val;
+    stats_.add(StatsRecorder::Hit);
+    return true;
+  }
+
+  template <typename V>
+  void putLocked(const Key &key, V &&value,
+                 uint64_t deadline = ExpiryWheel::kNever) {
+    stats_.add(StatsRecorder::Put);
+    if (!expiry_.empty() || ExpiryWheel::kNever != deadline) {
+      // 写入时推进时间轮，到期的缓存先腾出位置
+      expireLocked(ExpiryWheel::now());
+    }
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+      uint32_t idx = it->second;
+      uint8_t list = nodes_[idx].list;
+      if (isGhost(list)) {
+        stats_.add(StatsRecorder::GhostHit);
+      }
+      if (kB1 == list) {
+        // 影子命中B1，说明T1过小
+        size_t delta = std::max<size_t>(sizes_[kB2] / sizes_[kB1], 1);
+        target_ = std::min(capacity_, target_ + delta);
+        replace(false);
+      } else if (kB2 == list) {
+        // 影子命中B2，说明T2过小
+        size_t delta = std::max<size_t>(sizes_[kB1] / sizes_[kB2], 1);
+        target_ = target_ > delta ? target_ - delta : 0;
+        replace(true);
+      }
+      nodes_[idx].val = std::forward<V>(value);
+      moveTo(idx, kT2);
+      setExpiry(key, deadline);
+      return;
+    }
+
+    size_t l1 = sizes_[kT1] + sizes_[kB1];
+    if (l1 >= capacity_) {
+      if (sizes_[kT1] < capacity_) {
+        release(nodes_[kB1].next); // 丢弃B1最旧的影子
+        replace(false);
+      } else {
+        release(nodes_[kT1].next); // B1为空且T1已满，直接丢弃T1最旧的数据
+        stats_.add(StatsRecorder::Eviction);
+      }
+    } else {
+      size_t total = l1 + sizes_[kT2] + sizes_[kB2];
+      if (total >= capacity_) {
+        if (total >= 2 * capacity_) {
+          release(nodes_[kB2].next); // 丢弃B2最旧的影子
+        }
+        replace(false);
+      }
+    }
+
+    uint32_t idx = freeHead_;
+    freeHead_ = nodes_[idx].next;
+    nodes_[idx].key = key;
+    nodes_[idx].val = std::forward<V>(value);
+    linkBack(idx, kT1);
+    index_[key] = idx;
+    setExpiry(key, deadline);
+  }
+
+  // 设置或清除常驻数据的到期时间
+  void setExpiry(const Key &key, uint64_t deadline) {
+    if (ExpiryWheel::kNever != deadline) {
+      expiry_.schedule(key, deadline);
+    } else if (!expiry_.empty()) {
+      expiry_.cancel(key);
+    }
+  }
+
+  // 常驻数据已到期时移出缓存并返回true，读取时的惰性到期判断
+  bool expireIfDue(uint32_t idx) {
+    if (expiry_.empty() ||
+        !expiry_.expired(nodes_[idx].key, ExpiryWheel::now())) {
+      return false;
+    }
+    release(idx);
+    stats_.add(StatsRecorder::Expiration);
+    return true;
+  }
+
+  // 推进时间轮，移除所有已到期的常驻数据
+  void expireLocked(uint64_t now) {
+    expiry_.advance(now, [this](const Key &key) {
+      auto it = index_.find(key);
+      if (it != index_.end() && !isGhost(nodes_[it->second].list)) {
+        release(it->second);
+        stats_.add(StatsRecorder::Expiration);
+      }
+    });
+  }
+
+  // 四个队列的编号，同时也是各自哨兵节点的槽位
+  static constexpr uint8_t kT1 = 0;
+  static constexpr uint8_t kT2 = 1;
+  static constexpr uint8_t kB1 = 2;
+  static constexpr uint8_t kB2 = 3;
+  static constexpr uint32_t kListNum = 4;
+  // 空闲链表的结束标记
+  static constexpr uint32_t kNil = UINT32_MAX;
+
+  struct Entry {
+    Key key;       // 关键字
+    Value val;     // 缓存值，影子节点为空
+    uint32_t prev; // 队列中较旧的一侧
+    uint32_t next; // 队列中较新的一侧（空闲时串联空闲链表）
+    uint8_t list;  // 所在队列
+  };
+
+  static bool isGhost(uint8_t list) { return list >= kB1; }
+
+  // 常驻数据已满时腾出一个位置，被淘汰的数据只保留关键字进入对应的影子队列
+  void replace(bool hitB2) {
+    if (sizes_[kT1] + sizes_[kT2] < capacity_) {
+      return; // 有数据被删除过，仍有空位
+    }
+    size_t t1 = sizes_[kT1];
+    if (t1 > 0 && (t1 > target_ || (hitB2 && t1 == target_) ||
+                   0 == sizes_[kT2])) {
+      demote(nodes_[kT1].next, kB1);
+    } else {
+      demote(nodes_[kT2].next, kB2);
+    }
+  }
+
+  // 常驻数据降为影子，释放缓存值
+  void demote(uint32_t idx, uint8_t ghost) {
+    if (!expiry_.empty()) {
+      expiry_.cancel(nodes_[idx].key); // 影子只保留关键字，不再到期
+    }
+    nodes_[idx].val = Value();
+    moveTo(idx, ghost);
+    stats_.add(StatsRecorder::Eviction);
+  }
+
+  // 将节点移动到指定队列的最新位置
+  void moveTo(uint32_t idx, uint8_t list) {
+    unlink(idx);
+    linkBack(idx, list);
+  }
+
+  // 将节点彻底移出缓存并归还空闲链表
+  void release(uint32_t idx) {
+    if (!expiry_.empty()) {
+      expiry_.cancel(nodes_[idx].key);
+    }
+    index_.erase(nodes_[idx].key);
+    unlink(idx);
+    nodes_[idx].val = Value();
+    nodes_[idx].next = freeHead_;
+    freeHead_ = idx;
+  }
+
+  void unlink(uint32_t idx) {
+    Entry &node = nodes_[idx];
+    nodes_[node.prev].next = node.next;
+    nodes_[node.next].prev = node.prev;
+    --sizes_[node.list];
+  }
+
+  void linkBack(uint32_t idx, uint8_t list) {
+    Entry &node = nodes_[idx];
+    Entry &dummy = nodes_[list];
+    node.prev = dummy.prev;
+    node.next = list;
+    node.list = list;
+    nodes_[dummy.prev].next = idx;
+    dummy.prev = idx;
+    ++sizes_[list];
+  }
+
+private:
+  size_t capacity_;           // 常驻数据容量c
+  size_t target_;             // T1的目标大小p，取值[0, c]
+  uint32_t freeHead_;         // 空闲槽位链表头
+  size_t sizes_[kListNum];    // 各队列的节点数量
+  std::mutex mutex_;          // 互斥锁
+  IndexMap index_;            // 关键字到槽位的索引（常驻与影子共用）
+  std::vector<Entry> nodes_;  // 节点池，前4个槽位是各队列的哨兵
+  ExpiryWheel expiry_;        // 设置了存活时间的常驻数据的到期时间轮
+  StatsRecorder stats_;       // 运行统计
+};
+
+} // namespace CacheMgr
\ No newline at end of file
@@ -0,0 +1,16 @@
+/*
+HashARC:
+ARC的哈希分片版本，每个分片是一个单锁的ARCCanonicalCache，
+B1/B2的自适应在分片内独立进行，不同分片上的操作完全并行。
+*/
+#pragma once
+
+#include "CacheARCCanonical.h"
+#include "CacheSharded.h"
+
+namespace CacheMgr {
+
+template <typename Key, typename Value>
+using ARCHashCache = ShardedCache<Key, Value, ARCCanonicalCache<Key, Value>>;
+
+} // namespace CacheMgr
\ No newline at end of file
@@ -6,21 +6,23 @@
 #include <unordered_map>
 
 #include "CacheARCNode.h"
+#include "CacheFlatMap.h"
+#include "CacheGhost.h"
 
 namespace CacheMgr {
 
-template <typename Key, typename Value> class ARCLFUCache {
+template <typename Key, typename Value,
+          template <typename, typename> class Index = CacheIndexMap>
+class ARCLFUCache {
 public:
   using NodeType = ARCNode<Key, Value>;
   using NodePtr = std::shared_ptr<NodeType>;
-  using NodeMap = std::unordered_map<Key, NodePtr>;
+  using NodeMap = Index<Key, NodePtr>;
   using FreqMap = std::map<size_t, std::list<NodePtr>>;
 
   explicit ARCLFUCache(size_t capacity, size_t transformThreshold)
-      : capacity_(capacity), ghostCapacity_(capacity),
-        transformThreshold_(transformThreshold), minFreq_(0) {
-    initializeCache();
-  }
+      : capacity_(capacity), transformThreshold_(transformThreshold),
+        minFreq_(0), ghost_(capacity) {}
 
   ~ARCLFUCache() = default;
 
@@ -55,20 +57,13 @@ public:
 
   bool checkGhost(const Key &key) {
     std::lock_guard<std::mutex> lock(mutex_);
-    auto it = ghostCache_.find(key);
-    if (it != ghostCache_.end()) {
-      NodePtr node = it->second;
-      removeFromGhostCache(node);
-      ghostCache_.erase(it);
-      return true; // 如果在影子缓存中找到，返回true
-    }
-    return false; // 未找到节点
+    return ghost_.erase(key); // 如果在影子缓存中找到，删除并返回true
   }
 
   void increaseCapacity() {
     std::lock_guard<std::mutex> lock(mutex_);
     ++capacity_;
-    ++ghostCapacity_;
+    ghost_.setCapacity(ghost_.capacity() + 1);
   }
 
   bool decreaseCapacity() {
@@ -79,22 +74,13 @@ public:
     if (mainCache_.size() == capacity_) {
       evictLeastRecent(); // 如果主缓存已满，先移除最少使用
     }
-    if (ghostCache_.size() == ghostCapacity_) {
-      removeOldestGhostNode(); // 如果影子缓存已满，先移除最旧的影子节点
-    }
     --capacity_;
-    --ghostCapacity_;
+    // 影子缓存已满时弹出最旧的影子关键字
+    ghost_.setCapacity(ghost_.capacity() - 1);
     return true; // 成功减少容量
   }
 
 private:
-  void initializeCache() {
-    ghostHead_ = std::make_shared<NodeType>();
-    ghostTail_ = std::make_shared<NodeType>();
-    ghostHead_->next = ghostTail_;
-    ghostTail_->prev_ = ghostHead_;
-  }
-
   bool updateExistingNode(NodePtr node, const Value &value) {
     if (node) {
       node->setValue(value);
@@ -171,65 +157,21 @@ private:
         minFreq_ = 0; // 如果频率映射为空，重置最小频率
       }
     }
-    if (ghostCache_.size() >= ghostCapacity_) {
-      removeOldestGhostNode(); // 如果影子缓存已满，移除最旧的影子节点
-    }
-    addToGhostCache(leastRecentNode); // 将 leastRecentNode 添加到影子缓存
-    mainCache_.erase(leastRecentNode->getKey()); // 从主缓存中移除节点
-  }
-
-  void removeFromGhostCache(NodePtr node) {
-    if (node && node->prev_ && node->next) {
-      // 从影子缓存链表中移除节点
-      node->prev_->next =
-          node->next; // 前一个节点的 next 指向当前节点的下一个节点
-      if (node->next) {
-        node->next->prev_ = node->prev_; // 下一个节点的 prev_ 指向前一个节点
-        node->next = nullptr; // 清除 next 指针，避免悬挂指针
-        node->prev_ = nullptr; // 清除 prev_ 指针，避免悬挂指针
-      }
-    }
-  }
-
-  void addToGhostCache(NodePtr node) {
-    if (node) {
-      node->next = ghostTail_;
-      node->prev_ = ghostTail_->prev_;
-      if (ghostTail_->prev_) {
-        ghostTail_->prev_->next = node; // 前一个节点的 next 指向新节点
-      }
-      ghostTail_->prev_ = node; // 影子缓存尾节点的 prev_指向新节点
-      if (!ghostHead_->next) {
-        ghostHead_->next = node; // 如果影子缓存头节点的 next 为空
-      }
-      ghostCache_[node->getKey()] = node; // 将节点添加到影子缓存
-    }
-  }
-
-  void removeOldestGhostNode() {
-    NodePtr oldestNode = ghostHead_->next; // 获取影子缓存中的第一个节点
-    if (oldestNode && oldestNode != ghostTail_) {
-      removeFromGhostCache(oldestNode);        // 从影子缓存链表中移除
-      ghostCache_.erase(oldestNode->getKey()); // 从影子缓存映射中移除节点
-      oldestNode->next = nullptr; // 清除 next 指针，避免悬挂指针
-      oldestNode->prev_ = nullptr;  // 清除 prev_ 指针，避免悬挂指针
-      oldestNode.reset(); // 释放节点资源
-    }
+    // 影子缓存只记录关键字指纹，已满时弹出最旧的指纹
+    ghost_.touch(leastRecentNode->key_);
+    // 从主缓存中移除节点，节点与缓存值随之释放
+    mainCache_.erase(leastRecentNode->key_);
   }
 
 private:
   size_t capacity_;           // 缓存容量
-  size_t ghostCapacity_;      // 影子缓存容量(淘汰缓存)
   size_t transformThreshold_; // 转换阈值
   size_t minFreq_;            // 最小访问频率
   std::mutex mutex_;          // 互斥锁
 
-  NodeMap mainCache_;  // 主缓存
-  NodeMap ghostCache_; // 影子缓存
-  FreqMap freqMap_;    // 访问频率映射
-
-  NodePtr ghostHead_; // 影子缓存头节点
-  NodePtr ghostTail_; // 影子缓存尾节点
+  NodeMap mainCache_;    // 主缓存
+  FreqMap freqMap_;      // 访问频率映射
+  GhostList<Key> ghost_; // 影子缓存，只保存被淘汰关键字的指纹
 };
 
 } // namespace CacheMgr
\ No newline at end of file
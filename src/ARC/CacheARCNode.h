@@ -47,23 +47,28 @@ list），帮助识别新数据的价值。如果某个新数据被多次访问
 */
 #pragma once
 #include <memory>
+#include <utility>
 
 namespace CacheMgr {
 
-template <typename Key, typename Value> class ARCLRUCache; // 前向声明
-template <typename Key, typename Value> class ARCLFUCache; // 前向声明
+template <typename Key, typename Value,
+          template <typename, typename> class Index>
+class ARCLRUCache; // 前向声明
+template <typename Key, typename Value,
+          template <typename, typename> class Index>
+class ARCLFUCache; // 前向声明
 
 template <typename Key, typename Value> class ARCNode {
 public:
   ARCNode() : count_(1), prev_(nullptr), next(nullptr) {}
   ARCNode(Key key, Value val)
-      : key_(key), val_(val), count_(1), prev_(nullptr), next(nullptr) {}
+      : key_(std::move(key)), val_(std::move(val)), count_(1), prev_(nullptr), next(nullptr) {}
 
   ~ARCNode() = default;
 
   Key getKey() const { return key_; }
 
-  Value getValue() const { return val_; }
+  const Value &getValue() const { return val_; }
 
   void setValue(const Value &val) { val_ = val; }
 
@@ -79,8 +84,12 @@ private:
   std::shared_ptr<ARCNode<Key, Value>> next; // 后置缓存
 
 public:
-  friend class ARCLRUCache<Key, Value>; // 允许 ARCLRUCache 访问私有成员
-  friend class ARCLFUCache<Key, Value>; // 允许 ARCLFUCache 访问私有成员
+  // 允许 ARCLRUCache 访问私有成员
+  template <typename K, typename V, template <typename, typename> class I>
+  friend class ARCLRUCache;
+  // 允许 ARCLFUCache 访问私有成员
+  template <typename K, typename V, template <typename, typename> class I>
+  friend class ARCLFUCache;
 };
 
 } // namespace CacheMgr
\ No newline at end of file
@@ -0,0 +1,143 @@
+/*
+CLOCK:
+LRU的近似实现。所有缓存项存放在一个固定大小的环形数组中，每项附带一个访问位：
+    1. 命中：只把访问位置1（relaxed原子写），不调整任何链表，读路径只需共享锁
+    2. 淘汰：时钟指针沿数组顺序扫描，访问位为1的项清零并跳过（第二次机会），
+       遇到访问位为0的项即淘汰
+    3. 新项直接写入被淘汰的槽位，访问位为0，需要指针转完一圈才会再被检查
+相比LRU，命中不再需要独占锁与链表操作，淘汰是对连续内存的顺序扫描。
+*/
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <utility>
+#include <vector>
+
+#include "CacheArena.h"
+#include "CacheBase.h"
+#include "CacheFlatMap.h"
+
+namespace CacheMgr {
+
+// Arena为索引节点的分配方式，槽位数组本身是一整块连续内存，不经过分池
+template <typename Key, typename Value,
+          template <typename, typename> class Index = CacheIndexMap,
+          typename Arena = HeapArena>
+class ClockCache : public CacheBase<Key, Value> {
+public:
+  using IndexArena = ArenaIndex<Index, Key, uint32_t, Arena>;
+  using IndexMap = typename IndexArena::type;
+
+  explicit ClockCache(int capacity)
+      : capacity_(capacity > 0 ? capacity : 0), size_(0), hand_(0),
+        index_(IndexArena::make(arena_)), entries_(capacity_), refBits_(new std::atomic<uint8_t>[capacity_]) {
+    index_.reserve(capacity_);
+    for (size_t idx = 0; idx < capacity_; ++idx) {
+      refBits_[idx].store(0, std::memory_order_relaxed);
+    }
+  }
+
+  ~ClockCache() override = default;
+
+  void put(const Key &key, const Value &val) override { putImpl(key, val); }
+
+  void put(const Key &key, Value &&val) override {
+    putImpl(key, std::move(val));
+  }
+
+  bool get(const Key &key, Value &val) override {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+      stats_.add(StatsRecorder::Miss);
+      return false;
+    }
+    stats_.add(StatsRecorder::Hit);
+    // 命中只设置访问位，多个读线程可同时写入同一个值
+    refBits_[it->second].store(1, std::memory_order_relaxed);
+    val = entries_[it->second].val;
+    return true;
+  }
+
+  // 命中时在共享锁内直接读取缓存值，不产生复制
+  bool visit(const Key &key,
+             const std::function<void(const Value &)> &visitor) override {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+      stats_.add(StatsRecorder::Miss);
+      return false;
+    }
+    stats_.add(StatsRecorder::Hit);
+    refBits_[it->second].store(1, std::memory_order_relaxed);
+    visitor(entries_[it->second].val);
+    return true;
+  }
+
+  Value get(const Key &key) override {
+    Value val{};
+    get(key, val);
+    return val;
+  }
+
+  CacheStats stats() const override { return stats_.snapshot(); }
+
+private:
+  template <typename V> void putImpl(const Key &key, V &&val) {
+    if (0 == capacity_) {
+      return;
+    }
+    TimedLockGuard<std::shared_mutex> lock(mutex_, stats_);
+    stats_.add(StatsRecorder::Put);
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+      // 已在缓存中，更新值并视为一次访问
+      entries_[it->second].val = std::forward<V>(val);
+      refBits_[it->second].store(1, std::memory_order_relaxed);
+      return;
+    }
+    uint32_t idx = size_ < capacity_ ? static_cast<uint32_t>(size_++) : evict();
+    entries_[idx].key = key;
+    entries_[idx].val = std::forward<V>(val);
+    refBits_[idx].store(0, std::memory_order_relaxed);
+    index_[key] = idx;
+  }
+
+  struct Entry {
+    Key key;   // 关键字
+    Value val; // 缓存值
+  };
+
+  // 转动时钟指针找到访问位为0的槽位并淘汰，返回空出的槽位
+  uint32_t evict() {
+    while (true) {
+      uint32_t idx = static_cast<uint32_t>(hand_);
+      hand_ = (hand_ + 1 == capacity_) ? 0 : hand_ + 1;
+      if (refBits_[idx].load(std::memory_order_relaxed)) {
+        refBits_[idx].store(0, std::memory_order_relaxed); // 第二次机会
+        continue;
+      }
+      index_.erase(entries_[idx].key);
+      stats_.add(StatsRecorder::Eviction);
+      return idx;
+    }
+  }
+
+private:
+  size_t capacity_;        // 缓存容量
+  size_t size_;            // 已使用的槽位数量
+  size_t hand_;            // 时钟指针
+  std::shared_mutex mutex_; // 读写锁，读共享、写独占
+  Arena arena_;            // 索引节点的分池，声明在索引之前，最后析构
+  IndexMap index_;         // 关键字到槽位的索引
+  std::vector<Entry> entries_; // 环形槽位数组
+  std::unique_ptr<std::atomic<uint8_t>[]> refBits_; // 访问位
+  StatsRecorder stats_;    // 运行统计
+};
+
+} // namespace CacheMgr
\ No newline at end of file
@@ -0,0 +1,406 @@
+/*
+CLOCK-Concurrent:
+读路径完全无锁的并发CLOCK缓存，不分片，一张哈希表承载全部条目：
+    1. 哈希表为固定大小的桶数组，桶内是单向链表；节点发布后关键字与缓存值不再修改，
+       更新时整节点替换，读线程沿原子指针遍历，不加锁、不写共享数据
+    2. 写操作按桶加自旋锁，只与同一个桶上的写操作互斥；被替换或删除的节点交给EpochDomain，
+       确认没有读线程持有后才释放
+    3. 命中只把节点的访问计数加一（relaxed原子读写，已达上限时不写），
+       访问计数上限为1时即CLOCK（近似LRU），更大时为GCLOCK，访问多的条目多得几次机会（近似LFU）
+    4. 淘汰由一个后台维护线程完成：条目数超出容量一小批后被唤醒，时钟指针按桶顺序转动，
+       访问计数大于0的减一并跳过，为0的淘汰；写入过快、超出容量一定比例时写线程同步协助淘汰
+    5. 命中与未命中计数按线程槽位分开累加，读路径上没有跨核共享的写入
+读吞吐量随核数线性增长，代价是容量在淘汰跟上之前可能短暂超出，淘汰回调收到的是缓存值的副本。
+*/
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "CacheBase.h"
+#include "CacheEpoch.h"
+#include "CacheHash.h"
+#include "CacheStats.h"
+
+namespace CacheMgr {
+
+template <typename Key, typename Value, typename Hash = CacheHash<Key>>
+class ConcurrentClockCache : public CacheBase<Key, Value> {
+public:
+  /// @param capacity 容量
+  /// @param maxFrequency 访问计数的上限，1为CLOCK，更大时为GCLOCK
+  explicit ConcurrentClockCache(size_t capacity, uint8_t maxFrequency = 1)
+      : capacity_(static_cast<int64_t>(capacity)),
+        wakeLimit_(static_cast<int64_t>(capacity + std::max<size_t>(8, capacity / 64))),
+        hardLimit_(static_cast<int64_t>(capacity + std::max<size_t>(16, capacity / 32))),
+        maxFrequency_(std::max<uint8_t>(1, maxFrequency)), bucketShift_(64),
+        size_(0), hand_(0), pending_(false), stop_(false),
+        counters_(new Counter[EpochDomain::kSlots]) {
+    // 桶数量取不小于容量的2的幂，负载因子不超过1
+    size_t bucketNum = 1;
+    while (bucketNum < capacity) {
+      bucketNum <<= 1;
+      --bucketShift_;
+    }
+    bucketNum_ = bucketNum;
+    buckets_.reset(new std::atomic<Node *>[bucketNum]);
+    locks_.reset(new std::atomic<uint8_t>[bucketNum]);
+    for (size_t idx = 0; idx < bucketNum; ++idx) {
+      buckets_[idx].store(nullptr, std::memory_order_relaxed);
+      locks_[idx].store(0, std::memory_order_relaxed);
+    }
+    maintainer_ = std::thread(&ConcurrentClockCache::maintain, this);
+  }
+
+  ~ConcurrentClockCache() override {
+    {
+      std::lock_guard<std::mutex> lock(maintainMutex_);
+      stop_ = true;
+    }
+    maintained_.notify_one();
+    maintainer_.join();
+    for (size_t idx = 0; idx < bucketNum_; ++idx) {
+      Node *node = buckets_[idx].load(std::memory_order_relaxed);
+      while (nullptr != node) {
+        Node *next = node->next.load(std::memory_order_relaxed);
+        delete node;
+        node = next;
+      }
+    }
+  }
+
+  ConcurrentClockCache(const ConcurrentClockCache &) = delete;
+  ConcurrentClockCache &operator=(const ConcurrentClockCache &) = delete;
+
+  void put(const Key &key, const Value &val) override { putImpl(key, val); }
+
+  void put(const Key &key, Value &&val) override {
+    putImpl(key, std::move(val));
+  }
+
+  bool get(const Key &key, Value &val) override {
+    EpochGuard guard(domain_);
+    Node *node = find(key);
+    if (nullptr == node) {
+      countLookup(guard.slot(), false);
+      return false;
+    }
+    touch(node);
+    val = node->val;
+    countLookup(guard.slot(), true);
+    return true;
+  }
+
+  Value get(const Key &key) override {
+    Value val{};
+    get(key, val);
+    return val;
+  }
+
+  // 命中时直接读取节点中的缓存值，不加锁也不复制；节点在visitor返回之前不会被释放
+  bool visit(const Key &key,
+             const std::function<void(const Value &)> &visitor) override {
+    EpochGuard guard(domain_);
+    Node *node = find(key);
+    if (nullptr == node) {
+      countLookup(guard.slot(), false);
+      return false;
+    }
+    touch(node);
+    countLookup(guard.slot(), true);
+    visitor(node->val);
+    return true;
+  }
+
+  // 删除指定缓存
+  void remove(const Key &key) {
+    uint64_t hash = hashOf(key);
+    size_t bucket = bucketOf(hash);
+    Node *removed = nullptr;
+    {
+      BucketLock lock(locks_[bucket]);
+      std::atomic<Node *> *link = &buckets_[bucket];
+      Node *node = link->load(std::memory_order_relaxed);
+      while (nullptr != node && !(node->hash == hash && node->key == key)) {
+        link = &node->next;
+        node = link->load(std::memory_order_relaxed);
+      }
+      if (nullptr == node) {
+        return;
+      }
+      link->store(node->next.load(std::memory_order_relaxed),
+                  std::memory_order_seq_cst);
+      removed = node;
+    }
+    size_.fetch_sub(1, std::memory_order_relaxed);
+    retire(removed);
+  }
+
+  // 清空缓存，逐个桶摘下整条链表
+  void purge() {
+    for (size_t idx = 0; idx < bucketNum_; ++idx) {
+      Node *chain = nullptr;
+      {
+        BucketLock lock(locks_[idx]);
+        chain = buckets_[idx].exchange(nullptr, std::memory_order_seq_cst);
+      }
+      while (nullptr != chain) {
+        Node *next = chain->next.load(std::memory_order_relaxed);
+        size_.fetch_sub(1, std::memory_order_relaxed);
+        retire(chain);
+        chain = next;
+      }
+    }
+  }
+
+  // 当前条目数，淘汰跟上之前可能略超出容量
+  size_t size() const {
+    int64_t size = size_.load(std::memory_order_relaxed);
+    return size > 0 ? static_cast<size_t>(size) : 0;
+  }
+
+  size_t capacity() const { return static_cast<size_t>(capacity_); }
+
+  // 设置容量淘汰的回调，需在并发访问开始之前调用；回调在后台维护线程或协助淘汰的写线程中、
+  // 桶锁之外执行，收到的是缓存值的副本
+  void setEvictionListener(
+      typename CacheBase<Key, Value>::EvictionListener listener) {
+    std::lock_guard<std::mutex> lock(handMutex_);
+    evictionListener_ = std::move(listener);
+  }
+
+  CacheStats stats() const override {
+    CacheStats stats = stats_.snapshot();
+    for (size_t idx = 0; idx < EpochDomain::kSlots; ++idx) {
+      stats.hits += counters_[idx].hits.load(std::memory_order_relaxed);
+      stats.misses += counters_[idx].misses.load(std::memory_order_relaxed);
+    }
+    return stats;
+  }
+
+private:
+  // 维护线程在没有淘汰任务时回收节点的间隔
+  static constexpr std::chrono::milliseconds kMaintainInterval{50};
+  // 写线程槽位中待回收节点达到该数量时顺手回收一次，积压未消时每再积累这么多才回收一次，
+  // 必须是2的幂
+  static constexpr size_t kReclaimThreshold = 256;
+
+  struct Node {
+    template <typename V>
+    Node(uint64_t h, const Key &k, V &&v)
+        : hash(h), key(k), val(std::forward<V>(v)), next(nullptr), freq(0) {}
+
+    const uint64_t hash;      // 关键字哈希
+    const Key key;            // 关键字
+    const Value val;          // 缓存值，发布后不再修改
+    std::atomic<Node *> next; // 桶内下一个节点
+    std::atomic<uint8_t> freq; // 访问计数
+  };
+
+  // 每个线程槽位独占一个缓存行的命中计数
+  struct alignas(64) Counter {
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+  };
+
+  // 记录一次命中或未命中，读穿加载者的再次查找不计入
+  void countLookup(size_t slot, bool hit) {
+    if (StatsRecorder::countsLookup()) {
+      (hit ? counters_[slot].hits : counters_[slot].misses)
+          .fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  // 桶上的自旋锁，等待过久时让出CPU
+  class BucketLock {
+  public:
+    explicit BucketLock(std::atomic<uint8_t> &flag) : flag_(flag) {
+      for (unsigned spins = 0;
+           0 != flag_.exchange(1, std::memory_order_acquire); ++spins) {
+        while (0 != flag_.load(std::memory_order_relaxed)) {
+          if (++spins > 64) {
+            std::this_thread::yield();
+          }
+        }
+      }
+    }
+    ~BucketLock() { flag_.store(0, std::memory_order_release); }
+
+  private:
+    std::atomic<uint8_t> &flag_;
+  };
+
+  static uint64_t hashOf(const Key &key) {
+    return static_cast<uint64_t>(Hash{}(key));
+  }
+
+  size_t bucketOf(uint64_t hash) const {
+    return 64 == bucketShift_ ? 0 : static_cast<size_t>(hash >> bucketShift_);
+  }
+
+  // 在临界区内查找节点，不加锁
+  Node *find(const Key &key) const {
+    uint64_t hash = hashOf(key);
+    Node *node = buckets_[bucketOf(hash)].load(std::memory_order_seq_cst);
+    while (nullptr != node && !(node->hash == hash && node->key == key)) {
+      node = node->next.load(std::memory_order_seq_cst);
+    }
+    return node;
+  }
+
+  // 访问计数加一，已达上限时不写，热点条目的缓存行不会在读线程之间来回传递
+  void touch(Node *node) const {
+    uint8_t freq = node->freq.load(std::memory_order_relaxed);
+    if (freq < maxFrequency_) {
+      node->freq.store(static_cast<uint8_t>(freq + 1), std::memory_order_relaxed);
+    }
+  }
+
+  template <typename V> void putImpl(const Key &key, V &&val) {
+    if (0 == capacity_) {
+      return;
+    }
+    stats_.add(StatsRecorder::Put);
+    uint64_t hash = hashOf(key);
+    size_t bucket = bucketOf(hash);
+    Node *fresh = new Node(hash, key, std::forward<V>(val)); // 锁外构造
+    Node *replaced = nullptr;
+    {
+      BucketLock lock(locks_[bucket]);
+      std::atomic<Node *> *link = &buckets_[bucket];
+      Node *node = link->load(std::memory_order_relaxed);
+      while (nullptr != node && !(node->hash == hash && node->key == key)) {
+        link = &node->next;
+        node = link->load(std::memory_order_relaxed);
+      }
+      if (nullptr != node) {
+        // 已在缓存中，整节点替换并视为一次访问
+        uint8_t freq = node->freq.load(std::memory_order_relaxed);
+        fresh->freq.store(std::min<uint8_t>(freq + 1, maxFrequency_),
+                          std::memory_order_relaxed);
+        fresh->next.store(node->next.load(std::memory_order_relaxed),
+                          std::memory_order_relaxed);
+        replaced = node;
+      }
+      link->store(fresh, std::memory_order_seq_cst);
+    }
+    if (nullptr != replaced) {
+      retire(replaced);
+      return;
+    }
+    int64_t size = size_.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (size > hardLimit_) {
+      evictToCapacity(); // 淘汰跟不上写入，写线程协助
+    } else if (size > wakeLimit_ && !pending_.load(std::memory_order_relaxed) &&
+               !pending_.exchange(true, std::memory_order_relaxed)) {
+      std::lock_guard<std::mutex> lock(maintainMutex_);
+      maintained_.notify_one();
+    }
+  }
+
+  // 节点摘除后交给回收域，本线程槽位积压过多时顺手回收；读线程长时间停在临界区时
+  // 一次回收释放不了多少，只在积压数每跨过一个阈值的整数倍时回收，不是每次摘除都扫描槽位
+  void retire(Node *node) {
+    size_t pending = domain_.retire(node);
+    if (pending >= kReclaimThreshold && 0 == (pending & (kReclaimThreshold - 1))) {
+      domain_.reclaim(false);
+    }
+  }
+
+  // 后台维护线程：超出容量时淘汰，空闲时定期回收节点
+  void maintain() {
+    std::unique_lock<std::mutex> lock(maintainMutex_);
+    while (!stop_) {
+      maintained_.wait_for(lock, kMaintainInterval, [this] {
+        return stop_ || pending_.load(std::memory_order_relaxed);
+      });
+      if (stop_) {
+        break;
+      }
+      lock.unlock();
+      pending_.store(false, std::memory_order_relaxed); // 之后的写入超出容量时会再次唤醒
+      evictToCapacity();
+      domain_.reclaim();
+      lock.lock();
+    }
+  }
+
+  // 转动时钟指针淘汰到容量以内
+  void evictToCapacity() {
+    std::lock_guard<std::mutex> lock(handMutex_);
+    EpochGuard guard(domain_); // 淘汰回调读取的节点在回调结束前不会被释放
+    std::vector<Node *> victims;
+    // 转过(访问计数上限+1)圈仍淘汰不到时停止，防止空表上空转
+    size_t idle = 0;
+    size_t maxIdle = bucketNum_ * (static_cast<size_t>(maxFrequency_) + 1);
+    while (size_.load(std::memory_order_relaxed) > capacity_ && idle < maxIdle) {
+      victims.clear();
+      sweepBucket(hand_, victims);
+      hand_ = (hand_ + 1) & (bucketNum_ - 1);
+      idle = victims.empty() ? idle + 1 : 0;
+      for (Node *victim : victims) {
+        stats_.add(StatsRecorder::Eviction);
+        if (evictionListener_) {
+          evictionListener_(victim->key, Value(victim->val));
+        }
+        retire(victim);
+      }
+    }
+  }
+
+  // 扫过一个桶：访问计数大于0的减一，为0的摘除，直到回到容量以内
+  void sweepBucket(size_t bucket, std::vector<Node *> &victims) {
+    BucketLock lock(locks_[bucket]);
+    std::atomic<Node *> *link = &buckets_[bucket];
+    Node *node = link->load(std::memory_order_relaxed);
+    while (nullptr != node) {
+      Node *next = node->next.load(std::memory_order_relaxed);
+      uint8_t freq = node->freq.load(std::memory_order_relaxed);
+      if (0 != freq) {
+        node->freq.store(static_cast<uint8_t>(freq - 1), std::memory_order_relaxed);
+        link = &node->next;
+      } else if (size_.load(std::memory_order_relaxed) > capacity_) {
+        link->store(next, std::memory_order_seq_cst);
+        size_.fetch_sub(1, std::memory_order_relaxed);
+        victims.push_back(node);
+      } else {
+        return;
+      }
+      node = next;
+    }
+  }
+
+private:
+  int64_t capacity_;      // 缓存容量
+  int64_t wakeLimit_;     // 超过该条目数时唤醒维护线程，攒够一批再唤醒，避免每次写入都切换线程
+  int64_t hardLimit_;     // 超过该条目数时写线程同步协助淘汰
+  uint8_t maxFrequency_;  // 访问计数上限
+  unsigned bucketShift_;  // 哈希值右移位数，取高位作为桶下标
+  size_t bucketNum_;      // 桶数量
+  std::unique_ptr<std::atomic<Node *>[]> buckets_; // 桶内首个节点
+  std::unique_ptr<std::atomic<uint8_t>[]> locks_;  // 桶上的自旋锁
+  alignas(64) std::atomic<int64_t> size_; // 条目数，只在插入与删除时修改
+  size_t hand_;                          // 时钟指针所在的桶
+  std::mutex handMutex_;                 // 保护时钟指针与淘汰回调
+  typename CacheBase<Key, Value>::EvictionListener evictionListener_;
+  std::atomic<bool> pending_;            // 已通知维护线程淘汰
+  bool stop_;                            // 析构时通知维护线程退出
+  std::mutex maintainMutex_;             // 保护stop_，配合maintained_
+  std::condition_variable maintained_;   // 唤醒维护线程
+  std::thread maintainer_;               // 后台维护线程
+  EpochDomain domain_;                   // 被摘除节点的回收域
+  std::unique_ptr<Counter[]> counters_;  // 按线程槽位分开的命中计数
+  StatsRecorder stats_;                  // 写入与淘汰的统计
+};
+
+} // namespace CacheMgr
\ No newline at end of file
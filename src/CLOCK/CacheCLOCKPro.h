@@ -0,0 +1,284 @@
+/*
+CLOCK-Pro:
+在CLOCK的基础上引入冷热分区与“测试期”，以接近ARC/LIRS的抗扫描能力（Jiang et al., 2005）。
+所有页面（常驻热页、常驻冷页、非常驻的测试页）按加入顺序挂在同一个环上，三根指针依次转动：
+    1. hand_cold：寻找淘汰对象。访问位为1的冷页升级为热页；访问位为0的冷页被淘汰，
+       只保留关键字作为测试页，值立即释放
+    2. hand_hot：热页超过热区目标时转动，访问位为1的清零，访问位为0的降为冷页，
+       经过的测试页同样结束测试期
+    3. hand_test：测试页超过总容量时转动，移除测试期结束仍未被再次访问的测试页，
+       并缩小冷区目标
+    4. 自适应：测试页再次被写入说明冷区过小，冷区目标+1，并直接作为热页加入；
+       测试页到期未被访问则冷区目标-1
+命中与CLOCK相同，只设置访问位，读路径只需共享锁；环使用槽位数组上的下标链表，不做堆分配。
+*/
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <utility>
+#include <vector>
+
+#include "CacheBase.h"
+#include "CacheFlatMap.h"
+
+namespace CacheMgr {
+
+template <typename Key, typename Value,
+          template <typename, typename> class Index = CacheIndexMap>
+class ClockProCache : public CacheBase<Key, Value> {
+public:
+  using IndexMap = Index<Key, uint32_t>;
+
+  explicit ClockProCache(int capacity)
+      : capacity_(capacity > 0 ? capacity : 0), coldTarget_(capacity_),
+        hotCount_(0), coldCount_(0), testCount_(0), handHot_(kNil),
+        handCold_(kNil), handTest_(kNil), freeHead_(kNil),
+        // 常驻页与测试页各不超过容量，另留一个槽位给淘汰前的新页
+        pages_(2 * capacity_ + 1),
+        refBits_(new std::atomic<uint8_t>[2 * capacity_ + 1]) {
+    for (size_t idx = pages_.size(); idx > 0; --idx) {
+      pages_[idx - 1].next = freeHead_;
+      freeHead_ = static_cast<uint32_t>(idx - 1);
+      refBits_[idx - 1].store(0, std::memory_order_relaxed);
+    }
+    index_.reserve(pages_.size());
+  }
+
+  ~ClockProCache() override = default;
+
+  void put(const Key &key, const Value &val) override { putImpl(key, val); }
+
+  void put(const Key &key, Value &&val) override {
+    putImpl(key, std::move(val));
+  }
+
+  bool get(const Key &key, Value &val) override {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto it = index_.find(key);
+    if (it == index_.end() || PageType::Test == pages_[it->second].type) {
+      stats_.add(StatsRecorder::Miss);
+      return false;
+    }
+    stats_.add(StatsRecorder::Hit);
+    refBits_[it->second].store(1, std::memory_order_relaxed);
+    val = pages_[it->second].val;
+    return true;
+  }
+
+  // 命中时在共享锁内直接读取缓存值，不产生复制
+  bool visit(const Key &key,
+             const std::function<void(const Value &)> &visitor) override {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto it = index_.find(key);
+    if (it == index_.end() || PageType::Test == pages_[it->second].type) {
+      stats_.add(StatsRecorder::Miss);
+      return false;
+    }
+    stats_.add(StatsRecorder::Hit);
+    refBits_[it->second].store(1, std::memory_order_relaxed);
+    visitor(pages_[it->second].val);
+    return true;
+  }
+
+  Value get(const Key &key) override {
+    Value val{};
+    get(key, val);
+    return val;
+  }
+
+  CacheStats stats() const override { return stats_.snapshot(); }
+
+private:
+  template <typename V> void putImpl(const Key &key, V &&val) {
+    if (0 == capacity_) {
+      return;
+    }
+    TimedLockGuard<std::shared_mutex> lock(mutex_, stats_);
+    stats_.add(StatsRecorder::Put);
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+      // 首次出现，作为冷页加入
+      addPage(key, std::forward<V>(val), PageType::Cold);
+      ++coldCount_;
+      return;
+    }
+    uint32_t idx = it->second;
+    Page &page = pages_[idx];
+    if (PageType::Test != page.type) {
+      // 常驻页，更新值并视为一次访问
+      page.val = std::forward<V>(val);
+      refBits_[idx].store(1, std::memory_order_relaxed);
+      return;
+    }
+    // 测试期内再次访问，说明冷区过小
+    stats_.add(StatsRecorder::GhostHit);
+    if (coldTarget_ < capacity_) {
+      ++coldTarget_;
+    }
+    --testCount_;
+    removePage(idx);
+    addPage(key, std::forward<V>(val), PageType::Hot);
+    ++hotCount_;
+  }
+
+  enum class PageType : uint8_t {
+    Hot,  // 常驻热页
+    Cold, // 常驻冷页
+    Test, // 非常驻的测试页，只保留关键字
+  };
+
+  struct Page {
+    Key key;       // 关键字
+    Value val;     // 缓存值，测试页为空
+    uint32_t prev; // 环上的前一页
+    uint32_t next; // 环上的后一页（空闲时串联空闲链表）
+    PageType type; // 页面类型
+  };
+
+  static constexpr uint32_t kNil = UINT32_MAX;
+
+  // 在hand_hot之前（即环的最新位置）加入新页
+  template <typename V> void addPage(const Key &key, V &&val, PageType type) {
+    evict();
+    uint32_t idx = freeHead_;
+    freeHead_ = pages_[idx].next;
+    Page &page = pages_[idx];
+    page.key = key;
+    page.val = std::forward<V>(val);
+    page.type = type;
+    refBits_[idx].store(0, std::memory_order_relaxed);
+    index_[key] = idx;
+
+    if (kNil == handHot_) {
+      page.prev = page.next = idx;
+      handHot_ = handCold_ = handTest_ = idx;
+      return;
+    }
+    page.next = handHot_;
+    page.prev = pages_[handHot_].prev;
+    pages_[page.prev].next = idx;
+    pages_[handHot_].prev = idx;
+    if (handCold_ == handHot_) {
+      handCold_ = idx;
+    }
+  }
+
+  // 从环上摘除页面并归还空闲链表
+  void removePage(uint32_t idx) {
+    Page &page = pages_[idx];
+    index_.erase(page.key);
+    if (page.next == idx) {
+      handHot_ = handCold_ = handTest_ = kNil;
+    } else {
+      // 指针指向被摘除的页时退回前一页，转动时从下一页继续
+      if (handHot_ == idx) {
+        handHot_ = page.prev;
+      }
+      if (handCold_ == idx) {
+        handCold_ = page.prev;
+      }
+      if (handTest_ == idx) {
+        handTest_ = page.prev;
+      }
+      pages_[page.prev].next = page.next;
+      pages_[page.next].prev = page.prev;
+    }
+    page.val = Value();
+    page.next = freeHead_;
+    freeHead_ = idx;
+  }
+
+  // 常驻页达到容量时转动hand_cold腾出空间
+  void evict() {
+    while (hotCount_ + coldCount_ >= capacity_) {
+      runHandCold();
+      // 冷页升级可能让热区超出目标，淘汰产生的测试页可能超出容量，
+      // 各自转动对应指针收敛；三根指针互不递归调用，避免栈深度失控
+      while (hotCount_ > capacity_ - coldTarget_) {
+        runHandHot();
+      }
+      while (testCount_ > capacity_) {
+        runHandTest();
+      }
+    }
+  }
+
+  void runHandCold() {
+    uint32_t idx = handCold_;
+    Page &page = pages_[idx];
+    if (PageType::Cold == page.type) {
+      --coldCount_;
+      if (refBits_[idx].load(std::memory_order_relaxed)) {
+        // 冷页在测试期内被访问，升级为热页
+        page.type = PageType::Hot;
+        refBits_[idx].store(0, std::memory_order_relaxed);
+        ++hotCount_;
+      } else {
+        // 淘汰冷页，释放值，保留关键字进入测试期
+        page.type = PageType::Test;
+        page.val = Value();
+        ++testCount_;
+        stats_.add(StatsRecorder::Eviction);
+      }
+    }
+    handCold_ = pages_[handCold_].next;
+  }
+
+  void runHandHot() {
+    uint32_t idx = handHot_;
+    Page &page = pages_[idx];
+    if (PageType::Hot == page.type) {
+      if (refBits_[idx].load(std::memory_order_relaxed)) {
+        refBits_[idx].store(0, std::memory_order_relaxed);
+      } else {
+        page.type = PageType::Cold;
+        --hotCount_;
+        ++coldCount_;
+      }
+    } else if (PageType::Test == page.type) {
+      // hand_hot经过的测试页同样结束测试期
+      expireTest(idx);
+    }
+    handHot_ = pages_[handHot_].next;
+  }
+
+  void runHandTest() {
+    uint32_t idx = handTest_;
+    if (PageType::Test == pages_[idx].type) {
+      expireTest(idx);
+    }
+    handTest_ = pages_[handTest_].next;
+  }
+
+  // 测试期结束仍未被访问，移除测试页并缩小冷区目标
+  void expireTest(uint32_t idx) {
+    removePage(idx);
+    --testCount_;
+    if (coldTarget_ > 1) {
+      --coldTarget_;
+    }
+  }
+
+private:
+  size_t capacity_;   // 常驻页容量
+  size_t coldTarget_; // 冷区目标大小（自适应）
+  size_t hotCount_;   // 常驻热页数量
+  size_t coldCount_;  // 常驻冷页数量
+  size_t testCount_;  // 测试页数量
+  uint32_t handHot_;  // 热页指针，同时也是环的最新位置
+  uint32_t handCold_; // 冷页指针
+  uint32_t handTest_; // 测试页指针
+  uint32_t freeHead_; // 空闲槽位链表头
+  std::shared_mutex mutex_; // 读写锁，读共享、写独占
+  IndexMap index_;          // 关键字到槽位的索引
+  std::vector<Page> pages_; // 页面槽位数组
+  std::unique_ptr<std::atomic<uint8_t>[]> refBits_; // 访问位
+  StatsRecorder stats_;     // 运行统计
+};
+
+} // namespace CacheMgr
\ No newline at end of file
@@ -26,226 +26,577 @@ LFU
 */
 #pragma once
 
+#include <functional>
+#include <limits>
 #include <memory>
 #include <mutex>
-#include <unordered_map>
+#include <utility>
+#include <vector>
 
+#include "CacheArena.h"
 #include "CacheBase.h"
+#include "CacheBatch.h"
+#include "CacheFlatMap.h"
+#include "CacheWeight.h"
 
 namespace CacheMgr {
 
-template <typename Key, typename Value> class LFUCache;
-template <typename Key, typename Value> class LFUAvgCache;
+template <typename Key, typename Value> class FreqListChain;
 
+// 同一访问频次的缓存节点链表（频次桶）
 template <typename Key, typename Value> class FreqList {
-private:
+public:
   struct LFUNode {
-    // 访问频次
-    int freq;
     // 键值，索引
     Key key;
     // 缓存值
     Value val;
+    // 所在的频次桶，节点的访问频次即桶的频次
+    FreqList *list;
     // 前置节点
-    std::shared_ptr<LFUNode> prev;
+    LFUNode *prev;
     // 后置节点
-    std::shared_ptr<LFUNode> next;
+    LFUNode *next;
 
-    LFUNode() : freq(1), prev(nullptr), next(nullptr) {}
+    LFUNode() : list(nullptr), prev(nullptr), next(nullptr) {}
     LFUNode(Key key, Value val)
-        : freq(1), key(key), val(val), prev(nullptr), next(nullptr) {}
+        : key(std::move(key)), val(std::move(val)), list(nullptr),
+          prev(nullptr), next(nullptr) {}
+
+    // 访问频次
+    int freq() const { return list ? list->freq_ : 0; }
   };
 
-public:
-  using NodePtr = std::shared_ptr<LFUNode>;
+  using NodePtr = LFUNode *;
 
-  explicit FreqList(int count) : freq_(count) { initializeList(); }
+  explicit FreqList(int count)
+      : freq_(count), size_(0), head_(nullptr), tail_(nullptr),
+        prevList_(nullptr), nextList_(nullptr) {}
 
   virtual ~FreqList() = default;
 
   // 缓存序列是否为空判断
-  bool isEmpty() const {
-    return (dummyHead_ && dummyTail_) ? dummyHead_->next == dummyTail_ : true;
-  }
+  bool isEmpty() const { return 0 == size_; }
+
+  // 节点数量
+  size_t size() const { return size_; }
+
+  // 访问频率
+  int getFreq() const { return freq_; }
 
-  // 添加缓存节点
+  // 在末尾添加缓存节点
   void addNode(NodePtr node) {
-    if (!node || !dummyHead_ || !dummyTail_) {
-      return;
+    node->list = this;
+    node->prev = tail_;
+    node->next = nullptr;
+    if (tail_) {
+      tail_->next = node;
+    } else {
+      head_ = node;
     }
-
-    node->prev = dummyTail_->prev;
-    node->next = dummyTail_;
-    dummyTail_->prev->next = node;
-    dummyTail_->prev = node;
+    tail_ = node;
+    ++size_;
   }
 
   // 删除缓存节点
   void removeNode(NodePtr node) {
-    if (!node || !dummyHead_ || !dummyTail_) {
-      return;
+    if (node->prev) {
+      node->prev->next = node->next;
+    } else {
+      head_ = node->next;
     }
-
-    if (!node->prev || !node->next) {
-      return;
+    if (node->next) {
+      node->next->prev = node->prev;
+    } else {
+      tail_ = node->prev;
     }
-
-    auto prev = node->prev;
-    prev->next = node->next;
-    node->next->prev = prev;
     node->prev = nullptr;
     node->next = nullptr;
+    node->list = nullptr;
+    --size_;
   }
 
-  // 获取第首个缓存节点
-  NodePtr getFirstNode() const { return dummyHead_->next; }
-
-private:
-  // 缓存初始化
-  void initializeList() {
-    dummyHead_ = std::make_shared<LFUNode>();
-    dummyTail_ = std::make_shared<LFUNode>();
-    dummyHead_->next = dummyTail_;
-    dummyTail_->prev = dummyHead_;
-  }
+  // 获取首个（最早加入的）缓存节点
+  NodePtr getFirstNode() const { return head_; }
 
 private:
   // 访问频率
   int freq_;
-  // 虚假的头部缓存节点
-  NodePtr dummyHead_;
-  // 虚假的末尾缓存节点
-  NodePtr dummyTail_;
+  // 节点数量
+  size_t size_;
+  // 首个缓存节点
+  NodePtr head_;
+  // 末尾缓存节点
+  NodePtr tail_;
+  // 频次更低的相邻频次桶
+  FreqList *prevList_;
+  // 频次更高的相邻频次桶
+  FreqList *nextList_;
+
+public:
+  friend class FreqListChain<Key, Value>;
+};
 
+/*
+FreqListChain:
+按频次升序串联的频次桶双向链表，每个节点直接指向所在的频次桶：
+    1. 最小频次即链表首个频次桶，不再需要维护minFreq并查找频次映射
+    2. 频次+1时只需检查相邻的下一个频次桶，不做任何哈希查找
+    3. 清空的频次桶回收到对象池，桶的出现与消失不再new/delete
+另外维护一条频次水位线floor_：频次低于水位线的频次桶视为已完全老化，
+惰性老化时只需抬高水位线，新节点与已老化节点的提升都落在水位线附近。
+所有操作均为O(1)，本类不加锁，由外层缓存负责同步。
+*/
+template <typename Key, typename Value> class FreqListChain {
 public:
-  friend class LFUCache<Key, Value>;
-  friend class LFUAvgCache<Key, Value>;
+  using ListType = FreqList<Key, Value>;
+  using NodePtr = typename ListType::NodePtr;
+
+  FreqListChain()
+      : head_(nullptr), tail_(nullptr), freeLists_(nullptr), floor_(nullptr),
+        floorFreq_(std::numeric_limits<int>::min()), belowFloor_(0) {}
+
+  FreqListChain(const FreqListChain &) = delete;
+  FreqListChain &operator=(const FreqListChain &) = delete;
+
+  bool isEmpty() const { return nullptr == head_; }
+
+  // 最小频次的频次桶
+  ListType *front() const { return head_; }
+
+  // 淘汰顺序中第一个不是kept的节点：最小频次桶中最早加入的，kept恰好在此时取它之后的节点
+  NodePtr firstExcept(NodePtr kept) const {
+    NodePtr node = head_ ? head_->getFirstNode() : nullptr;
+    if (node != kept) {
+      return node;
+    }
+    if (kept->next) {
+      return kept->next;
+    }
+    return head_->nextList_ ? head_->nextList_->getFirstNode() : nullptr;
+  }
+
+  // 最小访问频次，为空时返回0
+  int minFreq() const { return head_ ? head_->freq_ : 0; }
+
+  // 低于水位线的节点数量
+  size_t belowFloorNum() const { return belowFloor_; }
+
+  // 以指定频次加入新节点，频次不能高于当前最小频次
+  void addFresh(NodePtr node, int freq) {
+    if (!head_ || head_->freq_ != freq) {
+      linkAfter(nullptr, acquire(freq));
+    }
+    attach(head_, node);
+  }
+
+  // 节点访问频次+1，移动到相邻的下一个频次桶
+  void promote(NodePtr node) { moveTo(node, node->list->freq_ + 1); }
+
+  // 将节点移动到指定频次，频次不能低于当前频次且不能越过下一个频次桶
+  void moveTo(NodePtr node, int freq) {
+    ListType *list = node->list;
+    if (list->freq_ == freq) {
+      return;
+    }
+    ListType *next = list->nextList_;
+    if (1 == list->size() && (!next || next->freq_ != freq) &&
+        (list->freq_ >= floorFreq_ || freq < floorFreq_)) {
+      list->freq_ = freq; // 唯一节点直接改写所在桶的频次
+      return;
+    }
+    if (!next || next->freq_ != freq) {
+      next = acquire(freq);
+      linkAfter(list, next);
+    }
+    detach(node);
+    attach(next, node);
+  }
+
+  // 将节点（新节点或已老化节点）放到水位线处，freq只能是水位线频次或其+1
+  void placeNearFloor(NodePtr node, int freq) {
+    if (node->list) {
+      detach(node);
+    }
+    ListType *list = floor_;
+    if (list && list->freq_ < freq) {
+      list = list->nextList_;
+    }
+    if (!list || list->freq_ != freq) {
+      ListType *fresh = acquire(freq);
+      linkAfter(list ? list->prevList_ : tail_, fresh);
+      list = fresh;
+    }
+    attach(list, node);
+  }
+
+  // 按频次非降序批量加入节点：hint为上一个节点所在的频次桶（首个节点传nullptr），
+  // 从它开始向后查找位置，整批加入的总开销与节点数加频次桶数成正比；返回节点所在的频次桶
+  ListType *insertSorted(NodePtr node, int freq, ListType *hint) {
+    ListType *prev = hint && hint->freq_ <= freq ? hint : nullptr;
+    ListType *next = prev ? prev->nextList_ : head_;
+    while (next && next->freq_ <= freq) {
+      prev = next;
+      next = next->nextList_;
+    }
+    if (!prev || prev->freq_ != freq) {
+      ListType *list = acquire(freq);
+      linkAfter(prev, list);
+      prev = list;
+    }
+    attach(prev, node);
+    return prev;
+  }
+
+  // 将节点从频次桶链表中移除
+  void remove(NodePtr node) { detach(node); }
+
+  // 抬高水位线，每个越过水位线的频次桶回调一次onCrossed
+  template <typename Fn> void raiseFloor(int freq, Fn &&onCrossed) {
+    floorFreq_ = freq;
+    while (floor_ && floor_->freq_ < freq) {
+      onCrossed(*floor_);
+      belowFloor_ += floor_->size();
+      floor_ = floor_->nextList_;
+    }
+  }
+
+  // 重新设置水位线，需要从头遍历，仅用于低频的整体调整
+  void resetFloor(int freq) {
+    floorFreq_ = freq;
+    floor_ = head_;
+    belowFloor_ = 0;
+    while (floor_ && floor_->freq_ < freq) {
+      belowFloor_ += floor_->size();
+      floor_ = floor_->nextList_;
+    }
+  }
+
+  // 按单调不减的映射重新计算所有频次桶的频次，映射后频次相同的桶合并
+  template <typename Fn> void relabel(Fn &&fn) {
+    ListType *list = head_;
+    while (list) {
+      ListType *next = list->nextList_;
+      list->freq_ = fn(list->freq_);
+      ListType *prev = list->prevList_;
+      if (prev && prev->freq_ == list->freq_) {
+        // 合并到频次更低的桶末尾，原本频次更低的节点仍然先被淘汰
+        while (NodePtr node = list->getFirstNode()) {
+          list->removeNode(node);
+          prev->addNode(node);
+        }
+        release(list);
+      }
+      list = next;
+    }
+    resetFloor(floorFreq_);
+  }
+
+  // 按频次升序遍历所有频次桶
+  template <typename Fn> void forEachList(Fn &&fn) const {
+    for (ListType *list = head_; list; list = list->nextList_) {
+      fn(*list);
+    }
+  }
+
+  // 清空所有频次桶，节点由调用方释放
+  void clear() {
+    while (head_) {
+      ListType *list = head_;
+      while (NodePtr node = list->getFirstNode()) {
+        list->removeNode(node);
+      }
+      release(list);
+    }
+    belowFloor_ = 0;
+  }
+
+private:
+  // 节点挂入指定频次桶
+  void attach(ListType *list, NodePtr node) {
+    list->addNode(node);
+    if (list->freq_ < floorFreq_) {
+      ++belowFloor_;
+    }
+  }
+
+  // 节点摘出所在频次桶，桶为空时回收
+  void detach(NodePtr node) {
+    ListType *list = node->list;
+    if (list->freq_ < floorFreq_) {
+      --belowFloor_;
+    }
+    list->removeNode(node);
+    if (list->isEmpty()) {
+      release(list);
+    }
+  }
+
+  // 从对象池获取一个频次桶
+  ListType *acquire(int freq) {
+    ListType *list = freeLists_;
+    if (list) {
+      freeLists_ = list->nextList_;
+      list->freq_ = freq;
+      list->nextList_ = nullptr;
+    } else {
+      lists_.emplace_back(new ListType(freq));
+      list = lists_.back().get();
+    }
+    return list;
+  }
+
+  // 将空频次桶从链表中摘除并归还对象池
+  void release(ListType *list) {
+    if (list == floor_) {
+      floor_ = list->nextList_;
+    }
+    if (list->prevList_) {
+      list->prevList_->nextList_ = list->nextList_;
+    } else {
+      head_ = list->nextList_;
+    }
+    if (list->nextList_) {
+      list->nextList_->prevList_ = list->prevList_;
+    } else {
+      tail_ = list->prevList_;
+    }
+    list->prevList_ = nullptr;
+    list->nextList_ = freeLists_;
+    freeLists_ = list;
+  }
+
+  // 在prev之后挂入频次桶，prev为空时挂在链表头部
+  void linkAfter(ListType *prev, ListType *list) {
+    ListType *next = prev ? prev->nextList_ : head_;
+    list->prevList_ = prev;
+    list->nextList_ = next;
+    if (next) {
+      next->prevList_ = list;
+    } else {
+      tail_ = list;
+    }
+    if (prev) {
+      prev->nextList_ = list;
+    } else {
+      head_ = list;
+    }
+    // 紧挨在水位线之前且不低于水位线的新桶成为新的水位线
+    if (next == floor_ && list->freq_ >= floorFreq_) {
+      floor_ = list;
+    }
+  }
+
+private:
+  // 最小频次的频次桶
+  ListType *head_;
+  // 最大频次的频次桶
+  ListType *tail_;
+  // 空闲频次桶链表（复用nextList_串联）
+  ListType *freeLists_;
+  // 首个频次不低于水位线的频次桶
+  ListType *floor_;
+  // 水位线频次
+  int floorFreq_;
+  // 低于水位线的节点数量
+  size_t belowFloor_;
+  // 频次桶对象池，持有所有频次桶的所有权
+  std::vector<std::unique_ptr<ListType>> lists_;
 };
 
-template <typename Key, typename Value>
+// Arena为节点与索引节点的分配方式，默认使用全局堆，可选用SlabArena
+template <typename Key, typename Value,
+          template <typename, typename> class Index = CacheIndexMap,
+          typename Arena = HeapArena>
 class LFUCache : public CacheBase<Key, Value> {
 public:
   using Node = typename FreqList<Key, Value>::LFUNode;
   using NodePtr = typename FreqList<Key, Value>::NodePtr;
-  using NodeMap = std::unordered_map<Key, NodePtr>;
+  using NodeIndex = ArenaIndex<Index, Key, ArenaPtr<Node, Arena>, Arena>;
+  using NodeMap = typename NodeIndex::type;
+
+  explicit LFUCache(int capacity)
+      : capacity_(capacity), cacheMap_(NodeIndex::make(arena_)) {}
 
-  explicit LFUCache(int capacity) : capacity_(capacity), minFreq_(0) {}
+  // 按权重计容量：总权重不超过maxWeight，条目数不设上限
+  explicit LFUCache(size_t maxWeight, CacheWeigher<Key, Value> weigher)
+      : capacity_(std::numeric_limits<int>::max()),
+        cacheMap_(NodeIndex::make(arena_)),
+        budget_(maxWeight, std::move(weigher)) {}
 
   virtual ~LFUCache() override = default;
 
   // 添加缓存
   void put(const Key &key, const Value &val) override {
-    if (0 == capacity_) {
+    if (0 >= capacity_) {
       return; // No capacity to store new items
     }
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = cacheMap_.find(key);
-    if (it != cacheMap_.end()) {
-      // Key already exists, update value and frequency
-      it->second->val = val;
-    } else {
-      if (cacheMap_.size() >= capacity_ && minFreq_ > 0 &&
-          freqListMap_.find(minFreq_) != freqListMap_.end()) {
-        // Remove the least frequently used item
-        NodePtr node = freqListMap_.at(minFreq_)->getFirstNode();
-        removeNodeFromFreqList(node);
-        cacheMap_.erase(node->key);
-      }
-      // Create a new node and add it to the cache
-      NodePtr newNode = std::make_shared<Node>(key, val);
-      cacheMap_[key] = newNode;
-      minFreq_ = 1; // Reset minFreq to 1 for new node
-      addNodeToFreqList(newNode);
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    putLocked(key, val);
+  }
+
+  // 添加缓存，缓存值以移动方式存入
+  void put(const Key &key, Value &&val) override {
+    if (0 >= capacity_) {
+      return;
     }
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    putLocked(key, std::move(val));
   }
 
   // 访问缓存
   bool get(const Key &key, Value &val) override {
-    std::lock_guard<std::mutex> lock(mutex_);
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    return getLocked(key, val);
+  }
+
+  // 访问缓存，命中时在锁内直接读取缓存值，不产生复制
+  bool visit(const Key &key,
+             const std::function<void(const Value &)> &visitor) override {
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
     auto it = cacheMap_.find(key);
-    if (it != cacheMap_.end()) {
-      NodePtr node = it->second;
-      removeNodeFromFreqList(node);
-      ++node->freq;
-      /**
-       * 下面这个操作是为了防止当前 node对应的是最小频数双向链表里的唯一节点，
-       * 具体情况可分两种讨论
-       * 情况 ① 如果当前 node
-       * 对应的是最小频数双向链表里的唯一节点，那么在进行对其的get操作后，它的频数
-       * freq++， 原双向链表节点数目变为 0，则最小频数minFreq++，即执行这个 if
-       * 操作 情况 ② 如果当前 node
-       * 对应的不是最小频数双向链表里的唯一节点，那么无需更新 minFreq
-       */
-      if (freqListMap_.end() == freqListMap_.find(minFreq_) ||
-          freqListMap_.at(minFreq_)->isEmpty()) {
-        ++minFreq_;
-      }
-      addNodeToFreqList(node);
-      val = node->val;
-      return true;
+    if (it == cacheMap_.end()) {
+      stats_.add(StatsRecorder::Miss);
+      return false;
+    }
+    stats_.add(StatsRecorder::Hit);
+    NodePtr node = it->second.get();
+    freqLists_.promote(node);
+    visitor(node->val);
+    return true;
+  }
+
+  // 批量添加缓存，整批只加一次锁
+  void putBatch(const Key *keys, const Value *vals, const uint32_t *order,
+                size_t count) override {
+    if (0 >= capacity_) {
+      return;
+    }
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    for (size_t i = 0; i < count; ++i) {
+      size_t idx = detail::batchIndex(order, i);
+      putLocked(keys[idx], vals[idx]);
     }
-    return false;
+  }
+
+  // 批量访问缓存，整批只加一次锁；索引为FlatMap时提前预取后续关键字的探测组与节点
+  size_t getBatch(const Key *keys, const uint32_t *order, size_t count,
+                  Value *vals, bool *hits) override {
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    size_t hitNum = 0;
+    for (size_t i = 0; i < count; ++i) {
+      detail::prefetchLookup(
+          cacheMap_, keys, order, count, i,
+          [](const typename NodeMap::mapped_type &holder) { return holder.get(); });
+      size_t idx = detail::batchIndex(order, i);
+      hits[idx] = getLocked(keys[idx], vals[idx]);
+      hitNum += hits[idx] ? 1 : 0;
+    }
+    return hitNum;
   }
 
   // 访问缓存
   Value get(const Key &key) override {
-    Value val;
+    Value val{};
     get(key, val);
     return val;
   }
 
   // 清空缓存
   void purge() {
-    std::lock_guard<std::mutex> lock(mutex_);
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    freqLists_.clear();
     cacheMap_.clear();
-    freqListMap_.clear();
-    minFreq_ = 0; // Reset minFreq
+    budget_.clear();
   }
 
-private:
-  // 从频率列表中移除节点
-  void removeNodeFromFreqList(NodePtr node) {
-    if (!node || freqListMap_.end() == freqListMap_.find(node->freq)) {
-      return;
-    }
+  // 当前总权重，未按权重计容量时为0
+  size_t weight() {
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    return budget_.weight();
+  }
 
-    freqListMap_[node->freq]->removeNode(node);
+  CacheStats stats() const override { return stats_.snapshot(); }
 
-    if (freqListMap_.end() != freqListMap_.find(node->freq) &&
-        freqListMap_[node->freq]->getFirstNode() ==
-            freqListMap_[node->freq]->dummyTail_) {
-      // 如果当前频率列表为空，删除该频率列表
-      delete freqListMap_[node->freq];
-      freqListMap_.erase(node->freq);
-      if (minFreq_ == node->freq) {
-        minFreq_ = (freqListMap_.empty()) ? 0 : minFreq_ + 1;
+private:
+  template <typename V> void putLocked(const Key &key, V &&val) {
+    stats_.add(StatsRecorder::Put);
+    size_t weight = budget_.weigh(key, val);
+    auto it = cacheMap_.find(key);
+    NodePtr written;
+    if (it != cacheMap_.end()) {
+      if (!budget_.admits(weight)) {
+        removeNode(it->second.get()); // 新值超过整个预算，旧值也不再保留
+        return;
+      }
+      budget_.sub(budget_.weigh(key, it->second->val));
+      // Key already exists, update value and frequency
+      it->second->val = std::forward<V>(val);
+      written = it->second.get();
+    } else {
+      if (!budget_.admits(weight)) {
+        return;
       }
+      if (cacheMap_.size() >= capacity_) {
+        // Remove the least frequently used item
+        kickOut();
+      }
+      // Create a new node and add it to the lowest frequency list
+      auto &holder = cacheMap_[key];
+      holder = makeArenaPtr<Node>(arena_, key, std::forward<V>(val));
+      freqLists_.addFresh(holder.get(), 1);
+      written = holder.get();
+    }
+    budget_.add(weight);
+    // 超出权重预算时按淘汰顺序循环淘汰，直到回到预算以内；新节点在最小频次桶中，
+    // 淘汰时跳过它，否则会把刚写入的条目一并淘汰。预算只在还有其他节点时才会超出
+    while (budget_.over()) {
+      kickOut(written);
     }
   }
 
-  // 添加到频率列表
-  void addNodeToFreqList(NodePtr node) {
-    if (!node) {
-      return;
+  bool getLocked(const Key &key, Value &val) {
+    auto it = cacheMap_.find(key);
+    if (it != cacheMap_.end()) {
+      NodePtr node = it->second.get();
+      // 频次桶相邻串联，频次+1只涉及当前桶与下一个桶
+      freqLists_.promote(node);
+      val = node->val;
+      stats_.add(StatsRecorder::Hit);
+      return true;
     }
+    stats_.add(StatsRecorder::Miss);
+    return false;
+  }
 
-    if (freqListMap_.end() == freqListMap_.find(node->freq)) {
-      freqListMap_[node->freq] = new FreqList<Key, Value>(node->freq);
-    }
-    freqListMap_[node->freq]->addNode(node);
+  // 淘汰最小频次桶中最早加入的节点，跳过kept
+  void kickOut(NodePtr kept = nullptr) {
+    stats_.add(StatsRecorder::Eviction);
+    removeNode(freqLists_.firstExcept(kept));
+  }
+
+  // 删除节点，同时扣除其权重
+  void removeNode(NodePtr node) {
+    budget_.sub(budget_.weigh(node->key, node->val));
+    freqLists_.remove(node);
+    cacheMap_.erase(cacheMap_.find(node->key));
   }
 
 private:
   // 缓存容量
   int capacity_;
-  // 最小访问频率
-  int minFreq_;
   // 互斥锁
   std::mutex mutex_;
-  // 缓存映射表
+  // 节点与索引节点的分池，声明在映射表之前，最后析构
+  Arena arena_;
+  // 缓存映射表，持有节点的所有权
   NodeMap cacheMap_;
-  // 频率列表
-  std::unordered_map<int, FreqList<Key, Value> *> freqListMap_;
+  // 频次桶链表
+  FreqListChain<Key, Value> freqLists_;
+  // 权重预算，未设置weigher时不启用
+  WeightBudget<Key, Value> budget_;
+  // 运行统计
+  StatsRecorder stats_;
 };
 
 } // namespace CacheMgr
\ No newline at end of file
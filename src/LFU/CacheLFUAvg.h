@@ -11,148 +11,536 @@ LFU-K（Least Frequently Used Average）是一种改进的LFU算法，旨在解
 */
 #pragma once
 
+#include "CacheArena.h"
+#include "CacheBalance.h"
+#include "CacheHandle.h"
 #include "CacheLFU.h"
+#include "CacheSnapshot.h"
+#include "CacheTimerWheel.h"
+#include "CacheWeight.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <functional>
 #include <memory>
 #include <mutex>
-#include <unordered_map>
+#include <utility>
 
 namespace CacheMgr {
 
-template <typename Key, typename Value>
+// 平均访问频次超过上限时的老化方式
+enum class LFUAgingMode {
+  // 立即改写所有频次桶的频次，单次老化的开销与频次桶数量成正比
+  Sweep,
+  // 只累加全局衰减偏移量，节点被访问或淘汰时再按偏移量折算，均摊O(1)
+  Lazy,
+};
+
+// Arena为节点与索引节点的分配方式，默认使用全局堆；SlabArena时由本分片独占的内存池分配，
+// 淘汰之后的插入复用刚释放的节点内存
+template <typename Key, typename Value,
+          template <typename, typename> class Index = CacheIndexMap,
+          typename Arena = HeapArena>
 class LFUAvgCache : public CacheBase<Key, Value> {
 public:
   using Node = typename FreqList<Key, Value>::LFUNode;
   using NodePtr = typename FreqList<Key, Value>::NodePtr;
-  using NodeMap = std::unordered_map<Key, NodePtr>;
+  using NodeIndex = ArenaIndex<Index, Key, ArenaPtr<Node, Arena>, Arena>;
+  using NodeMap = typename NodeIndex::type;
+  using ExpiryWheel = TimerWheel<Key>;
+
+  explicit LFUAvgCache(int capacity, int maxAvgFreq = 1000000,
+                       LFUAgingMode agingMode = LFUAgingMode::Sweep)
+      : capacity_(capacity), maxAvgFreq_(maxAvgFreq), currentAvgFreq_(0),
+        currentTotalFreq_(0), agingMode_(agingMode), agingOffset_(0),
+        cacheMap_(NodeIndex::make(arena_)) {
+    resetAging();
+  }
 
-  explicit LFUAvgCache(int capacity, int maxAvgFreq = 1000000)
-      : capacity_(capacity), minFreq_(INT8_MAX), maxAvgFreq_(maxAvgFreq),
-        currentAvgFreq_(0), currentTotalFreq_(0) {}
+  // 按权重计容量：总权重不超过maxWeight，条目数不设上限
+  explicit LFUAvgCache(size_t maxWeight, CacheWeigher<Key, Value> weigher,
+                       int maxAvgFreq = 1000000,
+                       LFUAgingMode agingMode = LFUAgingMode::Sweep)
+      : LFUAvgCache(INT_MAX, maxAvgFreq, agingMode) {
+    budget_ = WeightBudget<Key, Value>(maxWeight, std::move(weigher));
+  }
 
   virtual ~LFUAvgCache() override = default;
 
   // 添加缓存
   void put(const Key& key, const Value& val) override {
-    if (0 == capacity_) {
+    if (0 >= capacity_) {
       return; // No capacity to store new items
     }
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = cacheMap_.find(key);
-    if (it != cacheMap_.end()) {
-      // Key already exists, update value and frequency
-      it->second->val = val;
-      // Move to most recent access
-      Value cur_val;
-      getInternal(it->second, cur_val);
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    putLocked(key, val);
+  }
+
+  // 添加缓存，缓存值以移动方式存入
+  void put(const Key& key, Value&& val) override {
+    if (0 >= capacity_) {
+      return;
+    }
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    putLocked(key, std::move(val));
+  }
+
+  // 添加缓存并设置存活时间，到期后不再命中；不带存活时间的put会清除之前设置的存活时间
+  void put(const Key& key, const Value& val, std::chrono::milliseconds ttl) {
+    if (0 >= capacity_) {
+      return;
+    }
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    putLocked(key, val, deadlineOf(ttl));
+  }
+
+  void put(const Key& key, Value&& val, std::chrono::milliseconds ttl) {
+    if (0 >= capacity_) {
       return;
     }
-    putInternal(key, val);
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    putLocked(key, std::move(val), deadlineOf(ttl));
   }
 
   // 访问缓存
   bool get(const Key& key, Value &val) override {
-    std::lock_guard<std::mutex> lock(mutex_);
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    return getLocked(key, val);
+  }
+
+  // 访问缓存，命中时在锁内直接读取缓存值，不产生复制
+  bool visit(const Key& key,
+             const std::function<void(const Value &)> &visitor) override {
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
     auto it = cacheMap_.find(key);
-    if (it != cacheMap_.end()) {
-      getInternal(it->second, val);
-      return true;
+    if (it == cacheMap_.end() || expireIfDue(it->second.get())) {
+      stats_.add(StatsRecorder::Miss);
+      return false;
+    }
+    stats_.add(StatsRecorder::Hit);
+    touchInternal(it->second.get());
+    visitor(it->second->val);
+    return true;
+  }
+
+  // 批量添加缓存，整批只加一次锁
+  void putBatch(const Key *keys, const Value *vals, const uint32_t *order,
+                size_t count) override {
+    if (0 >= capacity_) {
+      return;
+    }
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    for (size_t i = 0; i < count; ++i) {
+      size_t idx = detail::batchIndex(order, i);
+      putLocked(keys[idx], vals[idx]);
     }
-    return false;
+  }
+
+  // 批量访问缓存，整批只加一次锁；索引为FlatMap时提前预取后续关键字的探测组与节点
+  size_t getBatch(const Key *keys, const uint32_t *order, size_t count,
+                  Value *vals, bool *hits) override {
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    size_t hitNum = 0;
+    for (size_t i = 0; i < count; ++i) {
+      detail::prefetchLookup(
+          cacheMap_, keys, order, count, i,
+          [](const typename NodeMap::mapped_type &holder) { return holder.get(); });
+      size_t idx = detail::batchIndex(order, i);
+      hits[idx] = getLocked(keys[idx], vals[idx]);
+      hitNum += hits[idx] ? 1 : 0;
+    }
+    return hitNum;
   }
 
   // 访问缓存
   Value get(const Key& key) override {
-    Value val;
+    Value val{};
     get(key, val);
     return val;
   }
 
   // 清空缓存
   virtual void purge() {
-    std::lock_guard<std::mutex> lock(mutex_);
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    releaseShare();
+    freqLists_.clear();
     cacheMap_.clear();
-    freqListMap_.clear();
-    minFreq_ = INT8_MAX; // Reset minFreq
     currentAvgFreq_ = 0;
     currentTotalFreq_ = 0;
+    resetAging();
+    budget_.clear();
+    expiry_.clear();
   }
 
-private:
-  // 添加缓存
-  void putInternal(const Key& key, const Value& val) {
-    // 如果不在缓存中，则需要判断缓存是否已满
-    if (cacheMap_.size() >= capacity_) {
-      // 缓存已满，删除最不常访问的结点，更新当前平均访问频次和总访问频次
-      kickOut(); // Remove the least frequently used item
+  // 当前总权重，未按权重计容量时为0
+  size_t weight() {
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    return budget_.weight();
+  }
+
+  /// @brief 调整容量，按权重计容量时调整权重预算；扩容立即生效，缩容只改上限，
+  ///        超出的条目由trim分批淘汰，期间写入新关键字仍先淘汰一个，条目数不再增长
+  void resize(size_t capacity) {
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    if (budget_.enabled()) {
+      budget_.setMaxWeight(capacity);
+      return;
     }
+    capacity_ = static_cast<int>(std::min<size_t>(capacity, INT_MAX));
+  }
 
-    // 创建新结点，将新结点添加进入，更新最小访问频次
-    auto node = std::make_shared<Node>(key, val);
-    cacheMap_[key] = node;
-    addNodeToFreqList(node);
-    addFreqNum();
-    minFreq_ = std::min(minFreq_, 1);
+  /// @brief 淘汰超出容量的条目，一次至多淘汰maxEvictions个
+  /// @return 仍超出容量的条目数，按权重计容量时超出预算返回1
+  size_t trim(size_t maxEvictions) {
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    for (size_t num = 0; num < maxEvictions && overCapacity(); ++num) {
+      kickOut();
+    }
+    if (budget_.enabled()) {
+      return budget_.over() ? 1 : 0;
+    }
+    return cacheMap_.size() > limit() ? cacheMap_.size() - limit() : 0;
   }
 
-  // 获取缓存
-  void getInternal(NodePtr node, Value &val) {
-    if (!node) {
-      return;
+  /// @brief 接入分片间共用的全局容量预算，需在并发访问开始之前调用；
+  ///        之后条目数（按权重计容量时为权重）的增减都记入全局预算
+  void shareBudget(GlobalBudget *global) {
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    share_.attach(global, budget_.enabled()
+                              ? static_cast<int64_t>(budget_.weight())
+                              : static_cast<int64_t>(cacheMap_.size()));
+  }
+
+  /// @brief 最先被淘汰的条目的折算频次相对本分片平均频次的比值（放大2^16倍），越小越冷；
+  ///        分片正被其他线程持有或为空时返回false，用于跨分片淘汰时抽样比较，不等待分片锁
+  /// @note 各分片各自老化，刚老化过的分片频次整体偏低，折算频次本身不能跨分片比较，
+  ///       除以平均频次后与老化进度无关
+  bool coldness(uint64_t &score) {
+    std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
+    if (!lock.owns_lock() || cacheMap_.empty()) {
+      return false;
     }
+    double freq = effectiveFreq(freqLists_.front()->getFirstNode());
+    double total = std::max(1, currentTotalFreq_);
+    score = static_cast<uint64_t>(freq * kColdnessScale * cacheMap_.size() / total);
+    return true;
+  }
 
-    // 找到之后需要将其从低访问频次的链表中删除，并且添加到+1的访问频次链表中，
-    // 访问频次+1, 然后把value值返回
-    val = node->val;
-    // 从原有访问频次的链表中删除节点
-    removeNodeFromFreqList(node);
-    node->freq++;
-    addNodeToFreqList(node);
-    // 如果当前node的访问频次如果等于minFreq+1，并且其前驱链表为空，则说明
-    // freqToFreqList_[node->freq - 1]链表因node的迁移已经空了，需要更新最小访问频次
-    if (node->freq - 1 == minFreq_ && freqListMap_[node->freq - 1]->isEmpty()) {
-      minFreq_++;
+  // 淘汰最先被淘汰的条目，用于跨分片淘汰，为空时返回false
+  bool evictColdest() {
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    if (cacheMap_.empty()) {
+      return false;
     }
-    addFreqNum();
+    kickOut();
+    share_.noteEviction();
+    return true;
+  }
+
+  // 立即删除所有已到期的缓存，平时到期的缓存在写入时批量清理、在读取时惰性判断
+  void purgeExpired() {
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    expireLocked(ExpiryWheel::now());
+  }
+
+  // 删除指定缓存
+  void remove(const Key& key) {
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    auto it = cacheMap_.find(key);
+    if (it != cacheMap_.end()) {
+      removeNode(it->second.get());
+    }
+  }
+
+  CacheStats stats() const override { return stats_.snapshot(); }
+
+  // 设置容量淘汰的回调，需在并发访问开始之前调用；回调在锁内执行，只应做轻量的转交
+  void setEvictionListener(typename CacheBase<Key, Value>::EvictionListener listener) {
+    evictionListener_ = std::move(listener);
   }
 
-  // 移除缓存中的过期数据
-  void kickOut() {
-    NodePtr node = freqListMap_[minFreq_]->getFirstNode();
-    removeNodeFromFreqList(node);
-    cacheMap_.erase(node->key);
-    decreaseFreqNum(node->freq);
+  static constexpr SnapshotPolicy kSnapshotPolicy = SnapshotPolicy::LFU;
+
+  // 在锁内按淘汰顺序复制所有未到期的缓存：频次升序，同频次先加入的在前，meta为折算频次
+  SnapshotShard<Key, Value> snapshot() {
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    SnapshotShard<Key, Value> entries;
+    entries.reserve(cacheMap_.size());
+    uint64_t now = ExpiryWheel::now();
+    freqLists_.forEachList([&](const FreqList<Key, Value> &list) {
+      for (NodePtr node = list.getFirstNode(); node; node = node->next) {
+        if (expiry_.empty() || !expiry_.expired(node->key, now)) {
+          entries.push_back({node->key, node->val,
+                             static_cast<uint32_t>(effectiveFreq(node))});
+        }
+      }
+    });
+    return entries;
   }
 
-  // 从频率列表中移除节点
-  void removeNodeFromFreqList(NodePtr node) {
-    if (!node || freqListMap_.end() == freqListMap_.find(node->freq)) {
+  // 在锁内按淘汰顺序移出所有未到期的缓存并清空，用于分片迁移；条目带上折算频次与到期时间，
+  // 不调用淘汰回调
+  SnapshotShard<Key, Value> drain() {
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    SnapshotShard<Key, Value> entries;
+    entries.reserve(cacheMap_.size());
+    uint64_t now = ExpiryWheel::now();
+    freqLists_.forEachList([&](const FreqList<Key, Value> &list) {
+      for (NodePtr node = list.getFirstNode(); node; node = node->next) {
+        uint64_t deadline =
+            expiry_.empty() ? ExpiryWheel::kNever : expiry_.deadline(node->key);
+        if (deadline > now) {
+          entries.push_back({node->key, std::move(node->val),
+                             static_cast<uint32_t>(effectiveFreq(node)),
+                             deadline});
+        }
+      }
+    });
+    releaseShare();
+    freqLists_.clear();
+    cacheMap_.clear();
+    currentAvgFreq_ = 0;
+    currentTotalFreq_ = 0;
+    resetAging();
+    budget_.clear();
+    expiry_.clear();
+    return entries;
+  }
+
+  // 整批只加一次锁，按快照中的频次直接挂入频次桶，不逐条检查淘汰；
+  // 超出剩余容量时舍弃频次最低的条目，写入后统一检查一次平均频次。
+  // 条目带有到期时间时一并恢复，已到期的跳过
+  void restore(SnapshotShard<Key, Value> entries) {
+    if (0 >= capacity_) {
       return;
     }
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    uint64_t now = ExpiryWheel::now();
+    expireLocked(now); // 恢复到期时间之前把时间轮推进到当前时间
+    if (budget_.enabled()) {
+      for (auto &entry : entries) {
+        if (entry.deadline > now) {
+          // 按权重计容量时仍需逐条核算
+          putLocked(entry.key, std::move(entry.value), entry.deadline);
+        }
+      }
+      return;
+    }
+    entries.erase(std::remove_if(entries.begin(), entries.end(),
+                                 [now](const SnapshotEntry<Key, Value> &entry) {
+                                   return entry.deadline <= now;
+                                 }),
+                  entries.end());
+    // 多个快照分片合并到同一分片时频次不再有序
+    std::stable_sort(entries.begin(), entries.end(),
+                     [](const SnapshotEntry<Key, Value> &lhs,
+                        const SnapshotEntry<Key, Value> &rhs) {
+                       return lhs.meta < rhs.meta;
+                     });
+    size_t room = limit() > cacheMap_.size() ? limit() - cacheMap_.size() : 0;
+    size_t skip = entries.size() > room ? entries.size() - room : 0;
+    FreqList<Key, Value> *hint = nullptr;
+    long long total = currentTotalFreq_;
+    size_t sizeBefore = cacheMap_.size();
+    for (size_t idx = skip; idx < entries.size(); ++idx) {
+      SnapshotEntry<Key, Value> &entry = entries[idx];
+      auto &holder = cacheMap_[entry.key];
+      if (holder) {
+        continue; // 已有的缓存比快照新
+      }
+      int freq = static_cast<int>(
+          std::min<uint32_t>(std::max<uint32_t>(1, entry.meta), INT_MAX / 4));
+      holder = makeArenaPtr<Node>(arena_, entry.key, std::move(entry.value));
+      hint = freqLists_.insertSorted(holder.get(), freq + agingOffset_, hint);
+      if (ExpiryWheel::kNever != entry.deadline) {
+        expiry_.schedule(entry.key, entry.deadline);
+      }
+      total += freq;
+    }
+    share_.charge(static_cast<int64_t>(cacheMap_.size() - sizeBefore));
+    currentTotalFreq_ = static_cast<int>(std::min<long long>(total, INT_MAX));
+    currentAvgFreq_ =
+        cacheMap_.empty() ? 0 : currentTotalFreq_ / static_cast<int>(cacheMap_.size());
+    if (currentAvgFreq_ > maxAvgFreq_) {
+      handleOverMaxAverageNum();
+    }
+  }
 
-    freqListMap_[node->freq]->removeNode(node);
+private:
+  static uint64_t deadlineOf(std::chrono::milliseconds ttl) {
+    return ExpiryWheel::now() +
+           static_cast<uint64_t>(ttl.count() > 0 ? ttl.count() : 0);
+  }
 
-    if (freqListMap_[node->freq]->getFirstNode() ==
-        freqListMap_[node->freq]->dummyTail_) {
-      // 如果当前频率列表为空，删除该频率列表
-      delete freqListMap_[node->freq];
-      freqListMap_.erase(node->freq);
-      if (minFreq_ == node->freq) {
-        minFreq_ = (freqListMap_.empty()) ? 0 : minFreq_ + 1;
+  template <typename V>
+  void putLocked(const Key& key, V&& val,
+                 uint64_t deadline = ExpiryWheel::kNever) {
+    stats_.add(StatsRecorder::Put);
+    if (!expiry_.empty() || ExpiryWheel::kNever != deadline) {
+      // 写入时推进时间轮，到期的缓存先腾出位置
+      expireLocked(ExpiryWheel::now());
+    }
+    size_t weight = budget_.weigh(key, val);
+    auto it = cacheMap_.find(key);
+    if (it != cacheMap_.end()) {
+      if (!budget_.admits(weight)) {
+        removeNode(it->second.get()); // 新值超过整个预算，旧值也不再保留
+        return;
       }
+      size_t oldWeight = budget_.weigh(key, it->second->val);
+      budget_.sub(oldWeight);
+      share_.charge(-unitsOf(oldWeight));
+      // Key already exists, update value and frequency
+      it->second->val = std::forward<V>(val);
+      // Move to most recent access
+      touchInternal(it->second.get());
+    } else {
+      if (!budget_.admits(weight) || !putInternal(key, std::forward<V>(val))) {
+        return;
+      }
+    }
+    // 刚写入或更新的节点，超出预算的淘汰中不选它
+    NodePtr written = cacheMap_.find(key)->second.get();
+    if (ExpiryWheel::kNever != deadline) {
+      expiry_.schedule(key, deadline);
+    } else if (!expiry_.empty()) {
+      expiry_.cancel(key);
+    }
+    budget_.add(weight);
+    share_.charge(unitsOf(weight));
+    // 超出权重预算时按淘汰顺序循环淘汰，直到回到预算以内；新节点在最小频次桶（或水位线处），
+    // 淘汰时跳过它，否则会把刚写入的条目一并淘汰。预算只在还有其他节点时才会超出
+    while (budget_.over()) {
+      kickOut(written);
     }
   }
 
-  // 添加到频率列表
-  void addNodeToFreqList(NodePtr node) {
-    // 检查结点是否为空
-    if (!node)
+  bool getLocked(const Key& key, Value &val) {
+    auto it = cacheMap_.find(key);
+    if (it != cacheMap_.end() && !expireIfDue(it->second.get())) {
+      getInternal(it->second.get(), val);
+      stats_.add(StatsRecorder::Hit);
+      return true;
+    }
+    stats_.add(StatsRecorder::Miss);
+    return false;
+  }
+
+  // 添加缓存，容量已调整为0时不写入并返回false
+  template <typename V> bool putInternal(const Key& key, V&& val) {
+    if (0 == limit()) {
+      return false;
+    }
+    // 如果不在缓存中，则需要判断缓存是否已满；缩容后尚未淘汰完时条目数也不再增长
+    if (cacheMap_.size() >= limit()) {
+      // 缓存已满，删除最不常访问的结点，更新当前平均访问频次和总访问频次
+      kickOut(); // Remove the least frequently used item
+    }
+
+    // 创建新结点，加入频次为1的频次桶（惰性老化时即水位线所在的频次桶）
+    auto &holder = cacheMap_[key];
+    holder = makeArenaPtr<Node>(arena_, key, std::forward<V>(val));
+    if (LFUAgingMode::Lazy == agingMode_) {
+      freqLists_.placeNearFloor(holder.get(), agingOffset_ + 1);
+    } else {
+      freqLists_.addFresh(holder.get(), 1);
+    }
+    addFreqNum();
+    return true;
+  }
+
+  // 条目数上限
+  size_t limit() const {
+    int capacity = capacity_.load(std::memory_order_relaxed);
+    return capacity > 0 ? static_cast<size_t>(capacity) : 0;
+  }
+
+  // 是否超出容量（按权重计容量时为权重预算）
+  bool overCapacity() const {
+    return budget_.enabled() ? budget_.over() : cacheMap_.size() > limit();
+  }
+
+  // 记入全局预算的计数：按权重计容量时为权重，否则为条目数
+  int64_t unitsOf(size_t weight) const {
+    return budget_.enabled() ? static_cast<int64_t>(weight) : 1;
+  }
+
+  // 清空之前从全局预算中扣除全部条目
+  void releaseShare() {
+    share_.charge(-static_cast<int64_t>(budget_.enabled() ? budget_.weight()
+                                                          : cacheMap_.size()));
+    share_.flush();
+  }
+
+  // 获取缓存
+  void getInternal(NodePtr node, Value &val) {
+    // 找到之后将其移动到相邻的+1频次桶，然后把value值返回
+    val = node->val;
+    touchInternal(node);
+  }
+
+  // 访问结点：移动到相邻的+1频次桶并累计访问频次
+  void touchInternal(NodePtr node) {
+    if (LFUAgingMode::Lazy == agingMode_ && node->freq() <= agingOffset_) {
+      // 已完全老化的节点折算频次为1，访问后提升到折算频次2
+      freqLists_.placeNearFloor(node, agingOffset_ + 2);
+    } else {
+      freqLists_.promote(node);
+    }
+    addFreqNum();
+  }
+
+  // 淘汰最小频次桶中最早加入的节点，跳过kept
+  void kickOut(NodePtr kept = nullptr) {
+    stats_.add(StatsRecorder::Eviction);
+    NodePtr node = freqLists_.firstExcept(kept);
+    if (!evictionListener_) {
+      removeNode(node);
       return;
+    }
+    Key key = node->key; // 删除节点后回调
+    Value val;
+    removeNode(node, &val);
+    evictionListener_(key, std::move(val));
+  }
 
-    // 添加进入相应的频次链表前需要判断该频次链表是否存在
-    if (freqListMap_.find(node->freq) == freqListMap_.end()) {
-      freqListMap_[node->freq] = new FreqList<Key, Value>(node->freq);
+  // 删除节点，同时扣除其权重与访问频次；taken不为空时把缓存值移出到其中
+  void removeNode(NodePtr node, Value *taken = nullptr) {
+    int freq = effectiveFreq(node);
+    if (!expiry_.empty()) {
+      expiry_.cancel(node->key);
+    }
+    size_t weight = budget_.weigh(node->key, node->val);
+    budget_.sub(weight);
+    share_.charge(-unitsOf(weight));
+    if (nullptr != taken) {
+      *taken = std::move(node->val);
     }
-    freqListMap_[node->freq]->addNode(node);
+    freqLists_.remove(node);
+    cacheMap_.erase(cacheMap_.find(node->key));
+    decreaseFreqNum(freq);
+  }
+
+  // 节点已到期时删除并返回true，读取时的惰性到期判断
+  bool expireIfDue(NodePtr node) {
+    if (expiry_.empty() || !expiry_.expired(node->key, ExpiryWheel::now())) {
+      return false;
+    }
+    removeNode(node);
+    stats_.add(StatsRecorder::Expiration);
+    return true;
+  }
+
+  // 推进时间轮，删除所有已到期的缓存
+  void expireLocked(uint64_t now) {
+    expiry_.advance(now, [this](const Key& key) {
+      auto it = cacheMap_.find(key);
+      if (it != cacheMap_.end()) {
+        removeNode(it->second.get());
+        stats_.add(StatsRecorder::Expiration);
+      }
+    });
   }
 
   // 增加平均访问等频率
@@ -187,56 +575,112 @@ private:
       return; // No items to remove
     }
     // 当前平均访问频次已经超过了最大平均访问频次，所有结点的访问频次- (maxAverageNum_ / 2)
-    for (auto it = cacheMap_.begin(); it != cacheMap_.end(); ++it) {
-      // 检查结点是否为空
-      if (!it->second) {
-        continue;
-      }
-      NodePtr node = it->second;
-      // 先从当前频率列表中移除
-      removeNodeFromFreqList(node);
-      // 减少频率
-      node->freq -= maxAvgFreq_ / 2; // Reduce frequency
-      if (node->freq <= 0) {
-        node->freq = 1; // Ensure frequency is at least 1
-      }
-      // 添加到新的频率列表
-      addNodeToFreqList(node);
+    const int decay = maxAvgFreq_ / 2;
+    if (0 >= decay) {
+      return;
     }
-    // 更新最小频率
-    updateMinFreq();
+    stats_.add(StatsRecorder::AgingSweep);
+    if (LFUAgingMode::Lazy == agingMode_) {
+      ageLazily(decay);
+    } else {
+      ageBySweep(decay);
+    }
+    currentAvgFreq_ = currentTotalFreq_ / cacheMap_.size();
   }
 
-  // 更新最小访问频率
-  void updateMinFreq() {
-    minFreq_ = INT8_MAX;
-    for (const auto &pair : freqListMap_) {
-      if (pair.second && !pair.second->isEmpty()) {
-        minFreq_ = std::min(minFreq_, pair.first);
-      }
+  // 频次保存在频次桶上，按桶整体改写即可，减到1以下的桶合并到频次为1的桶
+  void ageBySweep(int decay) {
+    freqLists_.relabel([decay](int freq) { return std::max(1, freq - decay); });
+    long long total = 0;
+    freqLists_.forEachList([&total](const FreqList<Key, Value> &list) {
+      total += static_cast<long long>(list.getFreq()) * list.size();
+    });
+    currentTotalFreq_ = static_cast<int>(total);
+  }
+
+  // 节点保存的频次不变，折算频次 = max(1, 保存频次 - 衰减偏移量)。
+  // 偏移量增加后保存频次不高于偏移量的频次桶落到水位线以下，
+  // 其节点折算频次均为1，按保存频次的先后顺序依次被淘汰，与立即改写的结果一致
+  void ageLazily(int decay) {
+    const int oldOffset = agingOffset_;
+    agingOffset_ += decay;
+    long long reduced = 0;
+    // 越过水位线的节点折算频次由 freq - oldOffset 降为1
+    freqLists_.raiseFloor(agingOffset_ + 1,
+                          [&reduced, oldOffset](const FreqList<Key, Value> &list) {
+                            reduced += static_cast<long long>(
+                                           list.getFreq() - oldOffset - 1) *
+                                       list.size();
+                          });
+    // 仍在水位线以上的节点折算频次各减少decay
+    reduced += static_cast<long long>(decay) *
+               (cacheMap_.size() - freqLists_.belowFloorNum());
+    currentTotalFreq_ -= static_cast<int>(reduced);
+    if (agingOffset_ > INT_MAX / 4) {
+      rebaseAging();
     }
-    if (minFreq_ == INT8_MAX) {
-      minFreq_ = 1; // Reset if no items are present
+  }
+
+  // 偏移量过大时整体平移一次保存频次，防止计数溢出
+  void rebaseAging() {
+    const int offset = agingOffset_;
+    freqLists_.relabel([offset](int freq) { return std::max(0, freq - offset); });
+    agingOffset_ = 0;
+    freqLists_.resetFloor(1);
+  }
+
+  // 重置老化状态
+  void resetAging() {
+    agingOffset_ = 0;
+    if (LFUAgingMode::Lazy == agingMode_) {
+      freqLists_.resetFloor(1);
     }
   }
 
+  // 节点的折算访问频次
+  int effectiveFreq(NodePtr node) const {
+    return std::max(1, node->freq() - agingOffset_);
+  }
+
 private:
-  // 缓存容量
-  int capacity_;
-  // 最小访问频率
-  int minFreq_;
+  // coldness中比值的放大倍数
+  static constexpr double kColdnessScale = 65536.0;
+
+  // 缓存容量，resize在锁内修改，写入前的容量为0判断在锁外读取
+  std::atomic<int> capacity_;
   // 最大平均访问频率
   int maxAvgFreq_;
   // 当前平均访问频率
   int currentAvgFreq_;
   // 当前访问所有缓存次数的总数
   int currentTotalFreq_;
+  // 老化方式
+  LFUAgingMode agingMode_;
+  // 惰性老化累计的衰减偏移量
+  int agingOffset_;
   // 互斥锁
   std::mutex mutex_;
-  // 缓存映射表
+  // 节点与索引节点的分池，声明在映射表之前，最后析构
+  Arena arena_;
+  // 缓存映射表，持有节点的所有权
   NodeMap cacheMap_;
-  // 频率列表
-  std::unordered_map<int, FreqList<Key, Value> *> freqListMap_;
+  // 频次桶链表
+  FreqListChain<Key, Value> freqLists_;
+  // 权重预算，未设置weigher时不启用
+  WeightBudget<Key, Value> budget_;
+  // 全局容量预算的份额，未接入时不启用
+  BudgetShare share_;
+  // 设置了存活时间的缓存的到期时间轮
+  ExpiryWheel expiry_;
+  // 容量淘汰的回调，为空时直接丢弃
+  typename CacheBase<Key, Value>::EvictionListener evictionListener_;
+  // 运行统计
+  StatsRecorder stats_;
 };
 
+// 存放共享句柄的LFU-Aging，命中时锁内只复制句柄
+template <typename Key, typename Value>
+using LFUAvgHandleCache =
+    HandleCache<Key, Value, LFUAvgCache<Key, ValueHandle<Value>>>;
+
 } // namespace CacheMgr
\ No newline at end of file
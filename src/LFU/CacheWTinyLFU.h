@@ -0,0 +1,215 @@
+/*
+W-TinyLFU:
+以近似频次决定准入的LRU/SLRU组合（Einziger et al., 2017，Caffeine的淘汰策略）：
+    1. 窗口区：约占容量1%的LRU，所有新数据先进入窗口，吸收突发的新热点
+    2. 主区：分段LRU，新晋数据在试用段，试用段内再次命中提升到保护段（约占主区80%），
+       保护段溢出时最旧的数据降回试用段
+    3. 准入：窗口淘汰的候选者与试用段最旧的淘汰者比较FrequencySketch中的估计频次，
+       候选者更热才进入主区，否则直接丢弃，一次性扫描的数据无法挤出主区的热点
+    4. 频次：每次访问都在4位Count-Min Sketch中计数，定期减半让旧热点衰减
+与LRU-K相比，不再为未准入的关键字保留历史链表与待定值，每个关键字的历史开销只有几个比特。
+三个分区都使用预分配的LRUSlab，稳态下不产生堆分配。
+*/
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <mutex>
+#include <utility>
+
+#include "CacheBase.h"
+#include "CacheLRU.h"
+#include "CacheSketch.h"
+
+namespace CacheMgr {
+
+template <typename Key, typename Value>
+class WTinyLFUCache : public CacheBase<Key, Value> {
+public:
+  using SlabType = LRUSlab<Key, Value>;
+  using NodeType = typename SlabType::NodeType;
+
+  // windowPercent为窗口区占总容量的百分比，protectedPercent为保护段占主区的百分比
+  explicit WTinyLFUCache(int capacity, int windowPercent = 1,
+                         int protectedPercent = 80)
+      : capacity_(capacity > 0 ? capacity : 0),
+        windowCapacity_(windowCapacityOf(capacity_, windowPercent)),
+        mainCapacity_(capacity_ - windowCapacity_),
+        protectedCapacity_(protectedCapacityOf(mainCapacity_, protectedPercent)),
+        window_(windowCapacity_), probation_(mainCapacity_),
+        protected_(protectedCapacity_), sketch_(capacity_) {}
+
+  ~WTinyLFUCache() override = default;
+
+  void put(const Key &key, const Value &val) override { putImpl(key, val); }
+
+  void put(const Key &key, Value &&val) override {
+    putImpl(key, std::move(val));
+  }
+
+  bool get(const Key &key, Value &val) override {
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    sketch_.increment(key);
+    NodeType *cached = access(key);
+    if (nullptr == cached) {
+      stats_.add(StatsRecorder::Miss);
+      return false;
+    }
+    stats_.add(StatsRecorder::Hit);
+    val = cached->getValue();
+    return true;
+  }
+
+  // 命中时在锁内直接读取缓存值，不产生复制
+  bool visit(const Key &key,
+             const std::function<void(const Value &)> &visitor) override {
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    sketch_.increment(key);
+    NodeType *cached = access(key);
+    if (nullptr == cached) {
+      stats_.add(StatsRecorder::Miss);
+      return false;
+    }
+    stats_.add(StatsRecorder::Hit);
+    visitor(cached->getValue());
+    return true;
+  }
+
+  Value get(const Key &key) override {
+    Value val{};
+    get(key, val);
+    return val;
+  }
+
+  // 删除指定缓存，频次记录保留在Sketch中自然衰减
+  void remove(const Key &key) {
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    for (SlabType *slab : {&window_, &probation_, &protected_}) {
+      uint32_t idx = slab->find(key);
+      if (SlabType::kNil != idx) {
+        slab->node(idx).setValue(Value());
+        slab->erase(idx);
+        return;
+      }
+    }
+  }
+
+  CacheStats stats() const override { return stats_.snapshot(); }
+
+private:
+  template <typename V> void putImpl(const Key &key, V &&val) {
+    if (0 == capacity_) {
+      return;
+    }
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    stats_.add(StatsRecorder::Put);
+    sketch_.increment(key);
+    NodeType *cached = access(key);
+    if (nullptr != cached) {
+      cached->setValue(std::forward<V>(val));
+      return;
+    }
+    // 新数据先进入窗口区，窗口已满时最旧的数据作为准入候选者
+    if (window_.full()) {
+      uint32_t candidate = window_.leastRecent();
+      Key candidateKey = window_.node(candidate).getKey();
+      Value candidateVal = window_.node(candidate).takeValue();
+      window_.erase(candidate);
+      admit(candidateKey, std::move(candidateVal));
+    }
+    window_.insert(key, std::forward<V>(val));
+  }
+
+  static size_t windowCapacityOf(size_t capacity, int windowPercent) {
+    if (0 == capacity) {
+      return 0;
+    }
+    size_t percent = windowPercent > 0 ? static_cast<size_t>(windowPercent) : 0;
+    size_t window = capacity * (percent < 100 ? percent : 100) / 100;
+    return window > 0 ? window : 1; // 窗口区至少保留一个位置
+  }
+
+  static size_t protectedCapacityOf(size_t mainCapacity, int protectedPercent) {
+    if (mainCapacity < 2) {
+      return 0; // 主区过小时只保留试用段
+    }
+    size_t percent =
+        protectedPercent > 0 ? static_cast<size_t>(protectedPercent) : 0;
+    size_t protect = mainCapacity * (percent < 100 ? percent : 100) / 100;
+    // 试用段至少保留一个位置，保证主区满时总有可供比较的淘汰者
+    return protect < mainCapacity ? protect : mainCapacity - 1;
+  }
+
+  // 查找关键字并按所在分区调整顺序，返回所在节点，不存在时返回nullptr
+  NodeType *access(const Key &key) {
+    uint32_t idx = window_.find(key);
+    if (SlabType::kNil != idx) {
+      window_.touch(idx);
+      return &window_.node(idx);
+    }
+    idx = protected_.find(key);
+    if (SlabType::kNil != idx) {
+      protected_.touch(idx);
+      return &protected_.node(idx);
+    }
+    idx = probation_.find(key);
+    if (SlabType::kNil == idx) {
+      return nullptr;
+    }
+    if (0 == protectedCapacity_) {
+      probation_.touch(idx);
+      return &probation_.node(idx);
+    }
+    return &protected_.node(promote(idx));
+  }
+
+  // 试用段内再次命中，提升到保护段，保护段溢出时最旧的数据降回试用段
+  uint32_t promote(uint32_t idx) {
+    Key key = probation_.node(idx).getKey();
+    Value val = probation_.node(idx).takeValue();
+    probation_.erase(idx);
+    stats_.add(StatsRecorder::Promotion);
+    if (protected_.full()) {
+      uint32_t demoted = protected_.leastRecent();
+      probation_.insert(protected_.node(demoted).getKey(),
+                        protected_.node(demoted).takeValue());
+      protected_.erase(demoted);
+    }
+    return protected_.insert(key, std::move(val));
+  }
+
+  // 窗口区淘汰的候选者尝试进入主区试用段
+  void admit(const Key &key, Value &&val) {
+    if (0 == mainCapacity_) {
+      stats_.add(StatsRecorder::Eviction);
+      return; // 没有主区，候选者直接丢弃
+    }
+    if (probation_.size() + protected_.size() >= mainCapacity_) {
+      uint32_t victim = probation_.leastRecent();
+      if (sketch_.frequency(key) <=
+          sketch_.frequency(probation_.node(victim).getKey())) {
+        stats_.add(StatsRecorder::Eviction);
+        return; // 候选者不比淘汰者更热，拒绝准入
+      }
+      stats_.add(StatsRecorder::Eviction);
+      probation_.node(victim).setValue(Value());
+      probation_.erase(victim);
+    }
+    probation_.insert(key, std::move(val));
+  }
+
+private:
+  size_t capacity_;          // 缓存总容量
+  size_t windowCapacity_;    // 窗口区容量
+  size_t mainCapacity_;      // 主区容量（试用段+保护段）
+  size_t protectedCapacity_; // 保护段容量
+  std::mutex mutex_;         // 互斥锁
+  SlabType window_;          // 窗口区LRU
+  SlabType probation_;       // 主区试用段
+  SlabType protected_;       // 主区保护段
+  FrequencySketch<Key> sketch_; // 访问频次估计
+  StatsRecorder stats_;      // 运行统计
+};
+
+} // namespace CacheMgr
\ No newline at end of file
@@ -12,53 +12,327 @@ LRU:
  */
 #pragma once
 
-#include <memory>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <functional>
 #include <mutex>
-#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "CacheBase.h"
+#include "CacheBatch.h"
+#include "CacheHandle.h"
+#include "CacheSnapshot.h"
+#include "CacheTimerWheel.h"
+#include "CacheBalance.h"
+#include "CacheWeight.h"
 
 namespace CacheMgr {
 
-template <typename Key, typename Value> class LRUCache;
+template <typename Key, typename Value> class LRUSlab;
 
 template <typename Key, typename Value> class LRUNode {
 public:
-  explicit LRUNode(Key key, Value val) : key_(key), val_(val), count_(1) {}
+  LRUNode() : key_(), prev_(0), next_(0), hashNext_(0), stamp_(0), val_() {}
+  explicit LRUNode(Key key, Value val)
+      : key_(std::move(key)), prev_(0), next_(0), hashNext_(0), stamp_(0),
+        val_(std::move(val)) {}
 
   ~LRUNode() = default;
 
-  // 缓存节点操作，索引、值、次数的访问与设置
-  Key getKey() const { return key_; }
-  Value getValue() const { return val_; }
+  // 缓存节点操作，索引、值、访问时钟的访问与设置
+  const Key &getKey() const { return key_; }
+  const Value &getValue() const { return val_; }
   void setValue(const Value &val) { val_ = val; }
-  size_t getAccessCount() const { return count_; }
-  void incrementAccessCount() { ++count_; }
+  void setValue(Value &&val) { val_ = std::move(val); }
+  // 移出缓存值，节点中只留下被移动后的对象
+  Value takeValue() { return std::move(val_); }
+  uint32_t getStamp() const { return stamp_; }
+  void setStamp(uint32_t stamp) { stamp_ = stamp; }
 
 private:
   // 关键字，索引
   Key key_;
+  // 前置节点槽位下标
+  uint32_t prev_;
+  // 后置节点槽位下标
+  uint32_t next_;
+  // 同一哈希桶内下一个节点的槽位下标
+  uint32_t hashNext_;
+  // 最近一次访问时的全局访问时钟，只在共用全局容量预算时维护
+  uint32_t stamp_;
   // 缓存值
   Value val_;
-  // 访问次数
-  size_t count_;
-  // 前置缓存，弱指针避免重复引用
-  std::shared_ptr<LRUNode<Key, Value>> prev_;
-  // 后置缓存
-  std::shared_ptr<LRUNode<Key, Value>> next_;
 
 public:
-  friend class LRUCache<Key, Value>;
+  friend class LRUSlab<Key, Value>;
+};
+
+/*
+LRUSlab:
+按容量一次性预分配的节点槽位池，节点之间用32位下标串联，不再使用shared_ptr。
+槽位0作为哨兵节点，既是环形最近访问链表的头尾，也表示“空下标”；
+哈希索引采用桶数组 + 节点内嵌链（hashNext_），索引与链表共用同一块连续内存，
+稳态下的get/put不再产生任何堆分配，也没有引用计数的原子操作。
+本类不加锁，由外层缓存负责同步。
+*/
+template <typename Key, typename Value> class LRUSlab {
+public:
+  using NodeType = LRUNode<Key, Value>;
+
+  // 空下标，同时也是哨兵节点所在槽位
+  static constexpr uint32_t kNil = 0;
+
+  explicit LRUSlab(size_t capacity)
+      : capacity_(capacity), size_(0), freeHead_(kNil), bucketShift_(64),
+        nodes_(capacity + 1) {
+    // 桶数量取不小于容量的2的幂，负载因子不超过1
+    size_t bucketNum = 1;
+    while (bucketNum < capacity_) {
+      bucketNum <<= 1;
+      --bucketShift_;
+    }
+    buckets_.assign(bucketNum, kNil);
+    clear();
+  }
+
+  size_t size() const { return size_; }
+  size_t capacity() const { return capacity_; }
+  bool empty() const { return 0 == size_; }
+  bool full() const { return size_ >= capacity_; }
+
+  NodeType &node(uint32_t idx) { return nodes_[idx]; }
+  const NodeType &node(uint32_t idx) const { return nodes_[idx]; }
+
+  // 查找关键字所在槽位，不存在时返回kNil
+  uint32_t find(const Key &key) const {
+    uint32_t idx = buckets_[bucketOf(key)];
+    while (kNil != idx && !(nodes_[idx].key_ == key)) {
+      idx = nodes_[idx].hashNext_;
+    }
+    return idx;
+  }
+
+  // 将指定槽位移动到最新位置
+  void touch(uint32_t idx) {
+    if (nodes_[sentinel()].prev_ == idx) {
+      return; // 已经是最新节点
+    }
+    unlink(idx);
+    linkBack(idx);
+  }
+
+  // 插入新节点并作为最新节点，调用方需保证关键字不存在且未满
+  template <typename V> uint32_t insert(const Key &key, V &&val) {
+    uint32_t idx = freeHead_;
+    freeHead_ = nodes_[idx].next_;
+    NodeType &node = nodes_[idx];
+    node.key_ = key;
+    node.val_ = std::forward<V>(val);
+    node.stamp_ = 0;
+    size_t bucket = bucketOf(key);
+    node.hashNext_ = buckets_[bucket];
+    buckets_[bucket] = idx;
+    linkBack(idx);
+    ++size_;
+    return idx;
+  }
+
+  // 批量查找第i个关键字之前调用：预取第i+2d个关键字的哈希桶，
+  // 以及第i+d个关键字（其哈希桶已在之前预取）的首个节点
+  void prefetchBatch(const Key *keys, const uint32_t *order, size_t count,
+                     size_t i) const {
+    constexpr size_t distance = detail::kPrefetchDistance;
+    if (0 == i) {
+      for (size_t ahead = 0; ahead < 2 * distance && ahead < count; ++ahead) {
+        prefetchBucket(keys[detail::batchIndex(order, ahead)]);
+      }
+    }
+    if (i + 2 * distance < count) {
+      prefetchBucket(keys[detail::batchIndex(order, i + 2 * distance)]);
+    }
+    if (i + distance < count) {
+      uint32_t head =
+          buckets_[bucketOf(keys[detail::batchIndex(order, i + distance)])];
+      if (kNil != head) {
+        detail::prefetchRead(&nodes_[head]);
+      }
+    }
+  }
+
+  // 最近最少访问的槽位，为空时返回kNil
+  uint32_t leastRecent() const { return nodes_[sentinel()].next_; }
+
+  // 最近访问的槽位，为空时返回kNil
+  uint32_t mostRecent() const { return nodes_[sentinel()].prev_; }
+
+  // 比指定槽位新一位的槽位，已是最新时返回kNil
+  uint32_t newer(uint32_t idx) const { return nodes_[idx].next_; }
+
+  // 删除指定槽位，并将其归还空闲链表
+  void erase(uint32_t idx) {
+    unhash(idx);
+    unlink(idx);
+    nodes_[idx].next_ = freeHead_;
+    freeHead_ = idx;
+    --size_;
+  }
+
+  // 扩容到newCapacity个槽位，已有节点的槽位下标不变，哈希桶按新容量重建
+  void grow(size_t newCapacity) {
+    if (newCapacity <= capacity_) {
+      return;
+    }
+    nodes_.resize(newCapacity + 1);
+    for (size_t idx = newCapacity; idx > capacity_; --idx) {
+      nodes_[idx].next_ = freeHead_;
+      freeHead_ = static_cast<uint32_t>(idx);
+    }
+    capacity_ = newCapacity;
+    size_t bucketNum = buckets_.size();
+    if (bucketNum >= capacity_) {
+      return;
+    }
+    while (bucketNum < capacity_) {
+      bucketNum <<= 1;
+      --bucketShift_;
+    }
+    buckets_.assign(bucketNum, kNil);
+    for (uint32_t idx = leastRecent(); kNil != idx; idx = nodes_[idx].next_) {
+      size_t bucket = bucketOf(nodes_[idx].key_);
+      nodes_[idx].hashNext_ = buckets_[bucket];
+      buckets_[bucket] = idx;
+    }
+  }
+
+  // 收缩到newCapacity个槽位，节点按最近访问顺序搬到前部，哈希桶按新容量重建；
+  // 节点数超过newCapacity时不收缩
+  void shrink(size_t newCapacity) {
+    if (newCapacity >= capacity_ || size_ > newCapacity) {
+      return;
+    }
+    std::vector<NodeType> nodes(newCapacity + 1);
+    size_t bucketNum = 1;
+    bucketShift_ = 64;
+    while (bucketNum < newCapacity) {
+      bucketNum <<= 1;
+      --bucketShift_;
+    }
+    buckets_.assign(bucketNum, kNil);
+    uint32_t prev = sentinel();
+    uint32_t slot = 1;
+    for (uint32_t idx = leastRecent(); kNil != idx; idx = nodes_[idx].next_) {
+      NodeType &node = nodes[slot];
+      node.key_ = std::move(nodes_[idx].key_);
+      node.val_ = std::move(nodes_[idx].val_);
+      node.stamp_ = nodes_[idx].stamp_;
+      node.prev_ = prev;
+      nodes[prev].next_ = slot;
+      size_t bucket = bucketOf(node.key_);
+      node.hashNext_ = buckets_[bucket];
+      buckets_[bucket] = slot;
+      prev = slot++;
+    }
+    nodes[prev].next_ = sentinel();
+    nodes[sentinel()].prev_ = prev;
+    // 剩余槽位依次串成空闲链表
+    freeHead_ = kNil;
+    for (size_t idx = newCapacity; idx >= slot; --idx) {
+      nodes[idx].next_ = freeHead_;
+      freeHead_ = static_cast<uint32_t>(idx);
+    }
+    nodes_.swap(nodes);
+    capacity_ = newCapacity;
+  }
+
+  // 清空所有节点
+  void clear() {
+    std::fill(buckets_.begin(), buckets_.end(), kNil);
+    nodes_[sentinel()].prev_ = sentinel();
+    nodes_[sentinel()].next_ = sentinel();
+    // 槽位0为哨兵，空闲链表从1开始串联，末尾以kNil结束
+    freeHead_ = kNil;
+    for (size_t idx = capacity_; idx > 0; --idx) {
+      nodes_[idx].next_ = freeHead_;
+      freeHead_ = static_cast<uint32_t>(idx);
+    }
+    size_ = 0;
+  }
+
+private:
+  static constexpr uint32_t sentinel() { return kNil; }
+
+  // Fibonacci哈希，取乘积高位作为桶下标，避免整数关键字的恒等哈希聚集
+  size_t bucketOf(const Key &key) const {
+    if (64 == bucketShift_) {
+      return 0;
+    }
+    uint64_t hash = static_cast<uint64_t>(std::hash<Key>{}(key));
+    return static_cast<size_t>((hash * 0x9E3779B97F4A7C15ull) >> bucketShift_);
+  }
+
+  void prefetchBucket(const Key &key) const {
+    detail::prefetchRead(&buckets_[bucketOf(key)]);
+  }
+
+  // 从最近访问链表中摘除节点
+  void unlink(uint32_t idx) {
+    NodeType &node = nodes_[idx];
+    nodes_[node.prev_].next_ = node.next_;
+    nodes_[node.next_].prev_ = node.prev_;
+  }
+
+  // 在链表末尾（最新位置）挂入节点
+  void linkBack(uint32_t idx) {
+    NodeType &node = nodes_[idx];
+    NodeType &dummy = nodes_[sentinel()];
+    node.prev_ = dummy.prev_;
+    node.next_ = sentinel();
+    nodes_[dummy.prev_].next_ = idx;
+    dummy.prev_ = idx;
+  }
+
+  // 从哈希桶链中摘除节点
+  void unhash(uint32_t idx) {
+    uint32_t *link = &buckets_[bucketOf(nodes_[idx].key_)];
+    while (*link != idx) {
+      link = &nodes_[*link].hashNext_;
+    }
+    *link = nodes_[idx].hashNext_;
+  }
+
+private:
+  // 节点容量
+  size_t capacity_;
+  // 当前节点数量
+  size_t size_;
+  // 空闲槽位链表头
+  uint32_t freeHead_;
+  // 桶下标右移位数
+  unsigned bucketShift_;
+  // 节点槽位池，槽位0为哨兵
+  std::vector<NodeType> nodes_;
+  // 哈希桶，存放桶内首个节点的槽位下标
+  std::vector<uint32_t> buckets_;
 };
 
 template <typename Key, typename Value>
 class LRUCache : public CacheBase<Key, Value> {
 public:
   using LRUNodeType = LRUNode<Key, Value>;
-  using NodePtr = std::shared_ptr<LRUNodeType>;
-  using NodeMap = std::unordered_map<Key, NodePtr>;
+  using SlabType = LRUSlab<Key, Value>;
+  using ExpiryWheel = TimerWheel<Key>;
 
-  explicit LRUCache(int capacity) : capacity_(capacity) { initializeList(); }
+  explicit LRUCache(int capacity)
+      : capacity_(capacity), slab_(capacity > 0 ? capacity : 0) {}
+
+  // 按权重计容量：总权重不超过maxWeight，条目数不设上限，槽位池按需倍增
+  explicit LRUCache(size_t maxWeight, CacheWeigher<Key, Value> weigher)
+      : capacity_(kInitialSlots), slab_(kInitialSlots),
+        budget_(maxWeight, std::move(weigher)) {}
 
   virtual ~LRUCache() override = default;
 
@@ -67,27 +341,83 @@ public:
       return;
     }
 
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = nodeMap_.find(key);
-    if (nodeMap_.end() != it) {
-      // 如果在当前容器中,则更新value,并调用get方法，代表该数据刚被访问
-      updateExistingNode(it->second, val);
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    putLocked(key, val);
+  }
+
+  void put(const Key& key, Value&& val) override {
+    if (0 >= capacity_) {
+      return;
+    }
+
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    putLocked(key, std::move(val));
+  }
+
+  // 添加缓存并设置存活时间，到期后不再命中；不带存活时间的put会清除之前设置的存活时间
+  void put(const Key& key, const Value& val, std::chrono::milliseconds ttl) {
+    if (0 >= capacity_) {
+      return;
+    }
+
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    putLocked(key, val, deadlineOf(ttl));
+  }
+
+  void put(const Key& key, Value&& val, std::chrono::milliseconds ttl) {
+    if (0 >= capacity_) {
       return;
     }
 
-    addNode(key, val);
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    putLocked(key, std::move(val), deadlineOf(ttl));
   }
 
   bool get(const Key& key, Value &val) override {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = nodeMap_.find(key);
-    if (nodeMap_.end() != it) {
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    return getLocked(key, val);
+  }
 
-      moveToMostRecent(it->second);
-      val = it->second->getValue();
-      return true;
+  // 命中时在锁内直接读取节点中的缓存值，不产生复制
+  bool visit(const Key& key,
+             const std::function<void(const Value &)> &visitor) override {
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    uint32_t idx = slab_.find(key);
+    if (SlabType::kNil == idx || expireIfDue(idx)) {
+      stats_.add(StatsRecorder::Miss);
+      return false;
     }
-    return false;
+    stats_.add(StatsRecorder::Hit);
+    touchNode(idx);
+    visitor(slab_.node(idx).getValue());
+    return true;
+  }
+
+  // 整批只加一次锁
+  void putBatch(const Key *keys, const Value *vals, const uint32_t *order,
+                size_t count) override {
+    if (0 >= capacity_) {
+      return;
+    }
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    for (size_t i = 0; i < count; ++i) {
+      size_t idx = detail::batchIndex(order, i);
+      putLocked(keys[idx], vals[idx]);
+    }
+  }
+
+  // 整批只加一次锁，查找时提前预取后续关键字的哈希桶与节点
+  size_t getBatch(const Key *keys, const uint32_t *order, size_t count,
+                  Value *vals, bool *hits) override {
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    size_t hitNum = 0;
+    for (size_t i = 0; i < count; ++i) {
+      slab_.prefetchBatch(keys, order, count, i);
+      size_t idx = detail::batchIndex(order, i);
+      hits[idx] = getLocked(keys[idx], vals[idx]);
+      hitNum += hits[idx] ? 1 : 0;
+    }
+    return hitNum;
   }
 
   Value get(const Key& key) override {
@@ -98,82 +428,379 @@ public:
 
   // 删除指定缓存
   void remove(const Key& key) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = nodeMap_.find(key);
-    if (nodeMap_.end() != it) {
-      removeNode(it->second);
-      nodeMap_.erase(it);
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    uint32_t idx = slab_.find(key);
+    if (SlabType::kNil != idx) {
+      removeNode(idx);
+    }
+  }
+
+  // 当前总权重，未按权重计容量时为0
+  size_t weight() {
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    return budget_.weight();
+  }
+
+  /// @brief 调整容量，按权重计容量时调整权重预算；扩容立即生效，槽位池在写入时按需倍增；
+  ///        缩容只改上限，超出的条目由trim分批淘汰，期间写入新关键字仍先淘汰一个，条目数不再增长
+  void resize(size_t capacity) {
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    if (budget_.enabled()) {
+      budget_.setMaxWeight(capacity);
+      return;
+    }
+    capacity_ = static_cast<int>(std::min<size_t>(capacity, INT_MAX));
+  }
+
+  /// @brief 淘汰超出容量的条目，一次至多淘汰maxEvictions个，回到容量以内后收缩槽位池
+  /// @return 仍超出容量的条目数，按权重计容量时超出预算返回1
+  size_t trim(size_t maxEvictions) {
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    for (size_t num = 0; num < maxEvictions && overCapacity(); ++num) {
+      evictLeastRecent();
+    }
+    if (budget_.enabled()) {
+      return budget_.over() ? 1 : 0;
+    }
+    if (slab_.size() > limit()) {
+      return slab_.size() - limit();
     }
+    slab_.shrink(limit());
+    return 0;
+  }
+
+  /// @brief 接入分片间共用的全局容量预算，需在并发访问开始之前调用；
+  ///        之后条目数（按权重计容量时为权重）的增减都记入全局预算，访问时记录全局访问时钟
+  void shareBudget(GlobalBudget *global) {
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    share_.attach(global, budget_.enabled()
+                              ? static_cast<int64_t>(budget_.weight())
+                              : static_cast<int64_t>(slab_.size()));
+  }
+
+  /// @brief 最久未访问条目的访问时钟，越小越冷；分片正被其他线程持有或为空时返回false，
+  ///        用于跨分片淘汰时抽样比较，不等待分片锁
+  bool coldness(uint64_t &score) {
+    std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
+    if (!lock.owns_lock() || slab_.empty()) {
+      return false;
+    }
+    score = slab_.node(slab_.leastRecent()).getStamp();
+    return true;
+  }
+
+  // 淘汰最久未访问的条目，用于跨分片淘汰，为空时返回false
+  bool evictColdest() {
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    if (slab_.empty()) {
+      return false;
+    }
+    evictLeastRecent();
+    share_.noteEviction();
+    return true;
+  }
+
+  // 立即删除所有已到期的缓存，平时到期的缓存在写入时批量清理、在读取时惰性判断
+  void purgeExpired() {
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    expireLocked(ExpiryWheel::now());
+  }
+
+  CacheStats stats() const override { return stats_.snapshot(); }
+
+  // 设置容量淘汰的回调，需在并发访问开始之前调用；回调在锁内执行，只应做轻量的转交
+  void setEvictionListener(typename CacheBase<Key, Value>::EvictionListener listener) {
+    evictionListener_ = std::move(listener);
+  }
+
+  static constexpr SnapshotPolicy kSnapshotPolicy = SnapshotPolicy::LRU;
+
+  // 在锁内按最近访问顺序复制所有未到期的缓存，最久未访问的在前，meta为分片内的新旧位置
+  SnapshotShard<Key, Value> snapshot() {
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    SnapshotShard<Key, Value> entries;
+    entries.reserve(slab_.size());
+    uint64_t now = ExpiryWheel::now();
+    for (uint32_t idx = slab_.leastRecent(); SlabType::kNil != idx;
+         idx = slab_.newer(idx)) {
+      const LRUNodeType &node = slab_.node(idx);
+      if (expiry_.empty() || !expiry_.expired(node.getKey(), now)) {
+        entries.push_back({node.getKey(), node.getValue(), 0});
+      }
+    }
+    rankByRecency(entries);
+    return entries;
+  }
+
+  // 在锁内按最近访问顺序移出所有未到期的缓存并清空，最久未访问的在前，用于分片迁移；
+  // 条目带上到期时间，不调用淘汰回调
+  SnapshotShard<Key, Value> drain() {
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    SnapshotShard<Key, Value> entries;
+    entries.reserve(slab_.size());
+    uint64_t now = ExpiryWheel::now();
+    for (uint32_t idx = slab_.leastRecent(); SlabType::kNil != idx;
+         idx = slab_.newer(idx)) {
+      LRUNodeType &node = slab_.node(idx);
+      uint64_t deadline =
+          expiry_.empty() ? ExpiryWheel::kNever : expiry_.deadline(node.getKey());
+      if (deadline > now) {
+        entries.push_back({node.getKey(), node.takeValue(), 0, deadline});
+      }
+    }
+    rankByRecency(entries);
+    share_.charge(-static_cast<int64_t>(budget_.enabled() ? budget_.weight()
+                                                          : slab_.size()));
+    share_.flush();
+    slab_.clear();
+    expiry_.clear();
+    budget_.clear();
+    return entries;
+  }
+
+  // 整批只加一次锁，按新旧位置作为最新数据写入，不逐条检查淘汰；超出剩余容量时舍弃最久未访问的条目。
+  // 条目带有到期时间时一并恢复，已到期的跳过
+  void restore(SnapshotShard<Key, Value> entries) {
+    if (0 >= capacity_) {
+      return;
+    }
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    uint64_t now = ExpiryWheel::now();
+    expireLocked(now); // 恢复到期时间之前把时间轮推进到当前时间
+    if (budget_.enabled()) {
+      for (auto &entry : entries) {
+        if (entry.deadline > now) {
+          // 按权重计容量时仍需逐条核算
+          putLocked(entry.key, std::move(entry.value), entry.deadline);
+        }
+      }
+      return;
+    }
+    // 多个快照分片合并到同一分片时按新旧位置交错，而不是整个分片排在另一个分片之后；
+    // 旧版本快照的位置均为0，保持原有顺序
+    std::stable_sort(entries.begin(), entries.end(),
+                     [](const SnapshotEntry<Key, Value> &lhs,
+                        const SnapshotEntry<Key, Value> &rhs) {
+                       return lhs.meta < rhs.meta;
+                     });
+    size_t room = limit() > slab_.size() ? limit() - slab_.size() : 0;
+    size_t skip = entries.size() > room ? entries.size() - room : 0;
+    slab_.grow(std::min(limit(), slab_.size() + entries.size() - skip));
+    size_t inserted = 0;
+    for (size_t idx = skip; idx < entries.size(); ++idx) {
+      SnapshotEntry<Key, Value> &entry = entries[idx];
+      if (entry.deadline <= now ||
+          SlabType::kNil != slab_.find(entry.key)) {
+        continue;
+      }
+      stamp(slab_.insert(entry.key, std::move(entry.value)));
+      if (ExpiryWheel::kNever != entry.deadline) {
+        expiry_.schedule(entry.key, entry.deadline);
+      }
+      ++inserted;
+    }
+    share_.charge(static_cast<int64_t>(inserted));
   }
 
 private:
-  // 缓存初始化
-  void initializeList() {
-    dummyHead_ = std::make_shared<LRUNodeType>(Key(), Value());
-    dummyTail_ = std::make_shared<LRUNodeType>(Key(), Value());
-    dummyHead_->next_ = dummyTail_;
-    dummyTail_->prev_ = dummyHead_;
+  static uint64_t deadlineOf(std::chrono::milliseconds ttl) {
+    return ExpiryWheel::now() +
+           static_cast<uint64_t>(ttl.count() > 0 ? ttl.count() : 0);
+  }
+
+  template <typename V>
+  void putLocked(const Key &key, V &&val,
+                 uint64_t deadline = ExpiryWheel::kNever) {
+    stats_.add(StatsRecorder::Put);
+    if (!expiry_.empty() || ExpiryWheel::kNever != deadline) {
+      // 写入时推进时间轮，到期的缓存先腾出位置
+      expireLocked(ExpiryWheel::now());
+    }
+    size_t weight = budget_.weigh(key, val);
+    uint32_t idx = slab_.find(key);
+    if (SlabType::kNil != idx) {
+      if (!budget_.admits(weight)) {
+        removeNode(idx); // 新值超过整个预算，旧值也不再保留
+        return;
+      }
+      size_t oldWeight = budget_.weigh(key, slab_.node(idx).getValue());
+      budget_.sub(oldWeight);
+      share_.charge(-unitsOf(oldWeight));
+      // 如果在当前容器中,则更新value,并调用get方法，代表该数据刚被访问
+      updateExistingNode(idx, std::forward<V>(val));
+    } else {
+      if (!budget_.admits(weight) || !addNode(key, std::forward<V>(val))) {
+        return;
+      }
+    }
+    if (ExpiryWheel::kNever != deadline) {
+      expiry_.schedule(key, deadline);
+    } else if (!expiry_.empty()) {
+      expiry_.cancel(key);
+    }
+    budget_.add(weight);
+    share_.charge(unitsOf(weight));
+    // 超出权重预算时从最旧的数据开始淘汰，刚写入的数据是最新的，最后才会被淘汰
+    while (budget_.over()) {
+      evictLeastRecent();
+    }
+  }
+
+  bool getLocked(const Key &key, Value &val) {
+    uint32_t idx = slab_.find(key);
+    if (SlabType::kNil != idx && !expireIfDue(idx)) {
+      touchNode(idx);
+      val = slab_.node(idx).getValue();
+      stats_.add(StatsRecorder::Hit);
+      return true;
+    }
+    stats_.add(StatsRecorder::Miss);
+    return false;
   }
 
   // 更新现有缓存节点
-  void updateExistingNode(NodePtr node, const Value &val) {
-    node->setValue(val);
-    moveToMostRecent(node);
+  template <typename V> void updateExistingNode(uint32_t idx, V &&val) {
+    slab_.node(idx).setValue(std::forward<V>(val));
+    touchNode(idx);
   }
 
-  // 增加缓存节点
-  void addNode(const Key &key, const Value &val) {
-    if (nodeMap_.size() >= capacity_) {
-      evictLeastRecent();
+  // 增加缓存节点，容量已调整为0时不写入并返回false
+  template <typename V> bool addNode(const Key &key, V &&val) {
+    if (budget_.enabled()) {
+      if (slab_.full()) {
+        slab_.grow(2 * slab_.capacity()); // 按权重计容量时槽位数不设上限
+      }
+    } else if (0 == limit()) {
+      return false;
+    } else if (slab_.size() >= limit()) {
+      evictLeastRecent(); // 缩容后尚未淘汰完时节点数也不再增长
+    } else if (slab_.full()) {
+      // 扩容后槽位池按需倍增，不超过容量
+      slab_.grow(std::min(limit(), std::max<size_t>(2 * slab_.capacity(),
+                                                     kInitialSlots)));
     }
-    NodePtr node = std::make_shared<LRUNodeType>(key, val);
-    insertNode(node);
-    nodeMap_[key] = node;
+    stamp(slab_.insert(key, std::forward<V>(val)));
+    return true;
   }
 
-  // 移动指定缓存节点到最新位置
-  void moveToMostRecent(NodePtr node) {
-    removeNode(node);
-    insertNode(node);
+  // 将节点移动到最新位置并记录访问时钟
+  void touchNode(uint32_t idx) {
+    slab_.touch(idx);
+    stamp(idx);
   }
 
-  // 删除指定节点
-  void removeNode(NodePtr node) {
-    if (node->prev_ && node->next_) {
-      auto prev = node->prev_;
-      prev->next_ = node->next_;
-      node->next_->prev_ = prev;
-      // 清空next_指针，彻底断开缓存节点与链表的连接
-      node->next_ = nullptr;
+  // 按最久未访问在前的顺序给条目标上新旧位置：第i个（共n个）为(i+1)/(n+1)，放大2^32倍，
+  // 各分片的位置按比例对齐，不依赖分片自己的访问次数
+  static void rankByRecency(SnapshotShard<Key, Value> &entries) {
+    uint64_t slots = static_cast<uint64_t>(entries.size()) + 1;
+    for (size_t idx = 0; idx < entries.size(); ++idx) {
+      entries[idx].meta =
+          static_cast<uint32_t>((static_cast<uint64_t>(idx + 1) << 32) / slots);
     }
   }
 
-  // 在末尾添加指定节点
-  void insertNode(NodePtr node) {
-    node->next_ = dummyTail_;
-    node->prev_ = dummyTail_->prev_;
-    dummyTail_->prev_->next_ = node;
-    dummyTail_->prev_ = node;
+  // 共用全局容量预算时记录节点的访问时钟
+  void stamp(uint32_t idx) {
+    if (share_.enabled()) {
+      slab_.node(idx).setStamp(share_.clock());
+    }
+  }
+
+  // 记入全局预算的计数：按权重计容量时为权重，否则为条目数
+  int64_t unitsOf(size_t weight) const {
+    return budget_.enabled() ? static_cast<int64_t>(weight) : 1;
+  }
+
+  // 条目数上限
+  size_t limit() const {
+    int capacity = capacity_.load(std::memory_order_relaxed);
+    return capacity > 0 ? static_cast<size_t>(capacity) : 0;
+  }
+
+  // 是否超出容量（按权重计容量时为权重预算）
+  bool overCapacity() const {
+    return budget_.enabled() ? budget_.over() : slab_.size() > limit();
   }
 
   // 驱逐最近最少访问的缓存节点
   void evictLeastRecent() {
-    NodePtr leastRecent = dummyHead_->next_;
-    removeNode(leastRecent);
-    nodeMap_.erase(leastRecent->getKey());
+    stats_.add(StatsRecorder::Eviction);
+    uint32_t idx = slab_.leastRecent();
+    LRUNodeType &node = slab_.node(idx);
+    if (!expiry_.empty()) {
+      expiry_.cancel(node.getKey());
+    }
+    size_t weight = budget_.weigh(node.getKey(), node.getValue());
+    budget_.sub(weight);
+    share_.charge(-unitsOf(weight));
+    if (evictionListener_) {
+      evictionListener_(node.getKey(), node.takeValue());
+    } else if (budget_.enabled()) {
+      node.setValue(Value()); // 立即释放缓存值，让淘汰真正腾出内存
+    }
+    slab_.erase(idx);
+  }
+
+  // 删除节点并释放缓存值占用的资源，槽位本身留待复用
+  void removeNode(uint32_t idx) {
+    LRUNodeType &node = slab_.node(idx);
+    if (!expiry_.empty()) {
+      expiry_.cancel(node.getKey());
+    }
+    size_t weight = budget_.weigh(node.getKey(), node.getValue());
+    budget_.sub(weight);
+    share_.charge(-unitsOf(weight));
+    node.setValue(Value());
+    slab_.erase(idx);
+  }
+
+  // 节点已到期时删除并返回true，读取时的惰性到期判断
+  bool expireIfDue(uint32_t idx) {
+    if (expiry_.empty() ||
+        !expiry_.expired(slab_.node(idx).getKey(), ExpiryWheel::now())) {
+      return false;
+    }
+    removeNode(idx);
+    stats_.add(StatsRecorder::Expiration);
+    return true;
+  }
+
+  // 推进时间轮，删除所有已到期的缓存
+  void expireLocked(uint64_t now) {
+    expiry_.advance(now, [this](const Key &key) {
+      uint32_t idx = slab_.find(key);
+      if (SlabType::kNil != idx) {
+        removeNode(idx);
+        stats_.add(StatsRecorder::Expiration);
+      }
+    });
   }
 
 private:
-  // 缓存容量
-  int capacity_;
-  // 节点映射
-  NodeMap nodeMap_;
+  // 按权重计容量时槽位池的初始槽位数，也是槽位池按需倍增时的最小槽位数
+  static constexpr int kInitialSlots = 64;
+
+  // 缓存容量，resize在锁内修改，写入前的容量为0判断在锁外读取
+  std::atomic<int> capacity_;
   // 互斥锁
   std::mutex mutex_;
-  // 虚拟头节点
-  NodePtr dummyHead_;
-  // 虚拟末节点
-  NodePtr dummyTail_;
+  // 节点槽位池（索引与最近访问链表）
+  SlabType slab_;
+  // 权重预算，未设置weigher时不启用
+  WeightBudget<Key, Value> budget_;
+  // 全局容量预算的份额，未接入时不启用
+  BudgetShare share_;
+  // 设置了存活时间的缓存的到期时间轮
+  ExpiryWheel expiry_;
+  // 容量淘汰的回调，为空时直接丢弃
+  typename CacheBase<Key, Value>::EvictionListener evictionListener_;
+  // 运行统计
+  StatsRecorder stats_;
 };
 
+// 存放共享句柄的LRU，命中时锁内只复制句柄
+template <typename Key, typename Value>
+using LRUHandleCache =
+    HandleCache<Key, Value, LRUCache<Key, ValueHandle<Value>>>;
+
 } // namespace CacheMgr
\ No newline at end of file
@@ -0,0 +1,240 @@
+/*
+LRU-Buffered:
+读多写少场景下的LRU分片。普通LRU的get需要调整链表顺序，只能持有独占锁，
+即使全部是读请求也会在同一分片上串行。本实现参考Caffeine的读缓冲区：
+    1. get只持有共享锁完成查找与取值，多个读线程可以并行命中
+    2. 命中的槽位下标写入按线程分条的有损环形缓冲区，不修改链表
+    3. 缓冲区接近写满时尝试获取独占锁，批量把命中记录回放为链表上的最近访问
+    4. put/remove在修改链表前先回放缓冲区，保证记录的槽位仍指向原节点
+缓冲区写满时直接丢弃访问记录，最近访问顺序是近似的LRU，但读路径不再争抢独占锁。
+*/
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <utility>
+
+#include "CacheBase.h"
+#include "CacheBatch.h"
+#include "CacheLRU.h"
+
+namespace CacheMgr {
+
+template <typename Key, typename Value>
+class LRUBufferedCache : public CacheBase<Key, Value> {
+public:
+  using SlabType = LRUSlab<Key, Value>;
+
+  explicit LRUBufferedCache(int capacity)
+      : capacity_(capacity), slab_(capacity > 0 ? capacity : 0) {}
+
+  ~LRUBufferedCache() override = default;
+
+  void put(const Key &key, const Value &val) override {
+    if (0 >= capacity_) {
+      return;
+    }
+    TimedLockGuard<std::shared_mutex> lock(mutex_, stats_);
+    drainBuffers();
+    putLocked(key, val);
+  }
+
+  void put(const Key &key, Value &&val) override {
+    if (0 >= capacity_) {
+      return;
+    }
+    TimedLockGuard<std::shared_mutex> lock(mutex_, stats_);
+    drainBuffers();
+    putLocked(key, std::move(val));
+  }
+
+  bool get(const Key &key, Value &val) override {
+    bool needDrain = false;
+    {
+      std::shared_lock<std::shared_mutex> lock(mutex_);
+      uint32_t idx = slab_.find(key);
+      if (SlabType::kNil == idx) {
+        stats_.add(StatsRecorder::Miss);
+        return false;
+      }
+      stats_.add(StatsRecorder::Hit);
+      val = slab_.node(idx).getValue();
+      needDrain = recordAccess(idx);
+    }
+    // 缓冲区过半时尝试回放，获取不到独占锁说明已有线程在写，留给它回放
+    if (needDrain && mutex_.try_lock()) {
+      drainBuffers();
+      mutex_.unlock();
+    }
+    return true;
+  }
+
+  Value get(const Key &key) override {
+    Value val{};
+    get(key, val);
+    return val;
+  }
+
+  // 命中时在共享锁内直接读取缓存值，不产生复制；多个读线程可能同时调用visitor
+  bool visit(const Key &key,
+             const std::function<void(const Value &)> &visitor) override {
+    bool needDrain = false;
+    {
+      std::shared_lock<std::shared_mutex> lock(mutex_);
+      uint32_t idx = slab_.find(key);
+      if (SlabType::kNil == idx) {
+        stats_.add(StatsRecorder::Miss);
+        return false;
+      }
+      stats_.add(StatsRecorder::Hit);
+      visitor(slab_.node(idx).getValue());
+      needDrain = recordAccess(idx);
+    }
+    if (needDrain && mutex_.try_lock()) {
+      drainBuffers();
+      mutex_.unlock();
+    }
+    return true;
+  }
+
+  // 整批只加一次独占锁，回放一次读缓冲区
+  void putBatch(const Key *keys, const Value *vals, const uint32_t *order,
+                size_t count) override {
+    if (0 >= capacity_) {
+      return;
+    }
+    TimedLockGuard<std::shared_mutex> lock(mutex_, stats_);
+    drainBuffers();
+    for (size_t i = 0; i < count; ++i) {
+      size_t idx = detail::batchIndex(order, i);
+      putLocked(keys[idx], vals[idx]);
+    }
+  }
+
+  // 整批只加一次共享锁，查找时提前预取后续关键字的哈希桶与节点
+  size_t getBatch(const Key *keys, const uint32_t *order, size_t count,
+                  Value *vals, bool *hits) override {
+    size_t hitNum = 0;
+    bool needDrain = false;
+    {
+      std::shared_lock<std::shared_mutex> lock(mutex_);
+      for (size_t i = 0; i < count; ++i) {
+        slab_.prefetchBatch(keys, order, count, i);
+        size_t idx = detail::batchIndex(order, i);
+        uint32_t slot = slab_.find(keys[idx]);
+        hits[idx] = SlabType::kNil != slot;
+        if (hits[idx]) {
+          vals[idx] = slab_.node(slot).getValue();
+          needDrain |= recordAccess(slot);
+          ++hitNum;
+        }
+      }
+    }
+    stats_.add(StatsRecorder::Hit, hitNum);
+    stats_.add(StatsRecorder::Miss, count - hitNum);
+    if (needDrain && mutex_.try_lock()) {
+      drainBuffers();
+      mutex_.unlock();
+    }
+    return hitNum;
+  }
+
+  CacheStats stats() const override { return stats_.snapshot(); }
+
+  // 删除指定缓存
+  void remove(const Key &key) {
+    TimedLockGuard<std::shared_mutex> lock(mutex_, stats_);
+    drainBuffers();
+    uint32_t idx = slab_.find(key);
+    if (SlabType::kNil != idx) {
+      slab_.node(idx).setValue(Value());
+      slab_.erase(idx);
+    }
+  }
+
+private:
+  // 每条缓冲区的记录数量，必须是2的幂
+  static constexpr uint64_t kBufferSize = 32;
+  // 缓冲区条数，必须是2的幂
+  static constexpr size_t kStripeNum = 16;
+
+  // 单条读缓冲区，独占一条缓存行避免伪共享
+  struct alignas(64) ReadBuffer {
+    // 已写入的记录总数，仅在共享锁下由读线程推进
+    std::atomic<uint64_t> writeCount{0};
+    // 已回放的记录总数，仅在独占锁下推进
+    std::atomic<uint64_t> readCount{0};
+    // 命中的槽位下标
+    std::atomic<uint32_t> slots[kBufferSize];
+  };
+
+  // 当前线程使用的缓冲区条号
+  static size_t stripeIndex() {
+    static thread_local size_t stripe =
+        std::hash<std::thread::id>{}(std::this_thread::get_id());
+    return stripe & (kStripeNum - 1);
+  }
+
+  template <typename V> void putLocked(const Key &key, V &&val) {
+    stats_.add(StatsRecorder::Put);
+    uint32_t idx = slab_.find(key);
+    if (SlabType::kNil != idx) {
+      slab_.node(idx).setValue(std::forward<V>(val));
+      slab_.touch(idx);
+      return;
+    }
+    if (slab_.full()) {
+      slab_.erase(slab_.leastRecent());
+      stats_.add(StatsRecorder::Eviction);
+    }
+    slab_.insert(key, std::forward<V>(val));
+  }
+
+  // 记录一次命中，返回缓冲区是否需要回放
+  bool recordAccess(uint32_t idx) {
+    ReadBuffer &buffer = buffers_[stripeIndex()];
+    uint64_t read = buffer.readCount.load(std::memory_order_relaxed);
+    uint64_t write = buffer.writeCount.load(std::memory_order_relaxed);
+    do {
+      if (write - read >= kBufferSize) {
+        return true; // 缓冲区已满，丢弃本次访问记录
+      }
+    } while (!buffer.writeCount.compare_exchange_weak(
+        write, write + 1, std::memory_order_relaxed));
+    buffer.slots[write & (kBufferSize - 1)].store(idx,
+                                                  std::memory_order_relaxed);
+    return write + 1 - read >= kBufferSize / 2;
+  }
+
+  // 在独占锁下把缓冲区中的命中记录回放为最近访问
+  void drainBuffers() {
+    for (ReadBuffer &buffer : buffers_) {
+      uint64_t read = buffer.readCount.load(std::memory_order_relaxed);
+      uint64_t write = buffer.writeCount.load(std::memory_order_relaxed);
+      for (; read != write; ++read) {
+        slab_.touch(
+            buffer.slots[read & (kBufferSize - 1)].load(
+                std::memory_order_relaxed));
+      }
+      buffer.readCount.store(read, std::memory_order_relaxed);
+    }
+  }
+
+private:
+  // 缓存容量
+  int capacity_;
+  // 读写锁，读共享、写独占
+  std::shared_mutex mutex_;
+  // 节点槽位池（索引与最近访问链表）
+  SlabType slab_;
+  // 按线程分条的读缓冲区
+  ReadBuffer buffers_[kStripeNum];
+  // 运行统计
+  StatsRecorder stats_;
+};
+
+} // namespace CacheMgr
\ No newline at end of file
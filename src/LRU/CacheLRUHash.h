@@ -11,61 +11,314 @@ LFU引入哈希算法，将缓存数据分散到N个LFU上，查询时也按照
 */
 #pragma once
 
+#include "CacheElastic.h"
+#include "CacheFront.h"
+#include "CacheHandle.h"
+#include "CacheLoader.h"
 #include "CacheLRU.h"
-#include <cmath>
+#include "CacheLRUBuffered.h"
+#include "CacheMRC.h"
+#include "CacheNuma.h"
+#include "CachePipeline.h"
+#include "CacheTiered.h"
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <string>
 #include <thread>
+#include <utility>
 #include <vector>
 
 namespace CacheMgr {
 
-template <typename Key, typename Value> class LRUHashCache {
+// Slice为分片类型，默认使用LRUCache；读多写少时可选用LRUBufferedCache，
+// 命中只持有共享锁，最近访问顺序通过读缓冲区批量回放
+template <typename Key, typename Value,
+          typename Slice = LRUCache<Key, Value>>
+class LRUHashCache {
 public:
   explicit LRUHashCache(size_t capacity, int sliceNum)
-      : capacity_(capacity),
-        sliceNum_(sliceNum > 0 ? sliceNum
-                               : std::thread::hardware_concurrency()) {
-    // 计算分片大小
-    size_t sliceSize = std::ceil(capacity / static_cast<double>(sliceNum_));
-    for (size_t idx = 0; idx < sliceNum_; ++idx) {
-      lruSliceCaches_.emplace_back(new LRUCache<Key, Value>(sliceSize));
-    }
-  }
+      : capacity_(capacity), weighted_(false),
+        slices_(capacity,
+                sliceNum > 0 ? sliceNum : std::thread::hardware_concurrency(),
+                [](size_t sliceSize) {
+                  return std::unique_ptr<Slice>(new Slice(sliceSize));
+                }) {}
+
+  // 按权重计容量：总权重预算按分片数均分，分片需支持(分片预算, weigher)构造
+  explicit LRUHashCache(size_t maxWeight, int sliceNum,
+                        const CacheWeigher<Key, Value> &weigher)
+      : capacity_(maxWeight), weighted_(true),
+        slices_(maxWeight,
+                sliceNum > 0 ? sliceNum : std::thread::hardware_concurrency(),
+                [weigher](size_t sliceWeight) {
+                  return std::unique_ptr<Slice>(new Slice(sliceWeight, weigher));
+                }) {}
 
   virtual ~LRUHashCache() = default;
 
   void put(const Key &key, const Value &val) {
-    // 获取key的hash值，并计算出对应的分片索引
-    size_t sliceIndex = Hash(key) % sliceNum_;
-    lruSliceCaches_[sliceIndex]->put(key, val);
+    slices_.apply(key, [&](Slice &slice) { slice.put(key, val); });
+    slices_.rebalance();
+  }
+
+  void put(const Key &key, Value &&val) {
+    slices_.apply(key, [&](Slice &slice) { slice.put(key, std::move(val)); });
+    slices_.rebalance();
+  }
+
+  // 由构造参数构造临时值，再移动写入所在的分片
+  template <typename... Args> void emplace(const Key &key, Args &&...args) {
+    put(key, Value(std::forward<Args>(args)...));
+  }
+
+  // 带存活时间的写入
+  void put(const Key &key, const Value &val, std::chrono::milliseconds ttl) {
+    slices_.apply(key, [&](Slice &slice) { slice.put(key, val, ttl); });
+    slices_.rebalance();
+  }
+
+  void put(const Key &key, Value &&val, std::chrono::milliseconds ttl) {
+    slices_.apply(key,
+                  [&](Slice &slice) { slice.put(key, std::move(val), ttl); });
+    slices_.rebalance();
+  }
+
+  // 删除指定缓存
+  void remove(const Key &key) {
+    slices_.apply(key, [&](Slice &slice) { slice.remove(key); });
+  }
+
+  // 逐个分片清理已到期的缓存
+  void purgeExpired() {
+    slices_.forEach([](Slice &slice) { slice.purgeExpired(); });
+  }
+
+  // 为每个分片设置容量淘汰的回调，需在并发访问开始之前调用；回调在分片的锁内执行
+  void setEvictionListener(
+      const typename CacheBase<Key, Value>::EvictionListener &listener) {
+    slices_.configure(
+        [listener](Slice &slice) { slice.setEvictionListener(listener); });
+  }
+
+  /// @brief 各分片共用总容量，不再各自按均分的容量淘汰；写入后超出总容量时随机抽取samples个分片，
+  ///        在其中最久未访问（LFU为频次最低）的条目所在的分片上淘汰，需在并发访问开始之前调用
+  void enableGlobalEviction(int samples = 5) {
+    slices_.enableGlobalEviction(samples > 0 ? samples : 1);
+  }
+
+  /// @brief 调整总容量（按权重计容量时为总权重预算），扩容立即生效；
+  ///        缩容由后台线程逐个分片分批淘汰，不在调用线程里一次淘汰完
+  void resize(size_t capacity) {
+    capacity_ = capacity;
+    slices_.resize(capacity);
+  }
+
+  /// @brief 在线调整分片数，后台线程一次迁移一个旧分片，其余分片照常读写
+  void reshard(int sliceNum) {
+    slices_.reshard(sliceNum > 0 ? sliceNum : std::thread::hardware_concurrency());
+  }
+
+  // 等待进行中的缩容与分片迁移完成
+  void waitResized() { slices_.waitSettled(); }
+
+  // 当前的分片数，迁移期间为迁移前的分片数
+  size_t sliceCount() const { return slices_.sliceCount(); }
+
+  /// @brief 把各分片的缓存写入快照文件，逐个分片在分片锁内复制，锁外写文件，不停止读写；
+  ///        期间暂停分片迁移
+  /// @param path 快照文件路径
+  /// @return 写入成功返回true
+  bool saveSnapshot(const std::string &path) {
+    return slices_.withSlices([&path](const std::vector<Slice *> &slices) {
+      return SnapshotFile<Key, Value>::save(
+          path, Slice::kSnapshotPolicy, slices.size(),
+          [&slices](size_t idx) { return slices[idx]->snapshot(); });
+    });
+  }
+
+  /// @brief 从快照文件恢复，条目按当前的分片规则重新分组，每个分片一次加锁批量写入；
+  ///        用于启动时的空缓存，已有的关键字保留现值
+  /// @return 快照完整、校验通过且策略一致时返回true
+  bool loadSnapshot(const std::string &path) {
+    SnapshotShard<Key, Value> entries;
+    bool ok = SnapshotFile<Key, Value>::load(
+        path, Slice::kSnapshotPolicy, [&](SnapshotShard<Key, Value> &&shard) {
+          std::move(shard.begin(), shard.end(), std::back_inserter(entries));
+        });
+    if (!ok) {
+      return false;
+    }
+    slices_.restore(std::move(entries));
+    return true;
+  }
+
+  // 各分片统计之和，包括迁移中已释放的旧分片
+  CacheStats stats() const {
+    CacheStats total = slices_.retiredStats();
+    slices_.forEach([&total](Slice &slice) { total += slice.stats(); });
+    return total;
+  }
+
+  // 单个分片的统计，用于观察分片间的负载与锁竞争是否均衡；迁移期间下标包括新旧两张表
+  CacheStats sliceStats(size_t sliceIndex) const {
+    return slices_.withSlices([sliceIndex](const std::vector<Slice *> &slices) {
+      return sliceIndex < slices.size() ? slices[sliceIndex]->stats()
+                                        : CacheStats();
+    });
+  }
+
+  /// @brief 开启未命中率曲线估计，需在并发访问开始之前调用
+  /// @param maxCapacity 曲线覆盖的最大容量（条目数），为0时取当前容量的4倍；
+  ///        按权重计容量时无法由权重预算推算条目数，必须给出，为0时不开启
+  /// @param sampleRate 读请求的采样率
+  void enableMissRatioCurve(size_t maxCapacity = 0, double sampleRate = 0.001) {
+    if (weighted_ && 0 == maxCapacity) {
+      return;
+    }
+    monitor_.reset(new MissRatioMonitor<Key>(
+        0 != maxCapacity ? maxCapacity : 4 * static_cast<size_t>(capacity_),
+        sampleRate));
+    CacheStats total = stats();
+    monitorBase_ = total.hits + total.misses;
+  }
+
+  // 估计的未命中率-容量曲线，未开启时为空；以开启之后分片统计的读请求数修正采样偏差
+  MissRatioCurve missRatioCurve() const {
+    if (nullptr == monitor_) {
+      return MissRatioCurve();
+    }
+    CacheStats total = stats();
+    return monitor_->curve(total.hits + total.misses - monitorBase_);
   }
 
   bool get(const Key &key, Value &val) {
-    // 获取key的hash值，并计算出对应的分片索引
-    size_t sliceIndex = Hash(key) % sliceNum_;
-    return lruSliceCaches_[sliceIndex]->get(key, val);
+    if (nullptr != monitor_) {
+      monitor_->access(key);
+    }
+    return slices_.apply(key, [&](Slice &slice) { return slice.get(key, val); });
   }
 
   Value get(const Key &key) {
-    Value val;
-    memset(&val, 0, sizeof(val));
+    Value val{};
     get(key, val);
     return val;
   }
 
+  /// @brief 访问缓存，未命中时调用loader加载；同一关键字上并发的未命中在分片内合并为一次加载
+  /// @param loader 加载函数，抛出的异常会传给所有等待这次加载的线程
+  Value getOrLoad(const Key &key,
+                  const typename CacheBase<Key, Value>::Loader &loader) {
+    if (nullptr != monitor_) {
+      monitor_->access(key);
+    }
+    Value val = slices_.apply(
+        key, [&](Slice &slice) { return slice.getOrLoad(key, loader); });
+    slices_.rebalance();
+    return val;
+  }
+
+  // getOrLoad的异步版本，未命中时在新线程中加载；加载线程的查找与写入都重新经过分片路由，
+  // 不在分片内等待，加载期间分片可以照常迁出
+  std::shared_future<Value>
+  getOrLoadAsync(const Key &key, typename CacheBase<Key, Value>::Loader loader) {
+    if (nullptr != monitor_) {
+      monitor_->access(key);
+    }
+    Value val;
+    if (sliceGet(key, val)) {
+      std::promise<Value> ready;
+      ready.set_value(std::move(val));
+      return ready.get_future().share();
+    }
+    return asyncLoads_.loadAsync(
+        key, [this](const Key &k, Value &v) { return sliceGet(k, v); },
+        std::move(loader), [this](const Key &k, const Value &v) { put(k, v); });
+  }
+
+  // 命中时在分片的锁内以常量引用调用visitor，不复制缓存值
+  bool visit(const Key &key,
+             const std::function<void(const Value &)> &visitor) {
+    if (nullptr != monitor_) {
+      monitor_->access(key);
+    }
+    return slices_.apply(
+        key, [&](Slice &slice) { return slice.visit(key, visitor); });
+  }
+
+  // 批量添加缓存，先按分片分组，每个分片只加一次锁
+  void putMany(const Key *keys, const Value *vals, size_t count) {
+    slices_.applyBatch(keys, count,
+                       [keys, vals](Slice &slice, const uint32_t *order,
+                                    size_t num) {
+                         slice.putBatch(keys, vals, order, num);
+                       });
+    slices_.rebalance(count);
+  }
+
+  // 批量访问缓存，先按分片分组，每个分片只加一次锁，返回命中数量
+  size_t getMany(const Key *keys, size_t count, Value *vals, bool *hits) {
+    if (nullptr != monitor_) {
+      for (size_t idx = 0; idx < count; ++idx) {
+        monitor_->access(keys[idx]);
+      }
+    }
+    size_t hitNum = 0;
+    slices_.applyBatch(keys, count,
+                       [&](Slice &slice, const uint32_t *order, size_t num) {
+                         hitNum += slice.getBatch(keys, order, num, vals, hits);
+                       });
+    return hitNum;
+  }
+
 private:
-  // 将Key转换为对应hash值
-  size_t Hash(const Key &key) {
-    std::hash<Key> hashFunc;
-    return hashFunc(key);
+  // 在关键字当前所在的分片上查找，不经过未命中率监视器
+  bool sliceGet(const Key &key, Value &val) {
+    return slices_.apply(key, [&](Slice &slice) { return slice.get(key, val); });
   }
 
 private:
-  // 总容量
+  // 总容量（按权重计容量时为总权重预算）
   size_t capacity_;
-  // 切片数量
-  int sliceNum_;
-  // 切片LRU缓存
-  std::vector<std::unique_ptr<LRUCache<Key, Value>>> lruSliceCaches_;
+  // 是否按权重计容量
+  bool weighted_;
+  // 切片LRU缓存，可在线调整容量与分片数
+  ElasticSlices<Key, Value, Slice> slices_;
+  // 未命中率曲线监视器，未开启时为空
+  std::unique_ptr<MissRatioMonitor<Key>> monitor_;
+  // 开启曲线估计时的累计读请求数
+  uint64_t monitorBase_ = 0;
+  // 进行中的异步加载，在包装一层合并同一关键字的未命中
+  LoadTable<Key, Value> asyncLoads_;
 };
 
+// 读路径只持有共享锁的LRU分片缓存
+template <typename Key, typename Value>
+using LRUBufferedHashCache =
+    LRUHashCache<Key, Value, LRUBufferedCache<Key, Value>>;
+
+// 存放共享句柄的LRU分片缓存
+template <typename Key, typename Value>
+using LRUHashHandleCache =
+    HandleCache<Key, Value, LRUHashCache<Key, ValueHandle<Value>>>;
+
+// 带提前刷新与写回流水线的LRU分片缓存
+template <typename Key, typename Value>
+using LRUHashPipelinedCache =
+    PipelinedCache<Key, Value, LRUHashCache<Key, StampedValue<Value>>>;
+
+// 按NUMA节点分组的LRU分片缓存
+template <typename Key, typename Value>
+using LRUHashNumaCache = NumaHashCache<Key, Value, LRUHashCache<Key, Value>>;
+
+// 热点经线程本地L1命中、不加分片锁的LRU分片缓存
+template <typename Key, typename Value>
+using LRUHashFrontCache = FrontCache<Key, Value, LRUHashCache<Key, Value>>;
+
+// 淘汰的条目降级到本地盘日志的两层LRU分片缓存
+template <typename Key, typename Value>
+using LRUHashTieredCache = TieredCache<Key, Value, LRUHashCache<Key, Value>>;
+
 } // namespace CacheMgr
\ No newline at end of file
@@ -4,96 +4,155 @@ LRU-k算法是对LRU算法的改进，基础的LRU算法被访问数据进入缓
 LRU-k算法有两个队列一个是缓存队列，一个是数据访问历史队列。当访问一个数据时，首先将其添加进入访问历史队列并进行累加访问次数，当该数据的访问次数超过k次后，才将数据缓存到缓存队列，从而避免缓存队列被冷数据所污染。同时访问历史队列中的数据也不是一直保留的，也是需要按照LRU的规则进行淘汰的。
 一般情况下，当k的值越大，缓存的命中率越高，但也使得缓存难以淘汰。综合来说，k = 2
 时性能最优。
+访问历史只记录关键字指纹与访问次数（GhostList），不保存关键字本身；未达到k次的待定值按指纹存放，
+历史弹出某个指纹时一并释放其待定值，待定值的数量不超过历史容量。
 */
 #pragma once
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+#include "CacheFlatMap.h"
+#include "CacheGhost.h"
 #include "CacheLRU.h"
 
 namespace CacheMgr {
 
-template <typename Key, typename Value>
+template <typename Key, typename Value,
+          template <typename, typename> class Index = CacheIndexMap>
 class LRUKCache : public LRUCache<Key, Value> {
 public:
   explicit LRUKCache(int capatity, int histCapatity, int k)
       : LRUCache<Key, Value>(capatity),
-        histList_(std::make_unique<LRUCache<Key, size_t>>(histCapatity)),
-        k_(k) {}
+        k_(k), history_(histCapatity > 0 ? histCapatity : 0) {}
 
   virtual ~LRUKCache() override = default;
 
-  void put(const Key& key, const Value& val) override {
-    // 检查主缓存是否已有数据
-    Value existingVal{};
-    if (LRUCache<Key, Value>::get(key, existingVal)) {
-      // 已在主缓存，直接更新
-      LRUCache<Key, Value>::put(key, val);
-      return;
-    }
-
-    // 获取并更新访问历史
-    size_t histCount = histList_->get(key);
-    ++histCount;
-    histList_->put(key, histCount);
-    // 保存值到历史记录映射，供后续get操作使用
-    histValMap_[key] = val;
+  void put(const Key& key, const Value& val) override { putImpl(key, val); }
 
-    // 检查是否达到k次访问阈值
-    if (histCount >= k_) {
-      // 达到阈值，添加到主缓存
-      histList_->remove(key);
-      histValMap_.erase(key);
-      LRUCache<Key, Value>::put(key, val);
-    }
+  void put(const Key& key, Value&& val) override {
+    putImpl(key, std::move(val));
   }
 
   bool get(const Key& key, Value &val) override {
+    return access(key, [&val](const Value &cached) { val = cached; });
+  }
+
+  Value get(const Key& key) override {
+    Value val{};
+    get(key, val);
+    return val;
+  }
+
+  // 访问需要经过访问历史，命中时在锁内直接读取主缓存中的值
+  bool visit(const Key& key,
+             const std::function<void(const Value &)> &visitor) override {
+    return access(key, visitor);
+  }
+
+  // 批量操作需要经过访问历史，不能沿用LRUCache直接访问主缓存的批量实现
+  void putBatch(const Key *keys, const Value *vals, const uint32_t *order,
+                size_t count) override {
+    CacheBase<Key, Value>::putBatch(keys, vals, order, count);
+  }
+
+  size_t getBatch(const Key *keys, const uint32_t *order, size_t count,
+                  Value *vals, bool *hits) override {
+    return CacheBase<Key, Value>::getBatch(keys, order, count, vals, hits);
+  }
+
+  // 命中与写入按LRU-K的接口统计，淘汰取主缓存的统计，锁时间为访问历史锁的时间
+  CacheStats stats() const override {
+    CacheStats stats = stats_.snapshot();
+    stats.evictions = LRUCache<Key, Value>::stats().evictions;
+    return stats;
+  }
+
+private:
+  // 访问关键字并更新访问历史，命中时以主缓存中的值调用onHit
+  template <typename F> bool access(const Key& key, F &&onHit) {
+    TimedLockGuard<std::mutex> lock(histMutex_, stats_);
     // 优先尝试从主缓存中查询数据
-    bool inMainCache = LRUCache<Key, Value>::get(key, val);
+    bool inMainCache = LRUCache<Key, Value>::visit(key, onHit);
 
     // 获取并更新访问历史计数
-    size_t histCount = histList_->get(key);
-    ++histCount;
-    histList_->put(key, histCount);
+    size_t histCount = touchHistory(key);
 
     // 如果数据在主缓存中，直接返回
     if (inMainCache) {
+      stats_.add(StatsRecorder::Hit);
       return true;
     }
 
     // 如果数据不在主缓存，但访问次数达到了k次
     if (histCount >= k_) {
       // 检查是否有历史记录值
-      auto it = histValMap_.find(key);
-      if (histValMap_.end() != it) {
-        // 有历史值，将其添加到主缓存
-        val = it->second;
-        // 删除历史记录
-        histList_->remove(key);
-        histValMap_.erase(it);
-        // 添加到主缓存
-        LRUCache<Key, Value>::put(key, val);
-
-        return true;
+      auto it = pending_.find(GhostList<Key>::fingerprint(key));
+      if (pending_.end() != it && it->second.first == key) {
+        // 删除历史记录，待定值直接移入主缓存
+        history_.erase(key);
+        LRUCache<Key, Value>::put(key, std::move(it->second.second));
+        pending_.erase(it);
+        stats_.add(StatsRecorder::Promotion);
+        stats_.add(StatsRecorder::Hit);
+        return LRUCache<Key, Value>::visit(key, onHit);
       }
       // 没有历史值记录，无法添加到缓存，返回默认值
     }
 
     // 数据不在主缓存且不满足添加条件，返回false
+    stats_.add(StatsRecorder::Miss);
     return false;
   }
 
-  Value get(const Key& key) override {
-    Value val{};
-    get(key, val);
-    return val;
+  template <typename V> void putImpl(const Key& key, V&& val) {
+    TimedLockGuard<std::mutex> lock(histMutex_, stats_);
+    stats_.add(StatsRecorder::Put);
+    // 检查主缓存是否已有数据，只判断存在与否，不复制缓存值
+    if (LRUCache<Key, Value>::visit(key, [](const Value &) {})) {
+      // 已在主缓存，直接更新
+      LRUCache<Key, Value>::put(key, std::forward<V>(val));
+      return;
+    }
+
+    // 获取并更新访问历史
+    size_t histCount = touchHistory(key);
+
+    // 检查是否达到k次访问阈值
+    if (histCount >= k_) {
+      // 达到阈值，添加到主缓存
+      history_.erase(key);
+      pending_.erase(GhostList<Key>::fingerprint(key));
+      LRUCache<Key, Value>::put(key, std::forward<V>(val));
+      stats_.add(StatsRecorder::Promotion);
+      return;
+    }
+    // 保存值到待定值映射，供后续get操作使用；历史容量为0时没有记录，不保存
+    if (history_.contains(key)) {
+      auto &slot = pending_[GhostList<Key>::fingerprint(key)];
+      slot.first = key;
+      slot.second = std::forward<V>(val);
+    }
+  }
+
+  // 累加关键字的访问次数，历史弹出的指纹同时释放其待定值
+  size_t touchHistory(const Key& key) {
+    return history_.touch(key, [this](uint64_t fp) { pending_.erase(fp); });
   }
 
-private:
   // 进入缓存队列的评判标准
   int k_;
-  // 访问数据历史记录（value为访问次数）
-  std::unique_ptr<LRUCache<Key, size_t>> histList_;
-  // 存储未达到k次访问的数据值
-  std::unordered_map<Key, Value> histValMap_;
+  // 访问数据历史记录，只保存关键字指纹与访问次数
+  GhostList<Key> history_;
+  // 存储未达到k次访问的数据值，以关键字指纹索引，保存关键字用于排除指纹冲突
+  Index<uint64_t, std::pair<Key, Value>> pending_;
+  // 保护访问历史与主缓存之间的组合操作，历史计数与待定值需要一起更新
+  std::mutex histMutex_;
+  // LRU-K接口层面的运行统计
+  StatsRecorder stats_;
 };
 
 } // namespace CacheMgr
\ No newline at end of file
@@ -0,0 +1,34 @@
+/*
+HashLRU-K:
+LRU-K的哈希分片版本，主缓存容量与历史记录容量都按分片数均分（向上取整），
+同一关键字的访问历史与缓存数据总在同一分片内。
+*/
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+#include "CacheLRUK.h"
+#include "CacheSharded.h"
+
+namespace CacheMgr {
+
+template <typename Key, typename Value>
+class LRUKHashCache : public ShardedCache<Key, Value, LRUKCache<Key, Value>> {
+public:
+  using Base = ShardedCache<Key, Value, LRUKCache<Key, Value>>;
+
+  explicit LRUKHashCache(size_t capacity, size_t histCapacity, int k,
+                         int shardNum)
+      : Base(capacity, shardNum,
+             [histCapacity, k, shardNum](size_t shardCapacity) {
+               size_t count = Base::roundShardCount(shardNum);
+               return std::make_unique<LRUKCache<Key, Value>>(
+                   static_cast<int>(shardCapacity),
+                   static_cast<int>((histCapacity + count - 1) / count), k);
+             }) {}
+
+  ~LRUKHashCache() override = default;
+};
+
+} // namespace CacheMgr
\ No newline at end of file
@@ -0,0 +1,253 @@
+/*
+SlabArena:
+分片独占的节点内存池，替代全局malloc分配缓存节点与索引节点：
+    1. 按16字节对齐的尺寸分成32个尺寸级别（最大512字节），每个级别一条空闲链表，
+       空闲块内嵌链表指针，不额外占用内存
+    2. 空闲链表为空时从新的内存块切出一批，批大小随该级别已分配的块数翻倍，上限64KiB，
+       小容量的分片不会一次占用大块内存
+    3. 释放的块回到所属级别的链表头部，淘汰之后紧接着的插入复用刚释放的那块内存；
+       内存只在分池析构时归还系统，持续淘汰下常驻内存稳定在峰值，不产生碎片
+    4. 超过512字节或对齐要求超过16字节的分配直接转给全局堆
+本类不加锁，由外层缓存负责同步；节点必须在持有分片锁时分配与释放。
+HeapArena是同样接口的全局堆实现，作为各策略Arena参数的默认值，不改变原有的分配方式。
+*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace CacheMgr {
+
+// 全局堆，不做任何池化
+struct HeapArena {
+  void *allocate(size_t bytes) { return ::operator new(bytes); }
+  void deallocate(void *ptr, size_t) { ::operator delete(ptr); }
+};
+
+class SlabArena {
+public:
+  // 池化分配的对齐粒度
+  static constexpr size_t kAlign = 16;
+  // 池化分配的最大尺寸
+  static constexpr size_t kMaxBytes = 512;
+
+  SlabArena() : reservedBytes_(0), liveBytes_(0) {
+    for (size_t cls = 0; cls < kClasses; ++cls) {
+      freeLists_[cls] = nullptr;
+      blockNums_[cls] = 0;
+    }
+  }
+
+  SlabArena(const SlabArena &) = delete;
+  SlabArena &operator=(const SlabArena &) = delete;
+
+  ~SlabArena() {
+    for (void *chunk : chunks_) {
+      ::operator delete(chunk);
+    }
+  }
+
+  void *allocate(size_t bytes) {
+    if (bytes > kMaxBytes) {
+      return ::operator new(bytes);
+    }
+    size_t cls = classOf(bytes);
+    if (nullptr == freeLists_[cls]) {
+      refill(cls);
+    }
+    FreeBlock *block = freeLists_[cls];
+    freeLists_[cls] = block->next;
+    liveBytes_ += bytesOf(cls);
+    return block;
+  }
+
+  void deallocate(void *ptr, size_t bytes) {
+    if (bytes > kMaxBytes) {
+      ::operator delete(ptr);
+      return;
+    }
+    size_t cls = classOf(bytes);
+    FreeBlock *block = static_cast<FreeBlock *>(ptr);
+    block->next = freeLists_[cls];
+    freeLists_[cls] = block;
+    liveBytes_ -= bytesOf(cls);
+  }
+
+  // 从系统取得的内存总量，只增不减
+  size_t reservedBytes() const { return reservedBytes_; }
+  // 正在使用的池化内存
+  size_t liveBytes() const { return liveBytes_; }
+
+private:
+  // 尺寸级别数
+  static constexpr size_t kClasses = kMaxBytes / kAlign;
+  // 一次切出的内存块上限
+  static constexpr size_t kMaxChunkBytes = 64 * 1024;
+  // 一次切出的最少块数
+  static constexpr size_t kMinBlocks = 8;
+
+  struct FreeBlock {
+    FreeBlock *next;
+  };
+
+  static size_t classOf(size_t bytes) {
+    return bytes > kAlign ? (bytes - 1) / kAlign : 0;
+  }
+  static size_t bytesOf(size_t cls) { return (cls + 1) * kAlign; }
+
+  // 为尺寸级别切出一批空闲块，批大小随已分配的块数翻倍
+  void refill(size_t cls) {
+    size_t blockBytes = bytesOf(cls);
+    size_t blocks = blockNums_[cls] > kMinBlocks ? blockNums_[cls] : kMinBlocks;
+    if (blocks * blockBytes > kMaxChunkBytes) {
+      blocks = kMaxChunkBytes / blockBytes;
+    }
+    char *chunk = static_cast<char *>(::operator new(blocks * blockBytes));
+    chunks_.push_back(chunk);
+    reservedBytes_ += blocks * blockBytes;
+    blockNums_[cls] += blocks;
+    for (size_t idx = blocks; idx > 0; --idx) {
+      FreeBlock *block = reinterpret_cast<FreeBlock *>(chunk + (idx - 1) * blockBytes);
+      block->next = freeLists_[cls];
+      freeLists_[cls] = block;
+    }
+  }
+
+private:
+  FreeBlock *freeLists_[kClasses]; // 各尺寸级别的空闲链表
+  size_t blockNums_[kClasses];     // 各尺寸级别已切出的块数
+  std::vector<void *> chunks_;     // 从系统取得的内存块
+  size_t reservedBytes_;           // 内存块总量
+  size_t liveBytes_;               // 正在使用的池化内存
+};
+
+// 从分池分配单个对象的标准分配器，数组分配（如哈希表的桶数组）仍走全局堆；
+// 默认构造时不绑定分池，等同于std::allocator
+template <typename T, typename Arena> class ArenaAllocator {
+public:
+  using value_type = T;
+
+  template <typename U> struct rebind {
+    using other = ArenaAllocator<U, Arena>;
+  };
+
+  ArenaAllocator() noexcept : arena_(nullptr) {}
+  explicit ArenaAllocator(Arena *arena) noexcept : arena_(arena) {}
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U, Arena> &other) noexcept
+      : arena_(other.arena()) {}
+
+  T *allocate(size_t num) {
+    if (pooled(num)) {
+      return static_cast<T *>(arena_->allocate(sizeof(T)));
+    }
+    return std::allocator<T>().allocate(num);
+  }
+
+  void deallocate(T *ptr, size_t num) {
+    if (pooled(num)) {
+      arena_->deallocate(ptr, sizeof(T));
+      return;
+    }
+    std::allocator<T>().deallocate(ptr, num);
+  }
+
+  Arena *arena() const { return arena_; }
+
+  template <typename U>
+  bool operator==(const ArenaAllocator<U, Arena> &other) const {
+    return arena_ == other.arena();
+  }
+  template <typename U>
+  bool operator!=(const ArenaAllocator<U, Arena> &other) const {
+    return arena_ != other.arena();
+  }
+
+private:
+  bool pooled(size_t num) const {
+    return nullptr != arena_ && 1 == num && alignof(T) <= SlabArena::kAlign;
+  }
+
+  Arena *arena_; // 所用的分池，为空时使用全局堆
+};
+
+// unique_ptr的删除器，析构后把内存还给分池
+template <typename T, typename Arena> class ArenaDelete {
+public:
+  ArenaDelete() noexcept : arena_(nullptr) {}
+  explicit ArenaDelete(Arena *arena) noexcept : arena_(arena) {}
+
+  void operator()(T *ptr) const {
+    ptr->~T();
+    arena_->deallocate(ptr, sizeof(T));
+  }
+
+private:
+  Arena *arena_; // 节点所在的分池
+};
+
+// 全局堆上的节点直接delete，删除器不占空间
+template <typename T> class ArenaDelete<T, HeapArena> {
+public:
+  ArenaDelete() noexcept = default;
+  explicit ArenaDelete(HeapArena *) noexcept {}
+
+  void operator()(T *ptr) const { delete ptr; }
+};
+
+// 分池所有的节点
+template <typename T, typename Arena>
+using ArenaPtr = std::unique_ptr<T, ArenaDelete<T, Arena>>;
+
+/// @brief 在分池中构造节点
+template <typename T, typename Arena, typename... Args>
+ArenaPtr<T, Arena> makeArenaPtr(Arena &arena, Args &&...args) {
+  if constexpr (std::is_same<Arena, HeapArena>::value) {
+    return ArenaPtr<T, Arena>(new T(std::forward<Args>(args)...));
+  } else {
+    static_assert(alignof(T) <= SlabArena::kAlign, "over-aligned arena node");
+    void *mem = arena.allocate(sizeof(T));
+    try {
+      return ArenaPtr<T, Arena>(new (mem) T(std::forward<Args>(args)...),
+                                ArenaDelete<T, Arena>(&arena));
+    } catch (...) {
+      arena.deallocate(mem, sizeof(T));
+      throw;
+    }
+  }
+}
+
+// 使用分池的索引：默认索引退化为std::unordered_map时，其节点从分池分配；
+// FlatMap的槽位本就是一整块连续数组，全局堆上的索引保持原样
+template <template <typename, typename> class Index, typename Key, typename T,
+          typename Arena>
+struct ArenaIndex {
+  using Base = Index<Key, T>;
+  static constexpr bool kPooled =
+      !std::is_same<Arena, HeapArena>::value &&
+      std::is_same<Base, std::unordered_map<Key, T>>::value;
+  using type = std::conditional_t<
+      kPooled,
+      std::unordered_map<Key, T, std::hash<Key>, std::equal_to<Key>,
+                         ArenaAllocator<std::pair<const Key, T>, Arena>>,
+      Base>;
+
+  static type make(Arena &arena) {
+    if constexpr (kPooled) {
+      return type(0, std::hash<Key>(), std::equal_to<Key>(),
+                  typename type::allocator_type(&arena));
+    } else {
+      (void)arena;
+      return type();
+    }
+  }
+};
+
+} // namespace CacheMgr
\ No newline at end of file
@@ -0,0 +1,144 @@
+/*
+GlobalBudget:
+分片缓存的全局容量预算，让各分片共用一个总容量，淘汰时在分片之间比较冷热：
+    1. 各分片不再各自按1/N的容量淘汰，分片自身的上限放宽到总容量，
+       条目数（按权重计容量时为权重）记入共享的计数，超出总容量后才淘汰
+    2. 淘汰时随机抽取几个分片，各自报告最该被淘汰的条目的冷度，在最冷的分片上淘汰一个，
+       与Redis的近似LRU/LFU相同的思路：LRU比较最久未访问条目的访问时钟，LFU比较最低的折算频次
+    3. 访问时钟是一个粗粒度的全局计数，每淘汰kTickEvictions个条目前进一格，
+       平时只被读取，不会在读写路径上产生缓存行争用
+    4. 分片内的计数变化先在分片锁内累计，攒够一批再提交到共享计数；
+       批大小随容量与分片数调整，总容量最多暂时超出约1/16
+关键字分布倾斜时，热分片可以占用冷分片让出的容量，命中率接近不分片的缓存，分片锁仍各自独立。
+*/
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace CacheMgr {
+
+class GlobalBudget {
+public:
+  /// @param capacity 总容量（按权重计容量时为总权重预算）
+  /// @param sliceNum 分片数，用于确定计数的提交批大小
+  GlobalBudget(size_t capacity, size_t sliceNum) : used_(0), evictions_(0), clock_(1) {
+    setCapacity(capacity, sliceNum);
+  }
+
+  GlobalBudget(const GlobalBudget &) = delete;
+  GlobalBudget &operator=(const GlobalBudget &) = delete;
+
+  // 调整总容量或分片数，缩小后由调用方淘汰到容量以内
+  void setCapacity(size_t capacity, size_t sliceNum) {
+    capacity_.store(static_cast<int64_t>(capacity), std::memory_order_relaxed);
+    size_t batch = capacity / (16 * std::max<size_t>(1, sliceNum));
+    batch_.store(static_cast<int64_t>(std::min<size_t>(std::max<size_t>(1, batch),
+                                                       kMaxBatch)),
+                 std::memory_order_relaxed);
+  }
+
+  // 提交计数的增减
+  void charge(int64_t units) { used_.fetch_add(units, std::memory_order_relaxed); }
+
+  // 记录一次跨分片淘汰，每kTickEvictions次推进访问时钟
+  void noteEviction() {
+    if (0 == evictions_.fetch_add(1, std::memory_order_relaxed) % kTickEvictions) {
+      clock_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  bool over() const {
+    return used_.load(std::memory_order_relaxed) >
+           capacity_.load(std::memory_order_relaxed);
+  }
+
+  int64_t used() const { return used_.load(std::memory_order_relaxed); }
+  size_t capacity() const {
+    return static_cast<size_t>(capacity_.load(std::memory_order_relaxed));
+  }
+  int64_t batch() const { return batch_.load(std::memory_order_relaxed); }
+
+  // 当前的访问时钟
+  uint32_t clock() const { return clock_.load(std::memory_order_relaxed); }
+
+private:
+  // 推进一格访问时钟的淘汰次数
+  static constexpr uint64_t kTickEvictions = 16;
+  // 计数提交批大小的上限
+  static constexpr size_t kMaxBatch = 32;
+
+  alignas(64) std::atomic<int64_t> used_;  // 已提交的条目数或权重
+  std::atomic<uint64_t> evictions_;        // 跨分片淘汰的次数
+  std::atomic<int64_t> capacity_;          // 总容量
+  std::atomic<int64_t> batch_;             // 计数的提交批大小
+  alignas(64) std::atomic<uint32_t> clock_; // 访问时钟，平时只读
+};
+
+// 分片持有的全局预算份额，在分片锁内使用；未接入全局预算时所有操作为空
+class BudgetShare {
+public:
+  BudgetShare() : global_(nullptr), pending_(0) {}
+
+  bool enabled() const { return nullptr != global_; }
+
+  /// @brief 接入全局预算，并提交分片中已有的条目数或权重
+  void attach(GlobalBudget *global, int64_t units) {
+    flush();
+    global_ = global;
+    pending_ = units;
+    flush();
+  }
+
+  // 累计计数的增减，攒够一批再提交
+  void charge(int64_t units) {
+    if (nullptr == global_) {
+      return;
+    }
+    pending_ += units;
+    if (pending_ >= global_->batch() || -pending_ >= global_->batch()) {
+      flush();
+    }
+  }
+
+  void flush() {
+    if (nullptr != global_ && 0 != pending_) {
+      global_->charge(pending_);
+      pending_ = 0;
+    }
+  }
+
+  // 当前的访问时钟，未接入时为0
+  uint32_t clock() const { return nullptr != global_ ? global_->clock() : 0; }
+
+  // 记录一次跨分片淘汰，并立即提交计数
+  void noteEviction() {
+    if (nullptr != global_) {
+      global_->noteEviction();
+      flush();
+    }
+  }
+
+private:
+  GlobalBudget *global_; // 全局预算，未接入时为空
+  int64_t pending_;      // 尚未提交的计数增减
+};
+
+namespace detail {
+
+// 线程独立的xorshift随机数，用于抽取淘汰候选分片
+inline uint32_t sampleRandom() {
+  static std::atomic<uint32_t> seed{0x9E3779B9u};
+  thread_local uint32_t state =
+      seed.fetch_add(0x9E3779B9u, std::memory_order_relaxed) | 1u;
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+} // namespace detail
+
+} // namespace CacheMgr
\ No newline at end of file
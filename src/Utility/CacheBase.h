@@ -1,9 +1,25 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <utility>
+
+#include "CacheLoader.h"
+#include "CacheStats.h"
+
 namespace CacheMgr {
 
 template <typename Key, typename Value> class CacheBase {
 public:
+  // 未命中时从后端加载缓存内容的函数，可以抛出异常
+  using Loader = std::function<Value(const Key &)>;
+  // 容量淘汰时接收被淘汰条目的回调，在缓存的锁内调用，缓存值以移动方式交出
+  using EvictionListener = std::function<void(const Key &, Value &&)>;
+
   virtual ~CacheBase() = default;
 
   /// @brief 添加缓存
@@ -21,6 +37,155 @@ public:
   /// @param key 待访问的缓存关键字
   /// @return 访问结果
   virtual Value get(const Key& key) = 0;
+
+  /// @brief 添加缓存，缓存内容以移动方式存入，默认实现退化为复制
+  /// @param key 关键字
+  /// @param val 缓存内容，调用后处于被移动状态
+  virtual void put(const Key& key, Value&& val) {
+    put(key, static_cast<const Value &>(val));
+  }
+
+  /// @brief 由构造参数构造缓存内容并添加缓存：先在调用方构造一个临时值，再经移动版put移入节点，
+  ///        不是在节点中就地构造，只省去调用方写出临时对象
+  /// @param key 关键字
+  /// @param args 缓存内容的构造参数
+  template <typename... Args> void emplace(const Key& key, Args&&... args) {
+    put(key, Value(std::forward<Args>(args)...));
+  }
+
+  /// @brief 访问缓存而不复制缓存内容，命中时在缓存内部的锁保护下调用visitor
+  /// @param key 待访问的缓存关键字
+  /// @param visitor 以常量引用读取缓存内容的回调，不能在其中再访问同一个缓存
+  /// @return 访问结果，命中返回true
+  virtual bool visit(const Key& key,
+                     const std::function<void(const Value &)> &visitor) {
+    Value val;
+    if (!get(key, val)) {
+      return false;
+    }
+    visitor(val);
+    return true;
+  }
+
+  /// @brief 访问缓存，未命中时调用loader加载并写入缓存；同一关键字上并发的未命中只加载一次，
+  ///        其余线程等待这次加载的结果
+  /// @param key 待访问的缓存关键字
+  /// @param loader 加载函数，抛出的异常会传给所有等待这次加载的线程
+  /// @return 缓存内容
+  virtual Value getOrLoad(const Key& key, const Loader &loader) {
+    Value val;
+    if (get(key, val)) {
+      return val;
+    }
+    std::promise<Value> promise;
+    std::shared_future<Value> pending;
+    if (!loads_.join(key, pending, promise)) {
+      return pending.get();
+    }
+    return loadAsLeader(key, loader, promise);
+  }
+
+  /// @brief getOrLoad的异步版本，未命中时在新线程中加载，同一关键字上并发的调用共享同一次加载
+  /// @param key 待访问的缓存关键字
+  /// @param loader 加载函数
+  /// @return 缓存内容的future，命中时已就绪；加载者持有的future析构时会等待加载结束
+  virtual std::shared_future<Value> getOrLoadAsync(const Key& key,
+                                                   Loader loader) {
+    Value val;
+    if (get(key, val)) {
+      std::promise<Value> ready;
+      ready.set_value(std::move(val));
+      return ready.get_future().share();
+    }
+    auto promise = std::make_shared<std::promise<Value>>();
+    std::shared_future<Value> pending;
+    if (!loads_.join(key, pending, *promise)) {
+      return pending;
+    }
+    return std::async(std::launch::async,
+                      [this, key, loader, promise] {
+                        return loadAsLeader(key, loader, *promise);
+                      })
+        .share();
+  }
+
+  /// @brief 运行统计快照，默认不统计
+  /// @return 命中、淘汰等计数器与锁等待、持有时间直方图
+  virtual CacheStats stats() const { return CacheStats(); }
+
+  /// @brief 批量添加缓存
+  /// @param keys 关键字数组
+  /// @param vals 缓存内容数组，与关键字一一对应
+  /// @param count 关键字数量
+  void putMany(const Key *keys, const Value *vals, size_t count) {
+    putBatch(keys, vals, nullptr, count);
+  }
+
+  /// @brief 批量访问缓存
+  /// @param keys 关键字数组
+  /// @param count 关键字数量
+  /// @param vals 传出参数，命中的缓存内容写入与关键字相同的下标
+  /// @param hits 传出参数，与关键字相同的下标记录是否命中
+  /// @return 命中数量
+  size_t getMany(const Key *keys, size_t count, Value *vals, bool *hits) {
+    return getBatch(keys, nullptr, count, vals, hits);
+  }
+
+  /// @brief 批量添加缓存的实现，默认逐个调用put，支持批量加锁的缓存应重写
+  /// @param order 待处理的下标数组，为空时依次处理keys[0, count)
+  /// @param count 待处理的关键字数量
+  virtual void putBatch(const Key *keys, const Value *vals,
+                        const uint32_t *order, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+      size_t idx = nullptr != order ? order[i] : i;
+      put(keys[idx], vals[idx]);
+    }
+  }
+
+  /// @brief 批量访问缓存的实现，默认逐个调用get，支持批量加锁的缓存应重写
+  /// @param order 待处理的下标数组，为空时依次处理keys[0, count)
+  /// @param count 待处理的关键字数量
+  /// @return 命中数量
+  virtual size_t getBatch(const Key *keys, const uint32_t *order, size_t count,
+                          Value *vals, bool *hits) {
+    size_t hitNum = 0;
+    for (size_t i = 0; i < count; ++i) {
+      size_t idx = nullptr != order ? order[i] : i;
+      hits[idx] = get(keys[idx], vals[idx]);
+      hitNum += hits[idx] ? 1 : 0;
+    }
+    return hitNum;
+  }
+
+private:
+  // 加载者执行加载：写入缓存后再删除登记，期间到达的线程都在等待同一个future
+  Value loadAsLeader(const Key& key, const Loader &loader,
+                     std::promise<Value> &promise) {
+    Value val;
+    try {
+      // 登记之前可能恰好有一次加载刚刚完成；调用方的查找已记过一次未命中，再次查找不计入统计
+      bool loaded;
+      {
+        UncountedLookup uncounted;
+        loaded = get(key, val);
+      }
+      if (!loaded) {
+        val = loader(key);
+        put(key, val);
+      }
+      promise.set_value(val);
+    } catch (...) {
+      promise.set_exception(std::current_exception());
+      loads_.finish(key);
+      throw;
+    }
+    loads_.finish(key);
+    return val;
+  }
+
+private:
+  // 进行中的加载
+  LoadTable<Key, Value> loads_;
 };
 
 } // namespace CacheMgr
\ No newline at end of file
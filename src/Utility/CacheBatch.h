@@ -0,0 +1,106 @@
+/*
+批量操作的公共工具：
+    1. groupByShard：先计算每个关键字所在的分片，再用计数排序把下标按分片分组，
+       分片缓存随后对每个分片只加一次锁
+    2. prefetchRead：软件预取，批量查找时提前若干个关键字发出内存访问，
+       让哈希桶与节点的缓存未命中相互重叠
+    3. prefetchLookup：按索引查找的引擎（LFU、LFU-Avg、ARC-Canonical）的批量预取，
+       索引支持prefetch（FlatMap）时提前2d个关键字预取探测组，提前d个关键字查到节点并预取；
+       std::unordered_map没有可预取的桶地址，提前查找只会让每个关键字查两次，此时不预取
+*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace CacheMgr {
+
+namespace detail {
+
+// 批量查找时预取的提前距离（关键字个数）
+constexpr size_t kPrefetchDistance = 4;
+
+// 预取只读数据到各级缓存，不支持的编译器上为空操作
+inline void prefetchRead(const void *addr) {
+#if defined(__GNUC__) || defined(__clang__)
+  __builtin_prefetch(addr, 0, 3);
+#else
+  (void)addr;
+#endif
+}
+
+// 批量操作的第i个关键字下标
+inline size_t batchIndex(const uint32_t *order, size_t i) {
+  return nullptr != order ? order[i] : i;
+}
+
+// 索引是否支持prefetch(key)
+template <typename Index, typename Key, typename = void>
+struct IndexPrefetchable : std::false_type {};
+
+template <typename Index, typename Key>
+struct IndexPrefetchable<
+    Index, Key,
+    std::void_t<decltype(std::declval<const Index &>().prefetch(std::declval<const Key &>()))>>
+    : std::true_type {};
+
+/// @brief 批量查找第i个关键字之前调用：预取第i+2d个关键字的探测组，
+///        以及第i+d个关键字（其探测组已在之前预取）的节点
+/// @param nodeOf 由索引中的值取得节点地址的函数
+template <typename Index, typename Key, typename NodeOf>
+void prefetchLookup(const Index &index, const Key *keys, const uint32_t *order,
+                    size_t count, size_t i, NodeOf &&nodeOf) {
+  if constexpr (IndexPrefetchable<Index, Key>::value) {
+    constexpr size_t distance = kPrefetchDistance;
+    if (0 == i) {
+      for (size_t ahead = 0; ahead < 2 * distance && ahead < count; ++ahead) {
+        index.prefetch(keys[batchIndex(order, ahead)]);
+      }
+    }
+    if (i + 2 * distance < count) {
+      index.prefetch(keys[batchIndex(order, i + 2 * distance)]);
+    }
+    if (i + distance < count) {
+      auto it = index.find(keys[batchIndex(order, i + distance)]);
+      if (it != index.end()) {
+        prefetchRead(nodeOf(it->second));
+      }
+    }
+  } else {
+    (void)index, (void)keys, (void)order, (void)count, (void)i, (void)nodeOf;
+  }
+}
+
+/// @brief 将批量操作的下标按分片分组
+/// @param order 待处理的下标数组，为空时依次处理[0, count)
+/// @param shardOf 由下标计算分片编号的函数
+/// @param grouped 传出参数，按分片排列的下标
+/// @param offsets 传出参数，第s个分片的下标位于grouped[offsets[s], offsets[s + 1])
+template <typename ShardOf>
+void groupByShard(const uint32_t *order, size_t count, size_t shardNum,
+                  ShardOf &&shardOf, std::vector<uint32_t> &grouped,
+                  std::vector<uint32_t> &offsets) {
+  std::vector<uint32_t> shardIds(count);
+  offsets.assign(shardNum + 1, 0);
+  for (size_t i = 0; i < count; ++i) {
+    uint32_t shard = static_cast<uint32_t>(shardOf(batchIndex(order, i)));
+    shardIds[i] = shard;
+    ++offsets[shard + 1];
+  }
+  for (size_t shard = 0; shard < shardNum; ++shard) {
+    offsets[shard + 1] += offsets[shard];
+  }
+  std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+  grouped.resize(count);
+  for (size_t i = 0; i < count; ++i) {
+    grouped[cursor[shardIds[i]]++] =
+        static_cast<uint32_t>(batchIndex(order, i));
+  }
+}
+
+} // namespace detail
+
+} // namespace CacheMgr
\ No newline at end of file
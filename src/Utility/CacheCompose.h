@@ -0,0 +1,551 @@
+/*
+Cache:
+编译期组合策略的缓存，淘汰策略、索引、锁、统计与可选功能都是模板参数，不经过虚函数：
+    1. 条目存放在下标寻址的槽位数组中，索引只保存关键字到槽位的映射，
+       淘汰策略（LRUPolicy、ClockPolicy）只维护槽位下标上的顺序信息
+    2. 锁策略有NoLock、MutexLock、SpinLock、SharedLock四种，单线程使用NoLock时加锁全部为空操作；
+       淘汰策略的命中处理可以在共享锁下进行（CLOCK只写原子访问位）且锁策略为SharedLock时，读路径只加共享锁
+    3. 统计策略为NoStats时计数全部为空操作；为StatsRecorder时与其他缓存相同，并对独占锁采样计时
+    4. 存活时间与按权重计容量由Features中的FeatureTtl、FeatureWeight开启，
+       未开启时槽位中不保存到期时间，也不调用weigher
+所有选择都在编译期确定，未使用的功能不占空间也不产生分支，热路径可以完整内联。
+需要CacheBase接口时（如基准测试）由外层适配器转发。
+*/
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "CacheFlatMap.h"
+#include "CacheStats.h"
+#include "CacheWeight.h"
+
+namespace CacheMgr {
+
+// 可选功能，按位组合后作为Cache的Features参数
+enum CacheFeature : unsigned {
+  FeatureTtl = 1u << 0,    // 条目存活时间
+  FeatureWeight = 1u << 1, // 按权重计容量
+};
+
+// 不加锁，供单线程使用
+struct NoLock {
+  static constexpr bool kEnabled = false;
+  static constexpr bool kSharedReads = false;
+
+  void lock() {}
+  void unlock() {}
+  void lock_shared() {}
+  void unlock_shared() {}
+};
+
+// 互斥锁，共享加锁退化为独占
+class MutexLock {
+public:
+  static constexpr bool kEnabled = true;
+  static constexpr bool kSharedReads = false;
+
+  void lock() { mutex_.lock(); }
+  void unlock() { mutex_.unlock(); }
+  void lock_shared() { mutex_.lock(); }
+  void unlock_shared() { mutex_.unlock(); }
+
+private:
+  std::mutex mutex_;
+};
+
+// 自旋锁，临界区很短且线程数不超过核数时比互斥锁少一次系统调用；等待过久时让出CPU
+class SpinLock {
+public:
+  static constexpr bool kEnabled = true;
+  static constexpr bool kSharedReads = false;
+
+  SpinLock() : flag_(false) {}
+
+  void lock() {
+    for (unsigned spins = 0; flag_.exchange(true, std::memory_order_acquire);) {
+      while (flag_.load(std::memory_order_relaxed)) {
+        if (++spins > 64) {
+          std::this_thread::yield();
+        }
+      }
+    }
+  }
+  void unlock() { flag_.store(false, std::memory_order_release); }
+  void lock_shared() { lock(); }
+  void unlock_shared() { unlock(); }
+
+private:
+  std::atomic<bool> flag_;
+};
+
+// 读写锁，淘汰策略允许时命中只加共享锁
+class SharedLock {
+public:
+  static constexpr bool kEnabled = true;
+  static constexpr bool kSharedReads = true;
+
+  void lock() { mutex_.lock(); }
+  void unlock() { mutex_.unlock(); }
+  void lock_shared() { mutex_.lock_shared(); }
+  void unlock_shared() { mutex_.unlock_shared(); }
+
+private:
+  std::shared_mutex mutex_;
+};
+
+// 不统计，接口与StatsRecorder相同
+struct NoStats {
+  void add(StatsRecorder::Counter, uint64_t = 1) {}
+  void recordLock(uint64_t, uint64_t) {}
+  CacheStats snapshot() const { return CacheStats(); }
+};
+
+// LRU淘汰顺序：槽位下标串成的双向链表，头部最近访问，尾部被淘汰
+class LRUPolicy {
+public:
+  // 命中需要调整链表，不能在共享锁下进行
+  static constexpr bool kSharedHit = false;
+
+  LRUPolicy() : head_(kNil), tail_(kNil) {}
+
+  // 槽位总数增长到slotNum
+  void grow(size_t slotNum) { links_.resize(slotNum); }
+
+  void onInsert(uint32_t slot) { pushFront(slot); }
+
+  void onHit(uint32_t slot) {
+    if (head_ != slot) {
+      unlink(slot);
+      pushFront(slot);
+    }
+  }
+
+  void onErase(uint32_t slot) { unlink(slot); }
+
+  // 下一个被淘汰的槽位，调用方保证至少有一个条目
+  uint32_t victim() const { return tail_; }
+
+  void clear() { head_ = tail_ = kNil; }
+
+private:
+  static constexpr uint32_t kNil = UINT32_MAX;
+
+  struct Link {
+    uint32_t prev; // 更近访问的槽位
+    uint32_t next; // 更久未访问的槽位
+  };
+
+  void pushFront(uint32_t slot) {
+    links_[slot].prev = kNil;
+    links_[slot].next = head_;
+    if (kNil != head_) {
+      links_[head_].prev = slot;
+    } else {
+      tail_ = slot;
+    }
+    head_ = slot;
+  }
+
+  void unlink(uint32_t slot) {
+    Link &link = links_[slot];
+    (kNil != link.prev ? links_[link.prev].next : head_) = link.next;
+    (kNil != link.next ? links_[link.next].prev : tail_) = link.prev;
+  }
+
+private:
+  uint32_t head_;          // 最近访问的槽位
+  uint32_t tail_;          // 最久未访问的槽位
+  std::vector<Link> links_; // 各槽位的链表指针
+};
+
+// CLOCK淘汰顺序：命中只置访问位，淘汰时指针沿槽位数组转动，访问位为1的清零跳过
+class ClockPolicy {
+public:
+  // 命中只做relaxed原子写，可以在共享锁下进行
+  static constexpr bool kSharedHit = true;
+
+  ClockPolicy() : slotNum_(0), hand_(0) {}
+
+  // 槽位总数增长到slotNum，在独占锁内调用，此时没有并发的命中
+  void grow(size_t slotNum) {
+    std::unique_ptr<std::atomic<uint8_t>[]> refBits(new std::atomic<uint8_t>[slotNum]);
+    for (size_t idx = 0; idx < slotNum; ++idx) {
+      refBits[idx].store(idx < slotNum_ ? refBits_[idx].load(std::memory_order_relaxed) : 0,
+                         std::memory_order_relaxed);
+    }
+    refBits_ = std::move(refBits);
+    live_.resize(slotNum, 0);
+    slotNum_ = slotNum;
+  }
+
+  // 新条目的访问位为0，需要指针转完一圈才会再被检查
+  void onInsert(uint32_t slot) {
+    live_[slot] = 1;
+    refBits_[slot].store(0, std::memory_order_relaxed);
+  }
+
+  void onHit(uint32_t slot) const {
+    if (0 == refBits_[slot].load(std::memory_order_relaxed)) {
+      refBits_[slot].store(1, std::memory_order_relaxed);
+    }
+  }
+
+  void onErase(uint32_t slot) { live_[slot] = 0; }
+
+  // 转动时钟指针找到访问位为0的条目，调用方保证至少有一个条目
+  uint32_t victim() {
+    while (true) {
+      uint32_t slot = static_cast<uint32_t>(hand_);
+      hand_ = hand_ + 1 == slotNum_ ? 0 : hand_ + 1;
+      if (0 == live_[slot]) {
+        continue;
+      }
+      if (0 != refBits_[slot].load(std::memory_order_relaxed)) {
+        refBits_[slot].store(0, std::memory_order_relaxed); // 第二次机会
+        continue;
+      }
+      return slot;
+    }
+  }
+
+  void clear() {
+    std::fill(live_.begin(), live_.end(), 0);
+    hand_ = 0;
+  }
+
+private:
+  size_t slotNum_;                                  // 槽位总数
+  size_t hand_;                                     // 时钟指针
+  std::unique_ptr<std::atomic<uint8_t>[]> refBits_; // 访问位
+  std::vector<uint8_t> live_;                       // 槽位上是否有条目
+};
+
+namespace detail {
+
+// 槽位中的到期时间，未开启存活时间时为空基类，不占空间
+template <bool Enabled> struct EntryDeadline {
+  void setDeadline(uint64_t) {}
+  bool expired(uint64_t) const { return false; }
+};
+
+template <> struct EntryDeadline<true> {
+  void setDeadline(uint64_t at) { deadline = at; }
+  bool expired(uint64_t now) const { return deadline <= now; }
+
+  uint64_t deadline = UINT64_MAX; // 到期的毫秒刻度
+};
+
+// 未开启按权重计容量时的占位
+template <typename Key, typename Value> struct NoWeightBudget {};
+
+// 不计时的独占锁守卫
+template <typename Lock, typename Stats> class LockGuard {
+public:
+  LockGuard(Lock &lock, Stats &) : lock_(lock) { lock_.lock(); }
+  ~LockGuard() { lock_.unlock(); }
+
+  LockGuard(const LockGuard &) = delete;
+  LockGuard &operator=(const LockGuard &) = delete;
+
+private:
+  Lock &lock_;
+};
+
+// 独占锁守卫：统计开启且锁不为空时采样计时
+template <typename Lock, typename Stats>
+using ExclusiveGuard =
+    std::conditional_t<Lock::kEnabled && !std::is_same<Stats, NoStats>::value,
+                       TimedLockGuard<Lock>, LockGuard<Lock, Stats>>;
+
+} // namespace detail
+
+template <typename Key, typename Value, typename Policy = LRUPolicy,
+          template <typename, typename> class Index = CacheIndexMap,
+          typename Lock = MutexLock, typename Stats = StatsRecorder,
+          unsigned Features = 0>
+class Cache {
+public:
+  static constexpr bool kTtl = 0 != (Features & FeatureTtl);
+  static constexpr bool kWeighted = 0 != (Features & FeatureWeight);
+
+  /// @param capacity 容量，按条目数计
+  explicit Cache(size_t capacity) : capacity_(capacity), policySlots_(0) {
+    static_assert(!kWeighted, "weighted caches take a weigher");
+    entries_.reserve(capacity_);
+    growPolicy();
+    index_.reserve(capacity_);
+  }
+
+  /// @param maxWeight 权重预算
+  /// @param weigher 条目的权重函数
+  Cache(size_t maxWeight, CacheWeigher<Key, Value> weigher)
+      : capacity_(maxWeight), policySlots_(0) {
+    static_assert(kWeighted, "enable FeatureWeight to use a weigher");
+    budget_ = WeightBudget<Key, Value>(maxWeight, std::move(weigher));
+  }
+
+  Cache(const Cache &) = delete;
+  Cache &operator=(const Cache &) = delete;
+
+  /// @brief 添加缓存
+  void put(const Key &key, const Value &val) { putImpl(key, val, UINT64_MAX); }
+
+  void put(const Key &key, Value &&val) {
+    putImpl(key, std::move(val), UINT64_MAX);
+  }
+
+  /// @brief 添加缓存并设置存活时间，需开启FeatureTtl
+  void put(const Key &key, const Value &val, std::chrono::milliseconds ttl) {
+    static_assert(kTtl, "enable FeatureTtl to set a time to live");
+    putImpl(key, val, deadlineOf(ttl));
+  }
+
+  void put(const Key &key, Value &&val, std::chrono::milliseconds ttl) {
+    static_assert(kTtl, "enable FeatureTtl to set a time to live");
+    putImpl(key, std::move(val), deadlineOf(ttl));
+  }
+
+  /// @brief 访问缓存
+  /// @return 命中返回true，缓存内容复制到val
+  bool get(const Key &key, Value &val) {
+    return access(key, [&val](const Value &cached) { val = cached; });
+  }
+
+  Value get(const Key &key) {
+    Value val{};
+    get(key, val);
+    return val;
+  }
+
+  /// @brief 访问缓存而不复制，命中时在锁内调用visitor
+  template <typename F> bool visit(const Key &key, F &&visitor) {
+    return access(key, std::forward<F>(visitor));
+  }
+
+  // 删除指定缓存
+  void remove(const Key &key) {
+    detail::ExclusiveGuard<Lock, Stats> lock(lock_, stats_);
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+      release(it->second);
+    }
+  }
+
+  // 清空缓存
+  void purge() {
+    detail::ExclusiveGuard<Lock, Stats> lock(lock_, stats_);
+    index_.clear();
+    entries_.clear();
+    freeSlots_.clear();
+    policy_.clear();
+    if constexpr (kWeighted) {
+      budget_.clear();
+    }
+  }
+
+  size_t size() {
+    std::shared_lock<Lock> lock(lock_);
+    return index_.size();
+  }
+
+  // 容量，按权重计容量时为权重预算
+  size_t capacity() const { return capacity_; }
+
+  CacheStats stats() const { return stats_.snapshot(); }
+
+private:
+  // 命中处理可以在共享锁下进行时，读路径只加共享锁
+  static constexpr bool kSharedRead = Policy::kSharedHit && Lock::kSharedReads;
+
+  struct Entry : detail::EntryDeadline<kTtl> {
+    template <typename V>
+    Entry(const Key &k, V &&v) : key(k), val(std::forward<V>(v)) {}
+
+    Key key;   // 关键字
+    Value val; // 缓存值
+  };
+
+  static uint64_t now() {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+  }
+
+  static uint64_t deadlineOf(std::chrono::milliseconds ttl) {
+    return now() + static_cast<uint64_t>(ttl.count() > 0 ? ttl.count() : 0);
+  }
+
+  template <typename F> bool access(const Key &key, F &&onHit) {
+    using ReadGuard = std::conditional_t<kSharedRead, std::shared_lock<Lock>,
+                                         detail::ExclusiveGuard<Lock, Stats>>;
+    ReadGuard lock = makeReadGuard<ReadGuard>();
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+      stats_.add(StatsRecorder::Miss);
+      return false;
+    }
+    uint32_t slot = it->second;
+    if constexpr (kTtl) {
+      if (entries_[slot].expired(now())) {
+        // 共享锁下不能删除，到期条目不再被置访问位，由淘汰回收
+        if constexpr (!kSharedRead) {
+          release(slot);
+          stats_.add(StatsRecorder::Expiration);
+        }
+        stats_.add(StatsRecorder::Miss);
+        return false;
+      }
+    }
+    policy_.onHit(slot);
+    stats_.add(StatsRecorder::Hit);
+    onHit(static_cast<const Value &>(entries_[slot].val));
+    return true;
+  }
+
+  template <typename Guard> Guard makeReadGuard() {
+    if constexpr (kSharedRead) {
+      return Guard(lock_);
+    } else {
+      return Guard(lock_, stats_);
+    }
+  }
+
+  template <typename V> void putImpl(const Key &key, V &&val, uint64_t deadline) {
+    if (!kWeighted && 0 == capacity_) {
+      return;
+    }
+    detail::ExclusiveGuard<Lock, Stats> lock(lock_, stats_);
+    stats_.add(StatsRecorder::Put);
+    size_t weight = 0;
+    if constexpr (kWeighted) {
+      weight = budget_.weigh(key, val);
+      if (!budget_.admits(weight)) {
+        // 超过整个预算的条目不写入，已有的同名条目一并删除
+        auto it = index_.find(key);
+        if (it != index_.end()) {
+          release(it->second);
+        }
+        return;
+      }
+    }
+    auto it = index_.find(key);
+    uint32_t slot;
+    if (it != index_.end()) {
+      // 已在缓存中，更新值并视为一次访问
+      slot = it->second;
+      Entry &entry = entries_[slot];
+      if constexpr (kWeighted) {
+        budget_.sub(budget_.weigh(entry.key, entry.val));
+      }
+      entry.val = std::forward<V>(val);
+      entry.setDeadline(deadline);
+      policy_.onHit(slot);
+    } else {
+      if (!kWeighted && index_.size() >= capacity_) {
+        slot = evict(); // 直接复用被淘汰的槽位
+        entries_[slot].key = key;
+        entries_[slot].val = std::forward<V>(val);
+      } else {
+        slot = allocate(key, std::forward<V>(val));
+      }
+      entries_[slot].setDeadline(deadline);
+      index_[key] = slot;
+      policy_.onInsert(slot);
+    }
+    if constexpr (kWeighted) {
+      budget_.add(weight);
+      while (budget_.over()) {
+        freeSlots_.push_back(evictOther(slot));
+        entries_[freeSlots_.back()].val = Value{};
+      }
+    }
+  }
+
+  // 取得一个空槽位并写入条目
+  template <typename V> uint32_t allocate(const Key &key, V &&val) {
+    if (!freeSlots_.empty()) {
+      uint32_t slot = freeSlots_.back();
+      freeSlots_.pop_back();
+      entries_[slot].key = key;
+      entries_[slot].val = std::forward<V>(val);
+      return slot;
+    }
+    entries_.emplace_back(key, std::forward<V>(val));
+    growPolicy();
+    return static_cast<uint32_t>(entries_.size() - 1);
+  }
+
+  // 淘汰策略的槽位数跟随槽位数组的容量增长，按容量计的缓存只在构造时增长一次
+  void growPolicy() {
+    if (entries_.capacity() != policySlots_) {
+      policySlots_ = entries_.capacity();
+      policy_.grow(policySlots_);
+    }
+  }
+
+  // 按淘汰策略摘除一个条目，返回空出的槽位，槽位中的旧值由调用方覆盖或清空
+  uint32_t evict() {
+    uint32_t slot = policy_.victim();
+    unlink(slot);
+    stats_.add(StatsRecorder::Eviction);
+    return slot;
+  }
+
+  // 淘汰kept以外的一个条目：CLOCK中新写入条目的访问位为0，可能恰好被时钟指针选中；
+  // 选中时按命中处理后重新选择。预算只在kept之外还有条目时才会超出，总能选到其他条目
+  uint32_t evictOther(uint32_t kept) {
+    uint32_t slot = policy_.victim();
+    while (slot == kept) {
+      policy_.onHit(kept);
+      slot = policy_.victim();
+    }
+    unlink(slot);
+    stats_.add(StatsRecorder::Eviction);
+    return slot;
+  }
+
+  // 从索引与淘汰顺序中摘除槽位上的条目
+  void unlink(uint32_t slot) {
+    Entry &entry = entries_[slot];
+    policy_.onErase(slot);
+    if constexpr (kWeighted) {
+      budget_.sub(budget_.weigh(entry.key, entry.val));
+    }
+    index_.erase(entry.key);
+  }
+
+  // 删除槽位上的条目并归还槽位
+  void release(uint32_t slot) {
+    unlink(slot);
+    entries_[slot].val = Value{};
+    freeSlots_.push_back(slot);
+  }
+
+private:
+  size_t capacity_;                // 容量或权重预算
+  Lock lock_;                      // 锁策略
+  Index<Key, uint32_t> index_;     // 关键字到槽位的索引
+  std::vector<Entry> entries_;     // 槽位数组
+  std::vector<uint32_t> freeSlots_; // 删除后空出的槽位
+  size_t policySlots_;             // 淘汰策略已分配的槽位数
+  Policy policy_;                  // 淘汰策略
+  std::conditional_t<kWeighted, WeightBudget<Key, Value>,
+                     detail::NoWeightBudget<Key, Value>>
+      budget_;                     // 权重预算
+  Stats stats_;                    // 统计策略
+};
+
+} // namespace CacheMgr
\ No newline at end of file
@@ -0,0 +1,512 @@
+/*
+ElasticSlices:
+可在线调整总容量与分片数的分片组，供LRUHashCache、LFUHashCache使用：
+    1. 每个分片前有一个入口闸门，操作进入分片时计数加一、离开时减一；
+       迁出分片时先关闭闸门并等待已进入的操作离开，之后到达的操作等分片迁出完成后转到新的分片表
+    2. resize只调整各分片的容量上限，扩容立即生效；缩容时由后台线程逐个分片分批淘汰，
+       每批只持有一次分片锁，不在一次调用里把全部超出的条目淘汰完
+    3. reshard新建一张分片表，后台线程一次迁移一个旧分片：移出其中全部条目（带频次与到期时间），
+       按新的分片规则批量写入新表，再释放旧分片；其余分片照常读写，未迁移的关键字仍在旧分片上
+    4. 迁移完成后新表成为当前表；已迁出的旧表只剩闸门，保留到析构，
+       让仍持有旧表指针的操作能沿着链接找到新表
+    5. 开启全局淘汰后各分片共用总容量（GlobalBudget），写入后超出总容量时抽样几个分片，
+       在最冷的分片上淘汰；缩容与快照恢复超出的部分同样由后台线程分批跨分片淘汰
+    6. 关键字按CacheHash的高32位乘以分片数取高32位选分片（sliceIndex），分片数任意，
+       为2的幂时即取哈希的最高几位，与ShardedCache的分片规则一致
+分片需支持resize、trim、drain与restore，开启全局淘汰时还需支持shareBudget、coldness与evictColdest，
+如LRUCache、LFUAvgCache。
+操作在分片内阻塞（如getOrLoad等待加载）时，迁移会等到它离开；加载函数不应再访问同一个缓存。
+*/
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "CacheBalance.h"
+#include "CacheBatch.h"
+#include "CacheHash.h"
+#include "CacheSnapshot.h"
+#include "CacheStats.h"
+
+namespace CacheMgr {
+
+// 分片的入口闸门
+class SliceGate {
+public:
+  // 进入分片，闸门已关闭时返回false
+  bool enter() {
+    if (0 != (state_.fetch_add(1, std::memory_order_acquire) & kClosed)) {
+      leave();
+      return false;
+    }
+    return true;
+  }
+
+  void leave() { state_.fetch_sub(1, std::memory_order_release); }
+
+  // 关闭闸门并等待已进入的操作全部离开
+  void close() {
+    state_.fetch_or(kClosed, std::memory_order_acq_rel);
+    while (kClosed != state_.load(std::memory_order_acquire)) {
+      std::this_thread::yield();
+    }
+  }
+
+  // 分片已迁出，被挡在闸门外的操作可以转到新的分片表
+  void retire() { retired_.store(true, std::memory_order_release); }
+
+  void waitRetired() const {
+    while (!retired_.load(std::memory_order_acquire)) {
+      std::this_thread::yield();
+    }
+  }
+
+private:
+  static constexpr uint32_t kClosed = 1u << 31;
+
+  std::atomic<uint32_t> state_{0};    // 最高位为关闭标记，其余为分片内的操作数
+  std::atomic<bool> retired_{false}; // 是否已迁出
+};
+
+template <typename Key, typename Value, typename Slice,
+          typename Hash = CacheHash<Key>>
+class ElasticSlices {
+public:
+  // 按分片容量构造一个分片
+  using Factory = std::function<std::unique_ptr<Slice>(size_t)>;
+
+  /// @param capacity 总容量（按权重计容量时为总权重预算），按分片数均分
+  /// @param sliceNum 分片数
+  ElasticSlices(size_t capacity, size_t sliceNum, Factory factory)
+      : capacity_(capacity), targetSliceNum_(std::max<size_t>(1, sliceNum)),
+        factory_(std::move(factory)), target_(nullptr), cursor_(0),
+        samples_(0), running_(false), stop_(false) {
+    tables_.push_back(makeTable(targetSliceNum_));
+    current_.store(tables_.back().get(), std::memory_order_release);
+  }
+
+  ElasticSlices(const ElasticSlices &) = delete;
+  ElasticSlices &operator=(const ElasticSlices &) = delete;
+
+  ~ElasticSlices() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    if (worker_.joinable()) {
+      worker_.join();
+    }
+  }
+
+  // 在关键字所在的分片上执行f(slice)
+  template <typename F>
+  auto apply(const Key &key, F &&f) -> decltype(f(std::declval<Slice &>())) {
+    return applyHashed(Hash{}(key), std::forward<F>(f));
+  }
+
+  /// @brief 批量操作，按当前分片表分组后每个分片调用一次f(slice, order, count)；
+  ///        分片正在迁出时该组逐个关键字转到新表
+  template <typename F>
+  void applyBatch(const Key *keys, size_t count, F &&f) {
+    SliceTable *table = current_.load(std::memory_order_acquire);
+    std::vector<uint32_t> grouped;
+    std::vector<uint32_t> offsets;
+    detail::groupByShard(
+        nullptr, count, table->size,
+        [table, keys](size_t idx) { return sliceIndex(Hash{}(keys[idx]), table->size); },
+        grouped, offsets);
+    for (size_t idx = 0; idx < table->size; ++idx) {
+      if (offsets[idx] == offsets[idx + 1]) {
+        continue;
+      }
+      const uint32_t *order = grouped.data() + offsets[idx];
+      size_t num = offsets[idx + 1] - offsets[idx];
+      SliceEntry &entry = table->entries[idx];
+      if (entry.gate.enter()) {
+        GateGuard guard(entry.gate);
+        f(*entry.slice, order, num);
+        continue;
+      }
+      for (size_t i = 0; i < num; ++i) {
+        applyHashed(Hash{}(keys[order[i]]), [&f, order, i](Slice &slice) {
+          f(slice, order + i, 1);
+        });
+      }
+    }
+  }
+
+  // 对每个分片调用f(slice)，期间暂停迁移与缩容
+  template <typename F> void forEach(F &&f) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    forEachLocked(f);
+  }
+
+  /// @brief 以全部分片的列表调用f，期间暂停迁移与缩容，用于需要固定分片集合的操作，如写快照
+  /// @return f的返回值
+  template <typename F>
+  auto withSlices(F &&f) const
+      -> decltype(f(std::declval<const std::vector<Slice *> &>())) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<Slice *> slices;
+    forEachLocked([&slices](Slice &slice) { slices.push_back(&slice); });
+    return f(static_cast<const std::vector<Slice *> &>(slices));
+  }
+
+  // 为现有与之后新建的分片执行同一项设置，如设置淘汰回调
+  void configure(std::function<void(Slice &)> setup) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    forEachLocked(setup);
+    setup_ = std::move(setup);
+  }
+
+  /// @brief 各分片共用总容量，超出后抽样samples个分片并在最冷的分片上淘汰，
+  ///        需在并发访问开始之前调用
+  void enableGlobalEviction(size_t samples) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    global_.reset(new GlobalBudget(
+        capacity_, current_.load(std::memory_order_relaxed)->size));
+    samples_ = std::max<size_t>(1, samples);
+    // 只在开启时实例化，不支持全局淘汰的分片类型仍可用于其他功能
+    attachGlobal_ = [this](Slice &slice) {
+      slice.resize(capacity_);
+      slice.shareBudget(global_.get());
+    };
+    evictGlobal_ = [this] { return evictSampled(); };
+    forEachLocked(attachGlobal_);
+    if (global_->over()) {
+      startWorker();
+    }
+  }
+
+  // 开启全局淘汰时，超出总容量则跨分片淘汰，至多淘汰maxEvictions个
+  void rebalance(size_t maxEvictions = kRebalanceBatch) {
+    if (nullptr == global_) {
+      return;
+    }
+    for (size_t num = 0; num < maxEvictions && global_->over(); ++num) {
+      if (!evictGlobal_()) {
+        break;
+      }
+    }
+  }
+
+  /// @brief 按当前的分片规则把条目分组，每个分片一次批量写入，期间暂停迁移
+  void restore(SnapshotShard<Key, Value> entries) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    SliceTable *table = current_.load(std::memory_order_relaxed);
+    size_t targetSize = nullptr != target_ ? target_->size : 0;
+    // 下标先排当前表的分片，迁移期间再排目标表的分片
+    std::vector<SnapshotShard<Key, Value>> grouped(table->size + targetSize);
+    for (auto &entry : entries) {
+      size_t hash = Hash{}(entry.key);
+      size_t idx = sliceIndex(hash, table->size);
+      if (!table->entries[idx].slice) {
+        idx = table->size + sliceIndex(hash, targetSize); // 所在的旧分片已迁出
+      }
+      grouped[idx].push_back(std::move(entry));
+    }
+    for (size_t idx = 0; idx < grouped.size(); ++idx) {
+      if (grouped[idx].empty()) {
+        continue;
+      }
+      Slice &slice = idx < table->size
+                         ? *table->entries[idx].slice
+                         : *target_->entries[idx - table->size].slice;
+      slice.restore(std::move(grouped[idx]));
+    }
+    if (nullptr != global_ && global_->over()) {
+      startWorker(); // 超出总容量的部分由后台线程跨分片淘汰
+    }
+  }
+
+  /// @brief 调整总容量，扩容立即生效，缩容由后台线程分批淘汰
+  void resize(size_t capacity) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    capacity_ = capacity;
+    SliceTable *table = current_.load(std::memory_order_relaxed);
+    if (nullptr != global_) {
+      global_->setCapacity(capacity_, table->size);
+    }
+    for (size_t idx = 0; idx < table->size; ++idx) {
+      if (table->entries[idx].slice) {
+        table->entries[idx].slice->resize(sliceLimit(table->size));
+      }
+    }
+    if (nullptr != target_) {
+      for (size_t idx = 0; idx < target_->size; ++idx) {
+        target_->entries[idx].slice->resize(sliceLimit(target_->size));
+      }
+    }
+    startWorker();
+  }
+
+  /// @brief 调整分片数，由后台线程逐个迁移旧分片
+  void reshard(size_t sliceNum) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    targetSliceNum_ = std::max<size_t>(1, sliceNum);
+    startWorker();
+  }
+
+  // 等待进行中的缩容与迁移完成
+  void waitSettled() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    settled_.wait(lock, [this] { return !running_; });
+  }
+
+  // 缩容与迁移是否都已完成
+  bool settled() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return !running_;
+  }
+
+  // 当前分片表的分片数，迁移期间为旧表的分片数
+  size_t sliceCount() const {
+    return current_.load(std::memory_order_acquire)->size;
+  }
+
+  // 目标分片数
+  size_t targetSliceCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return targetSliceNum_;
+  }
+
+  size_t capacity() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return capacity_;
+  }
+
+  // 已迁出并释放的分片的统计之和
+  CacheStats retiredStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return retiredStats_;
+  }
+
+private:
+  // 每批淘汰的条目数，一批只持有一次分片锁
+  static constexpr size_t kTrimBatch = 64;
+  // 每次写入后至多跨分片淘汰的条目数，分片攒批提交的计数由之后的写入继续淘汰
+  static constexpr size_t kRebalanceBatch = 8;
+
+  struct alignas(64) SliceEntry {
+    SliceGate gate;              // 入口闸门
+    std::unique_ptr<Slice> slice; // 分片，迁出后为空
+  };
+
+  struct SliceTable {
+    explicit SliceTable(size_t num) : size(num), entries(new SliceEntry[num]) {}
+
+    size_t size;                              // 分片数
+    std::unique_ptr<SliceEntry[]> entries;    // 分片
+    std::atomic<SliceTable *> next{nullptr}; // 迁移的目标表
+  };
+
+  class GateGuard {
+  public:
+    explicit GateGuard(SliceGate &gate) : gate_(gate) {}
+    ~GateGuard() { gate_.leave(); }
+
+  private:
+    SliceGate &gate_;
+  };
+
+  // 哈希值到分片下标：取哈希的高32位按分片数等比缩放，不用取模，分片数不必是2的幂
+  static size_t sliceIndex(size_t hash, size_t sliceNum) {
+    return static_cast<size_t>(((static_cast<uint64_t>(hash) >> 32) * sliceNum) >> 32);
+  }
+
+  template <typename F>
+  auto applyHashed(size_t hash, F &&f) -> decltype(f(std::declval<Slice &>())) {
+    SliceTable *table = current_.load(std::memory_order_acquire);
+    for (;;) {
+      SliceEntry &entry = table->entries[sliceIndex(hash, table->size)];
+      if (entry.gate.enter()) {
+        GateGuard guard(entry.gate);
+        return f(*entry.slice);
+      }
+      entry.gate.waitRetired();
+      table = table->next.load(std::memory_order_acquire);
+    }
+  }
+
+  size_t sliceCapacity(size_t sliceNum) const {
+    return (capacity_ + sliceNum - 1) / sliceNum;
+  }
+
+  // 分片的容量上限，开启全局淘汰时放宽到总容量
+  size_t sliceLimit(size_t sliceNum) const {
+    return nullptr != global_ ? capacity_ : sliceCapacity(sliceNum);
+  }
+
+  /// @brief 从当前表随机抽取samples_个分片比较冷度，在最冷的分片上淘汰一个条目；
+  ///        抽到正在迁出的分片时改从目标表抽取，抽到的分片正被持有时跳过
+  /// @return 淘汰成功返回true
+  bool evictSampled() {
+    SliceTable *table = current_.load(std::memory_order_acquire);
+    SliceEntry *victim = nullptr;
+    uint64_t coldest = UINT64_MAX;
+    for (size_t num = 0; num < samples_; ++num) {
+      SliceEntry *entry = &table->entries[detail::sampleRandom() % table->size];
+      if (!entry->gate.enter()) {
+        SliceTable *next = table->next.load(std::memory_order_acquire);
+        if (nullptr == next) {
+          continue;
+        }
+        entry = &next->entries[detail::sampleRandom() % next->size];
+        if (!entry->gate.enter()) {
+          continue;
+        }
+      }
+      GateGuard guard(entry->gate);
+      uint64_t score = 0;
+      if (entry->slice->coldness(score) && score < coldest) {
+        coldest = score;
+        victim = entry;
+      }
+    }
+    if (nullptr == victim || !victim->gate.enter()) {
+      return false;
+    }
+    GateGuard guard(victim->gate);
+    return victim->slice->evictColdest();
+  }
+
+  std::unique_ptr<SliceTable> makeTable(size_t sliceNum) {
+    std::unique_ptr<SliceTable> table(new SliceTable(sliceNum));
+    for (size_t idx = 0; idx < sliceNum; ++idx) {
+      table->entries[idx].slice = factory_(sliceCapacity(sliceNum));
+      if (setup_) {
+        setup_(*table->entries[idx].slice);
+      }
+      if (attachGlobal_) {
+        // 分片按均分的容量构造，接入全局预算时再放宽上限
+        attachGlobal_(*table->entries[idx].slice);
+      }
+    }
+    return table;
+  }
+
+  template <typename F> void forEachLocked(F &&f) const {
+    SliceTable *table = current_.load(std::memory_order_relaxed);
+    for (size_t idx = 0; idx < table->size; ++idx) {
+      if (table->entries[idx].slice) {
+        f(*table->entries[idx].slice);
+      }
+    }
+    if (nullptr != target_) {
+      for (size_t idx = 0; idx < target_->size; ++idx) {
+        f(*target_->entries[idx].slice);
+      }
+    }
+  }
+
+  // 持有mutex_时调用，后台线程未运行时启动
+  void startWorker() {
+    if (running_) {
+      return;
+    }
+    if (worker_.joinable()) {
+      worker_.join(); // 上一次的线程已经退出
+    }
+    running_ = true;
+    worker_ = std::thread(&ElasticSlices::run, this);
+  }
+
+  void run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_) {
+      SliceTable *table = current_.load(std::memory_order_relaxed);
+      if (nullptr != target_) {
+        migrateOne(table);
+      } else if (table->size != targetSliceNum_) {
+        beginMigration(table);
+      } else if (nullptr != global_) {
+        size_t evicted = 0;
+        size_t failed = 0;
+        while (evicted < kTrimBatch && global_->over() && failed < kTrimBatch) {
+          evictGlobal_() ? ++evicted : ++failed;
+        }
+        if (!global_->over() || 0 == evicted) {
+          break; // 已回到总容量以内，或抽到的分片都已为空
+        }
+      } else {
+        size_t left = 0;
+        for (size_t idx = 0; idx < table->size; ++idx) {
+          left += table->entries[idx].slice->trim(kTrimBatch);
+        }
+        if (0 == left) {
+          break;
+        }
+      }
+      // 每一步之间释放锁，让读写与统计不被整个过程阻塞
+      lock.unlock();
+      std::this_thread::yield();
+      lock.lock();
+    }
+    running_ = false;
+    settled_.notify_all();
+  }
+
+  void beginMigration(SliceTable *table) {
+    tables_.push_back(makeTable(targetSliceNum_));
+    target_ = tables_.back().get();
+    cursor_ = 0;
+    table->next.store(target_, std::memory_order_release);
+  }
+
+  // 迁移旧表中的下一个分片，最后一个迁完后切换当前表
+  void migrateOne(SliceTable *table) {
+    SliceEntry &entry = table->entries[cursor_];
+    entry.gate.close();
+    SnapshotShard<Key, Value> entries = entry.slice->drain();
+    std::vector<SnapshotShard<Key, Value>> grouped(target_->size);
+    for (auto &item : entries) {
+      grouped[sliceIndex(Hash{}(item.key), target_->size)].push_back(std::move(item));
+    }
+    for (size_t idx = 0; idx < target_->size; ++idx) {
+      if (!grouped[idx].empty()) {
+        target_->entries[idx].slice->restore(std::move(grouped[idx]));
+      }
+    }
+    retiredStats_ += entry.slice->stats();
+    entry.slice.reset();
+    entry.gate.retire();
+    if (++cursor_ == table->size) {
+      current_.store(target_, std::memory_order_release);
+      if (nullptr != global_) {
+        global_->setCapacity(capacity_, target_->size);
+      }
+      target_ = nullptr;
+    }
+  }
+
+private:
+  size_t capacity_;                 // 总容量
+  size_t targetSliceNum_;           // 目标分片数
+  Factory factory_;                 // 分片工厂
+  std::function<void(Slice &)> setup_; // 新建分片后的设置
+  std::atomic<SliceTable *> current_; // 当前分片表，操作从这里开始查找
+  std::vector<std::unique_ptr<SliceTable>> tables_; // 用过的全部分片表
+  SliceTable *target_;              // 迁移中的目标表，未迁移时为空
+  size_t cursor_;                   // 下一个待迁移的旧分片
+  CacheStats retiredStats_;         // 已释放分片的统计之和
+  std::unique_ptr<GlobalBudget> global_; // 全局容量预算，未开启全局淘汰时为空
+  size_t samples_;                  // 跨分片淘汰时抽样的分片数
+  std::function<void(Slice &)> attachGlobal_; // 分片接入全局预算
+  std::function<bool()> evictGlobal_;         // 抽样跨分片淘汰一个条目
+  mutable std::mutex mutex_;        // 保护以上状态，与后台线程的每一步互斥
+  std::condition_variable settled_; // 后台线程退出时通知
+  bool running_;                    // 后台线程是否在运行
+  bool stop_;                       // 析构时通知后台线程退出
+  std::thread worker_;              // 缩容与迁移的后台线程
+};
+
+} // namespace CacheMgr
\ No newline at end of file
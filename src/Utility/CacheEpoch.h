@@ -0,0 +1,204 @@
+/*
+EpochDomain:
+基于纪元的内存回收（epoch-based reclamation），供无锁读取的并发缓存释放被删除的节点：
+    1. 全局纪元单调递增；读线程进入临界区时在自己的槽位上登记当时的纪元，离开时清除，
+       槽位按线程编号分配、各占一个缓存行，读路径上只写自己的槽位，不与其他线程争用
+    2. 写线程摘除节点后调用retire，节点挂入本线程槽位的待回收列表，并标记摘除时的纪元
+    3. 回收时先推进全局纪元，再取所有活跃槽位登记纪元的最小值，
+       早于该纪元摘除的节点不可能再被任何读线程持有，可以释放
+    4. 槽位数固定，同时存活的线程数超过槽位数时多个线程共用一个槽位，
+       槽位内记录进入的次数，共用时登记的纪元只会偏旧，回收偏保守但仍然正确
+读线程在临界区内不能阻塞太久，否则会推迟所有节点的回收。域析构时释放全部待回收节点，
+此时不应再有线程处于临界区。
+*/
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace CacheMgr {
+
+namespace detail {
+
+// 存活线程的紧凑编号，线程退出后编号回收复用
+class ThreadIndexPool {
+public:
+  static uint32_t acquire() {
+    std::lock_guard<std::mutex> lock(mutex());
+    std::vector<uint32_t> &freed = freeList();
+    if (freed.empty()) {
+      return nextIndex()++;
+    }
+    uint32_t index = freed.back();
+    freed.pop_back();
+    return index;
+  }
+
+  static void release(uint32_t index) {
+    std::lock_guard<std::mutex> lock(mutex());
+    freeList().push_back(index);
+  }
+
+private:
+  static std::mutex &mutex() {
+    static std::mutex instance;
+    return instance;
+  }
+  static std::vector<uint32_t> &freeList() {
+    static std::vector<uint32_t> instance;
+    return instance;
+  }
+  static uint32_t &nextIndex() {
+    static uint32_t instance = 0;
+    return instance;
+  }
+};
+
+// 当前线程的编号，首次调用时分配
+inline uint32_t threadIndex() {
+  struct Holder {
+    Holder() : index(ThreadIndexPool::acquire()) {}
+    ~Holder() { ThreadIndexPool::release(index); }
+    uint32_t index;
+  };
+  thread_local Holder holder;
+  return holder.index;
+}
+
+} // namespace detail
+
+class EpochDomain {
+public:
+  // 槽位数，必须是2的幂
+  static constexpr size_t kSlots = 256;
+
+  EpochDomain() : epoch_(1) {}
+
+  EpochDomain(const EpochDomain &) = delete;
+  EpochDomain &operator=(const EpochDomain &) = delete;
+
+  ~EpochDomain() {
+    for (Slot &slot : slots_) {
+      for (Retired &retired : slot.retired) {
+        retired.deleter(retired.ptr);
+      }
+    }
+  }
+
+  // 当前线程所用的槽位下标
+  static size_t slotIndex() { return detail::threadIndex() & (kSlots - 1); }
+
+  // 进入临界区，之后读到的节点在离开前不会被释放；可以嵌套
+  void enter(size_t slotIdx) {
+    std::atomic<uint64_t> &state = slots_[slotIdx].state;
+    uint64_t cur = state.load(std::memory_order_relaxed);
+    for (;;) {
+      uint64_t next = 0 != (cur & kCountMask)
+                          ? cur + 1
+                          : (epoch_.load(std::memory_order_seq_cst) << kCountBits) | 1;
+      if (state.compare_exchange_weak(cur, next, std::memory_order_seq_cst,
+                                      std::memory_order_relaxed)) {
+        return;
+      }
+    }
+  }
+
+  void leave(size_t slotIdx) {
+    slots_[slotIdx].state.fetch_sub(1, std::memory_order_release);
+  }
+
+  /// @brief 登记已从数据结构中摘除的对象，确认没有读线程持有后用deleter释放
+  /// @return 本线程槽位的待回收对象数
+  template <typename T> size_t retire(T *ptr) {
+    Slot &slot = slots_[slotIndex()];
+    std::lock_guard<std::mutex> lock(slot.mutex);
+    slot.retired.push_back(
+        Retired{ptr, [](void *obj) { delete static_cast<T *>(obj); },
+                epoch_.load(std::memory_order_seq_cst)});
+    return slot.retired.size();
+  }
+
+  /// @brief 推进全局纪元并释放已确认安全的对象
+  /// @param allSlots 为false时只回收当前线程的槽位，供写线程在待回收对象过多时顺手回收
+  void reclaim(bool allSlots = true) {
+    uint64_t safe = epoch_.fetch_add(1, std::memory_order_seq_cst) + 1;
+    for (const Slot &slot : slots_) {
+      uint64_t state = slot.state.load(std::memory_order_seq_cst);
+      if (0 != (state & kCountMask)) {
+        safe = std::min(safe, state >> kCountBits);
+      }
+    }
+    if (!allSlots) {
+      reclaimSlot(slots_[slotIndex()], safe);
+      return;
+    }
+    for (Slot &slot : slots_) {
+      reclaimSlot(slot, safe);
+    }
+  }
+
+private:
+  // 槽位状态的低位为进入次数，高位为登记的纪元
+  static constexpr unsigned kCountBits = 16;
+  static constexpr uint64_t kCountMask = (uint64_t(1) << kCountBits) - 1;
+
+  struct Retired {
+    void *ptr;              // 待释放的对象
+    void (*deleter)(void *); // 释放函数
+    uint64_t epoch;         // 摘除时的纪元
+  };
+
+  struct alignas(64) Slot {
+    std::atomic<uint64_t> state{0}; // 登记的纪元与进入次数
+    std::mutex mutex;               // 保护retired
+    std::vector<Retired> retired;   // 待回收对象
+  };
+
+  // 释放摘除纪元早于safe的对象
+  static void reclaimSlot(Slot &slot, uint64_t safe) {
+    std::vector<Retired> freed;
+    {
+      std::lock_guard<std::mutex> lock(slot.mutex);
+      // 仍需保留的排在前面
+      auto expired = std::partition(
+          slot.retired.begin(), slot.retired.end(),
+          [safe](const Retired &retired) { return retired.epoch >= safe; });
+      freed.assign(expired, slot.retired.end());
+      slot.retired.erase(expired, slot.retired.end());
+    }
+    for (Retired &retired : freed) {
+      retired.deleter(retired.ptr); // 锁外释放，析构函数可能较慢
+    }
+  }
+
+private:
+  std::atomic<uint64_t> epoch_; // 全局纪元
+  Slot slots_[kSlots];          // 按线程编号分配的槽位
+};
+
+// 临界区守卫，构造时进入、析构时离开
+class EpochGuard {
+public:
+  explicit EpochGuard(EpochDomain &domain)
+      : domain_(domain), slot_(EpochDomain::slotIndex()) {
+    domain_.enter(slot_);
+  }
+  ~EpochGuard() { domain_.leave(slot_); }
+
+  EpochGuard(const EpochGuard &) = delete;
+  EpochGuard &operator=(const EpochGuard &) = delete;
+
+  // 所在槽位的下标，可用于线程独占的计数
+  size_t slot() const { return slot_; }
+
+private:
+  EpochDomain &domain_;
+  size_t slot_;
+};
+
+} // namespace CacheMgr
\ No newline at end of file
@@ -0,0 +1,420 @@
+/*
+FlatMap:
+开放寻址的扁平哈希表（Swiss-table 风格），作为各缓存策略的可插拔索引。
+std::unordered_map 每次查找都要先访问桶节点，再跳到缓存节点，至少两次指针追逐；
+FlatMap 把关键字与值（通常是节点指针或槽位下标）直接内嵌在连续的槽位数组里：
+    1. 控制字节：每个槽位对应1字节，空槽、墓碑或哈希值的低7位(H2)
+    2. 分组探测：16个控制字节为一组，SSE2 下一条指令即可比较整组，
+       否则退化为逐字节比较
+    3. 三角探测：按组进行二次探测，负载因子上限 7/8
+对 int 这类小而平凡可复制的关键字，一次查找通常只落在控制字节与槽位两条缓存行上。
+接口保持 std::unordered_map 的常用子集（find/erase/operator[]/迭代），可直接替换。
+*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "CacheBatch.h"
+#include "CacheHash.h"
+
+namespace CacheMgr {
+
+namespace detail {
+
+// 控制字节取值：空槽与墓碑为负数，已占用槽位存放H2(0~127)
+constexpr int8_t kCtrlEmpty = -128;
+constexpr int8_t kCtrlDeleted = -2;
+constexpr size_t kGroupWidth = 16;
+
+// 一组控制字节的批量匹配，返回位掩码，第i位对应组内第i个槽位
+class CtrlGroup {
+public:
+  explicit CtrlGroup(const int8_t *ctrl) {
+#if defined(__SSE2__)
+    ctrl_ = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ctrl));
+#else
+    std::memcpy(ctrl_, ctrl, kGroupWidth);
+#endif
+  }
+
+  // 匹配指定H2的槽位
+  uint32_t match(int8_t h2) const {
+#if defined(__SSE2__)
+    return static_cast<uint32_t>(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl_)));
+#else
+    uint32_t mask = 0;
+    for (size_t idx = 0; idx < kGroupWidth; ++idx) {
+      mask |= static_cast<uint32_t>(ctrl_[idx] == h2) << idx;
+    }
+    return mask;
+#endif
+  }
+
+  // 匹配空槽
+  uint32_t matchEmpty() const { return match(kCtrlEmpty); }
+
+  // 匹配空槽或墓碑（即最高位为1的控制字节）
+  uint32_t matchAvailable() const {
+#if defined(__SSE2__)
+    return static_cast<uint32_t>(_mm_movemask_epi8(ctrl_));
+#else
+    uint32_t mask = 0;
+    for (size_t idx = 0; idx < kGroupWidth; ++idx) {
+      mask |= static_cast<uint32_t>(ctrl_[idx] < 0) << idx;
+    }
+    return mask;
+#endif
+  }
+
+private:
+#if defined(__SSE2__)
+  __m128i ctrl_;
+#else
+  int8_t ctrl_[kGroupWidth];
+#endif
+};
+
+// 取最低位的1的位置
+inline unsigned lowestBit(uint32_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+  return static_cast<unsigned>(__builtin_ctz(mask));
+#else
+  unsigned pos = 0;
+  while (0 == (mask & 1u)) {
+    mask >>= 1;
+    ++pos;
+  }
+  return pos;
+#endif
+}
+
+} // namespace detail
+
+template <typename Key, typename T, typename Hash = CacheHash<Key>,
+          typename KeyEqual = std::equal_to<Key>>
+class FlatMap {
+public:
+  using key_type = Key;
+  using mapped_type = T;
+  using value_type = std::pair<Key, T>;
+  using size_type = size_t;
+
+  template <bool IsConst> class IteratorImpl {
+  public:
+    using MapPtr = std::conditional_t<IsConst, const FlatMap *, FlatMap *>;
+    using reference =
+        std::conditional_t<IsConst, const value_type &, value_type &>;
+    using pointer =
+        std::conditional_t<IsConst, const value_type *, value_type *>;
+
+    IteratorImpl() : map_(nullptr), idx_(0) {}
+    IteratorImpl(MapPtr map, size_t idx) : map_(map), idx_(idx) {}
+    // 允许普通迭代器隐式转换为常量迭代器
+    template <bool C = IsConst, typename = std::enable_if_t<C>>
+    IteratorImpl(const IteratorImpl<false> &other)
+        : map_(other.map_), idx_(other.idx_) {}
+
+    reference operator*() const { return map_->slots_[idx_]; }
+    pointer operator->() const { return &map_->slots_[idx_]; }
+
+    IteratorImpl &operator++() {
+      idx_ = map_->nextFull(idx_ + 1);
+      return *this;
+    }
+
+    bool operator==(const IteratorImpl &other) const {
+      return idx_ == other.idx_;
+    }
+    bool operator!=(const IteratorImpl &other) const {
+      return idx_ != other.idx_;
+    }
+
+  private:
+    MapPtr map_;
+    size_t idx_;
+
+    friend class FlatMap;
+    friend class IteratorImpl<!IsConst>;
+  };
+
+  using iterator = IteratorImpl<false>;
+  using const_iterator = IteratorImpl<true>;
+
+  FlatMap() : ctrl_(nullptr), slots_(nullptr), capacity_(0), size_(0),
+              growthLeft_(0) {}
+
+  explicit FlatMap(size_t expected) : FlatMap() { reserve(expected); }
+
+  FlatMap(const FlatMap &) = delete;
+  FlatMap &operator=(const FlatMap &) = delete;
+
+  FlatMap(FlatMap &&other) noexcept : FlatMap() { swap(other); }
+  FlatMap &operator=(FlatMap &&other) noexcept {
+    if (this != &other) {
+      release();
+      swap(other);
+    }
+    return *this;
+  }
+
+  ~FlatMap() { release(); }
+
+  size_t size() const { return size_; }
+  bool empty() const { return 0 == size_; }
+
+  iterator begin() { return iterator(this, nextFull(0)); }
+  iterator end() { return iterator(this, capacity_); }
+  const_iterator begin() const { return const_iterator(this, nextFull(0)); }
+  const_iterator end() const { return const_iterator(this, capacity_); }
+
+  iterator find(const Key &key) { return iterator(this, findIndex(key)); }
+  const_iterator find(const Key &key) const {
+    return const_iterator(this, findIndex(key));
+  }
+
+  size_t count(const Key &key) const {
+    return findIndex(key) != capacity_ ? 1 : 0;
+  }
+
+  // 预取关键字首个探测组的控制字节与槽位，供批量查找提前发出内存访问
+  void prefetch(const Key &key) const {
+    if (0 == capacity_) {
+      return;
+    }
+    size_t base = (h1Of(hasher_(key)) & groupMask()) * detail::kGroupWidth;
+    detail::prefetchRead(ctrl_ + base);
+    detail::prefetchRead(&slots_[base]);
+  }
+
+  // 查找关键字，不存在时原地构造值
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(const Key &key, Args &&...args) {
+    size_t hash = hasher_(key);
+    size_t idx = findIndex(key, hash);
+    if (idx != capacity_) {
+      return {iterator(this, idx), false};
+    }
+    idx = prepareInsert(hash);
+    new (&slots_[idx]) value_type(std::piecewise_construct,
+                                  std::forward_as_tuple(key),
+                                  std::forward_as_tuple(
+                                      std::forward<Args>(args)...));
+    return {iterator(this, idx), true};
+  }
+
+  std::pair<iterator, bool> emplace(const Key &key, const T &val) {
+    return try_emplace(key, val);
+  }
+
+  std::pair<iterator, bool> insert(const value_type &kv) {
+    return try_emplace(kv.first, kv.second);
+  }
+
+  T &operator[](const Key &key) { return try_emplace(key).first->second; }
+
+  void erase(const_iterator it) { eraseIndex(it.idx_); }
+  void erase(iterator it) { eraseIndex(it.idx_); }
+
+  size_t erase(const Key &key) {
+    size_t idx = findIndex(key);
+    if (idx == capacity_) {
+      return 0;
+    }
+    eraseIndex(idx);
+    return 1;
+  }
+
+  void clear() {
+    destroySlots();
+    if (capacity_ > 0) {
+      std::memset(ctrl_, detail::kCtrlEmpty, capacity_);
+    }
+    size_ = 0;
+    growthLeft_ = maxLoad(capacity_);
+  }
+
+  // 预留至少容纳expected个元素的空间，避免插入过程中扩容
+  void reserve(size_t expected) {
+    size_t cap = detail::kGroupWidth;
+    while (maxLoad(cap) < expected) {
+      cap <<= 1;
+    }
+    if (cap > capacity_) {
+      rehash(cap);
+    }
+  }
+
+  void swap(FlatMap &other) noexcept {
+    std::swap(ctrl_, other.ctrl_);
+    std::swap(slots_, other.slots_);
+    std::swap(capacity_, other.capacity_);
+    std::swap(size_, other.size_);
+    std::swap(growthLeft_, other.growthLeft_);
+  }
+
+private:
+  // 容量的7/8作为负载上限
+  static size_t maxLoad(size_t cap) { return cap - cap / 8; }
+
+  static int8_t h2Of(size_t hash) { return static_cast<int8_t>(hash & 0x7F); }
+  static size_t h1Of(size_t hash) { return hash >> 7; }
+
+  size_t groupMask() const { return capacity_ / detail::kGroupWidth - 1; }
+
+  size_t findIndex(const Key &key) const { return findIndex(key, hasher_(key)); }
+
+  size_t findIndex(const Key &key, size_t hash) const {
+    if (0 == capacity_) {
+      return capacity_;
+    }
+    size_t group = h1Of(hash) & groupMask();
+    int8_t h2 = h2Of(hash);
+    for (size_t probe = 1;; ++probe) {
+      const size_t base = group * detail::kGroupWidth;
+      detail::CtrlGroup ctrl(ctrl_ + base);
+      for (uint32_t mask = ctrl.match(h2); mask; mask &= mask - 1) {
+        size_t idx = base + detail::lowestBit(mask);
+        if (equal_(slots_[idx].first, key)) {
+          return idx;
+        }
+      }
+      if (ctrl.matchEmpty()) {
+        return capacity_;
+      }
+      // 三角数探测，组数为2的幂时可遍历所有组
+      group = (group + probe) & groupMask();
+    }
+  }
+
+  // 为新元素找到可用槽位并写入控制字节，必要时扩容
+  size_t prepareInsert(size_t hash) {
+    if (0 == growthLeft_) {
+      // 墓碑过多时原地重建，否则容量翻倍
+      rehash(size_ * 2 >= maxLoad(capacity_) || 0 == capacity_
+                 ? (capacity_ ? capacity_ * 2 : detail::kGroupWidth)
+                 : capacity_);
+    }
+    size_t idx = findAvailable(hash);
+    if (detail::kCtrlEmpty == ctrl_[idx]) {
+      --growthLeft_;
+    }
+    ctrl_[idx] = h2Of(hash);
+    ++size_;
+    return idx;
+  }
+
+  size_t findAvailable(size_t hash) const {
+    size_t group = h1Of(hash) & groupMask();
+    for (size_t probe = 1;; ++probe) {
+      const size_t base = group * detail::kGroupWidth;
+      uint32_t mask = detail::CtrlGroup(ctrl_ + base).matchAvailable();
+      if (mask) {
+        return base + detail::lowestBit(mask);
+      }
+      group = (group + probe) & groupMask();
+    }
+  }
+
+  void eraseIndex(size_t idx) {
+    slots_[idx].~value_type();
+    --size_;
+    // 组内仍有空槽说明没有探测序列越过本组，可直接标记为空槽
+    size_t base = idx & ~(detail::kGroupWidth - 1);
+    if (detail::CtrlGroup(ctrl_ + base).matchEmpty()) {
+      ctrl_[idx] = detail::kCtrlEmpty;
+      ++growthLeft_;
+    } else {
+      ctrl_[idx] = detail::kCtrlDeleted;
+    }
+  }
+
+  size_t nextFull(size_t idx) const {
+    while (idx < capacity_ && ctrl_[idx] < 0) {
+      ++idx;
+    }
+    return idx;
+  }
+
+  void rehash(size_t newCapacity) {
+    int8_t *oldCtrl = ctrl_;
+    value_type *oldSlots = slots_;
+    size_t oldCapacity = capacity_;
+
+    ctrl_ = new int8_t[newCapacity];
+    std::memset(ctrl_, detail::kCtrlEmpty, newCapacity);
+    slots_ = std::allocator<value_type>().allocate(newCapacity);
+    capacity_ = newCapacity;
+    growthLeft_ = maxLoad(newCapacity) - size_;
+
+    for (size_t idx = 0; idx < oldCapacity; ++idx) {
+      if (oldCtrl[idx] < 0) {
+        continue;
+      }
+      size_t hash = hasher_(oldSlots[idx].first);
+      size_t pos = findAvailable(hash);
+      ctrl_[pos] = h2Of(hash);
+      new (&slots_[pos]) value_type(std::move(oldSlots[idx]));
+      oldSlots[idx].~value_type();
+    }
+
+    if (oldCapacity > 0) {
+      delete[] oldCtrl;
+      std::allocator<value_type>().deallocate(oldSlots, oldCapacity);
+    }
+  }
+
+  void destroySlots() {
+    if (!std::is_trivially_destructible<value_type>::value) {
+      for (size_t idx = 0; idx < capacity_; ++idx) {
+        if (ctrl_[idx] >= 0) {
+          slots_[idx].~value_type();
+        }
+      }
+    }
+  }
+
+  void release() {
+    if (0 == capacity_) {
+      return;
+    }
+    destroySlots();
+    delete[] ctrl_;
+    std::allocator<value_type>().deallocate(slots_, capacity_);
+    ctrl_ = nullptr;
+    slots_ = nullptr;
+    capacity_ = 0;
+    size_ = 0;
+    growthLeft_ = 0;
+  }
+
+private:
+  int8_t *ctrl_;       // 控制字节数组
+  value_type *slots_;  // 槽位数组，关键字与值内嵌存放
+  size_t capacity_;    // 槽位数量，0或16的2的幂倍
+  size_t size_;        // 元素数量
+  size_t growthLeft_;  // 不扩容时还可写入的空槽数量
+  Hash hasher_;        // 哈希函数
+  KeyEqual equal_;     // 关键字比较
+};
+
+// 策略默认使用的索引：小而平凡可复制的关键字用FlatMap，其余沿用std::unordered_map
+template <typename Key, typename T>
+using CacheIndexMap =
+    std::conditional_t<std::is_trivially_copyable<Key>::value &&
+                           sizeof(Key) <= 16,
+                       FlatMap<Key, T>, std::unordered_map<Key, T>>;
+
+} // namespace CacheMgr
\ No newline at end of file
@@ -0,0 +1,243 @@
+/*
+FrontCache:
+共享缓存之前的线程本地一级缓存（L1），热点命中不再访问共享分片，也不加分片锁：
+    1. 每个线程一个直接映射的小表（默认64个槽位），只由该线程读写，不加锁；
+       槽位按关键字哈希的高位选取，冲突时按频次决定是否覆盖
+    2. 只缓存热点：每个线程另有一个频次估计（FrequencySketch），在穿透到共享缓存的命中中按1/4采样计数，
+       估计频次达到阈值、且不低于槽位上原有条目时才写入L1
+    3. 失效按关键字哈希分成4096个条带，每个条带一个版本号：put与remove先写共享缓存，再递增条带版本；
+       L1条目记录读取共享缓存之前的版本，命中时版本不一致即视为失效，穿透到共享缓存重新读取
+    4. 每个L1条目最多连续命中refreshHits次，之后穿透到共享缓存一次并重新填入：
+       共享缓存因此仍能看到热点的访问，不会把最热的条目当作冷条目淘汰；
+       共享缓存中的淘汰与到期最迟在这么多次命中之后反映到L1
+命中L1时只读取一次条带版本，该缓存行只在写入同一条带时变化；写入频繁的热点会使各线程的L1反复失效，
+此时L1只是多一次查表。线程编号复用CacheEpoch的紧凑编号，编号不小于kMaxThreads的线程不使用L1；
+线程退出后编号被新线程复用时连同L1一起接手，旧条目仍按版本校验。
+直接写入共享缓存不会使L1失效，所有写入都应经过本类。共享缓存需支持get、put、remove与stats，
+如LRUHashCache与LFUHashCache。
+*/
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "CacheEpoch.h"
+#include "CacheHash.h"
+#include "CacheSketch.h"
+#include "CacheStats.h"
+
+namespace CacheMgr {
+
+// L1的配置
+struct FrontOptions {
+  // 每个线程的槽位数，取不小于该值的2的幂
+  size_t slots = 64;
+  // 每个L1条目连续命中的上限，之后穿透到共享缓存刷新一次
+  uint32_t refreshHits = 32;
+  // 写入L1所需的估计频次（按采样计数）
+  uint32_t hotFrequency = 3;
+};
+
+// 各线程L1的计数之和
+struct FrontStats {
+  uint64_t hits = 0;    // 命中L1
+  uint64_t stale = 0;   // L1中的条目因写入而失效
+  uint64_t fills = 0;   // 写入或刷新L1
+  uint64_t threads = 0; // 已建立L1的线程数
+};
+
+template <typename Key, typename Value, typename Shared> class FrontCache {
+public:
+  // 使用L1的线程编号上限
+  static constexpr size_t kMaxThreads = 256;
+
+  /// @param options L1的配置
+  /// @param sharedArgs 共享缓存的构造参数
+  template <typename... Args>
+  explicit FrontCache(FrontOptions options, Args &&...sharedArgs)
+      : options_(options), slotNum_(1), shared_(std::forward<Args>(sharedArgs)...),
+        versions_(new std::atomic<uint64_t>[kStripes]) {
+    while (slotNum_ < options_.slots) {
+      slotNum_ <<= 1;
+    }
+    if (0 == options_.refreshHits) {
+      options_.refreshHits = 1;
+    }
+    for (size_t idx = 0; idx < kStripes; ++idx) {
+      versions_[idx].store(0, std::memory_order_relaxed);
+    }
+    for (std::atomic<Front *> &front : fronts_) {
+      front.store(nullptr, std::memory_order_relaxed);
+    }
+  }
+
+  FrontCache(const FrontCache &) = delete;
+  FrontCache &operator=(const FrontCache &) = delete;
+
+  ~FrontCache() {
+    for (std::atomic<Front *> &front : fronts_) {
+      delete front.load(std::memory_order_relaxed);
+    }
+  }
+
+  void put(const Key &key, const Value &val) {
+    shared_.put(key, val);
+    invalidate(key);
+  }
+
+  void put(const Key &key, Value &&val) {
+    shared_.put(key, std::move(val));
+    invalidate(key);
+  }
+
+  bool get(const Key &key, Value &val) {
+    uint64_t hash = static_cast<uint64_t>(CacheHash<Key>{}(key));
+    std::atomic<uint64_t> &version = versions_[hash & (kStripes - 1)];
+    Front *front = localFront();
+    if (nullptr == front) {
+      return shared_.get(key, val);
+    }
+    Slot &slot = front->slots[static_cast<size_t>(hash >> 32) & (slotNum_ - 1)];
+    bool same = slot.used && slot.key == key;
+    if (same && slot.budget > 0) {
+      if (slot.version == version.load(std::memory_order_acquire)) {
+        --slot.budget;
+        val = slot.value;
+        bump(front->hits);
+        return true;
+      }
+      slot.budget = 0;
+      bump(front->stale);
+    }
+    // 先取版本再读共享缓存，读取期间有写入时填入的条目下次命中即失效
+    uint64_t seen = version.load(std::memory_order_acquire);
+    if (!shared_.get(key, val)) {
+      return false;
+    }
+    if (same || admit(*front, slot, key)) {
+      slot.used = true;
+      slot.key = key;
+      slot.value = val;
+      slot.version = seen;
+      slot.budget = options_.refreshHits;
+      bump(front->fills);
+    }
+    return true;
+  }
+
+  Value get(const Key &key) {
+    Value val{};
+    get(key, val);
+    return val;
+  }
+
+  // 删除指定缓存，同时使各线程L1中的旧值失效
+  void remove(const Key &key) {
+    shared_.remove(key);
+    invalidate(key);
+  }
+
+  // 共享缓存的统计，命中次数含L1的命中
+  CacheStats stats() const {
+    CacheStats total = shared_.stats();
+    total.hits += frontStats().hits;
+    return total;
+  }
+
+  /// @brief 各线程L1的计数之和
+  FrontStats frontStats() const {
+    FrontStats stats;
+    for (const std::atomic<Front *> &slot : fronts_) {
+      const Front *front = slot.load(std::memory_order_acquire);
+      if (nullptr == front) {
+        continue;
+      }
+      stats.hits += front->hits.load(std::memory_order_relaxed);
+      stats.stale += front->stale.load(std::memory_order_relaxed);
+      stats.fills += front->fills.load(std::memory_order_relaxed);
+      ++stats.threads;
+    }
+    return stats;
+  }
+
+private:
+  // 版本条带数，必须是2的幂
+  static constexpr size_t kStripes = 4096;
+  // 频次估计的计数器数量相对槽位数的倍数
+  static constexpr size_t kSketchScale = 8;
+  // 穿透读取的采样间隔，必须是2的幂
+  static constexpr uint32_t kSampleRate = 4;
+
+  struct Slot {
+    Key key{};          // 关键字
+    Value value{};      // 缓存值的副本
+    uint64_t version = 0; // 读取共享缓存之前的条带版本
+    uint32_t budget = 0;  // 剩余的命中次数，为0时穿透刷新
+    bool used = false;    // 是否存放过条目
+  };
+
+  // 一个线程的L1，计数只由所属线程写入
+  struct alignas(64) Front {
+    explicit Front(size_t slotNum)
+        : slots(slotNum), sketch(kSketchScale * slotNum), calls(0) {}
+
+    std::vector<Slot> slots;        // 直接映射的槽位
+    FrequencySketch<Key> sketch;    // 穿透读取的频次估计
+    uint32_t calls;                 // 穿透读取次数，用于采样
+    std::atomic<uint64_t> hits{0};  // 命中L1
+    std::atomic<uint64_t> stale{0}; // 条目失效
+    std::atomic<uint64_t> fills{0}; // 写入或刷新
+  };
+
+  // 当前线程的L1，首次访问时建立；编号超出上限时为空
+  Front *localFront() {
+    size_t index = detail::threadIndex();
+    if (index >= kMaxThreads) {
+      return nullptr;
+    }
+    Front *front = fronts_[index].load(std::memory_order_acquire);
+    if (nullptr == front) {
+      front = new Front(slotNum_);
+      fronts_[index].store(front, std::memory_order_release);
+    }
+    return front;
+  }
+
+  // 只有所属线程写入，不需要原子的读改写
+  static void bump(std::atomic<uint64_t> &counter) {
+    counter.store(counter.load(std::memory_order_relaxed) + 1,
+                  std::memory_order_relaxed);
+  }
+
+  // 采样计数，估计频次达到阈值且不低于槽位上的原有条目时写入L1
+  bool admit(Front &front, const Slot &slot, const Key &key) {
+    if (0 != (++front.calls & (kSampleRate - 1))) {
+      return false;
+    }
+    front.sketch.increment(key);
+    uint32_t freq = front.sketch.frequency(key);
+    if (freq < options_.hotFrequency) {
+      return false;
+    }
+    return !slot.used || freq >= front.sketch.frequency(slot.key);
+  }
+
+  // 写入共享缓存之后调用，递增条带版本使各线程L1中的旧值失效
+  void invalidate(const Key &key) {
+    size_t stripe = static_cast<size_t>(CacheHash<Key>{}(key)) & (kStripes - 1);
+    versions_[stripe].fetch_add(1, std::memory_order_release);
+  }
+
+private:
+  FrontOptions options_;    // L1的配置
+  size_t slotNum_;          // 每个线程的槽位数
+  Shared shared_;           // 共享缓存
+  std::unique_ptr<std::atomic<uint64_t>[]> versions_; // 条带版本
+  std::atomic<Front *> fronts_[kMaxThreads];          // 按线程编号的L1
+};
+
+} // namespace CacheMgr
\ No newline at end of file
@@ -0,0 +1,136 @@
+/*
+GhostList:
+只记录关键字指纹的影子队列，用于ARC的淘汰历史与LRU-K的访问历史：
+    1. 不保存关键字与缓存值，条目被淘汰时节点与缓存值立即释放，影子队列里只留下64位关键字哈希
+    2. 指纹按记录先后存放在环形数组中，另用扁平哈希表保存指纹到（最新记录的序号, 记录次数）的映射，
+       命中判断只需一次哈希表查找
+    3. 命中删除或再次记录时不移动环形数组中的旧记录，只让它与哈希表中的序号不一致而失效；
+       环形数组的长度为容量的两倍以上，为失效记录留出余量，满时从最旧处弹出
+    4. 有效指纹数超过容量时弹出最旧的有效指纹，再次记录会把指纹移到最新，效果上是LRU顺序
+64位指纹发生冲突的概率可以忽略，冲突时只会误判一次影子命中或多计一次访问。
+*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "CacheFlatMap.h"
+#include "CacheHash.h"
+
+namespace CacheMgr {
+
+template <typename Key, typename Hash = CacheHash<Key>> class GhostList {
+public:
+  /// @param capacity 最多记录的指纹数，为0时不记录
+  explicit GhostList(size_t capacity) : capacity_(0), head_(0), tail_(0) {
+    setCapacity(capacity);
+  }
+
+  static uint64_t fingerprint(const Key &key) {
+    return static_cast<uint64_t>(Hash{}(key));
+  }
+
+  /// @brief 记录关键字，已记录时移到最新并累加次数
+  /// @param onDrop 为腾出位置而弹出的指纹的回调
+  /// @return 记录后的次数；容量为0时不记录，返回1
+  template <typename OnDrop> uint32_t touch(const Key &key, OnDrop &&onDrop) {
+    if (0 == capacity_) {
+      return 1;
+    }
+    uint64_t fp = fingerprint(key);
+    uint32_t count = 1;
+    auto it = entries_.find(fp);
+    if (it != entries_.end()) {
+      count = ++it->second.count;
+      it->second.seq = tail_;
+    } else {
+      while (entries_.size() >= capacity_) {
+        popOldest(onDrop);
+      }
+      entries_[fp] = Entry{tail_, count};
+    }
+    if (tail_ - head_ == ring_.size()) {
+      popOldest(onDrop); // 环形数组已满，最旧的记录多半已经失效
+    }
+    ring_[tail_ & (ring_.size() - 1)] = fp;
+    ++tail_;
+    return count;
+  }
+
+  uint32_t touch(const Key &key) {
+    return touch(key, [](uint64_t) {});
+  }
+
+  /// @brief 删除关键字的记录
+  /// @return 删除前已记录返回true，即影子命中
+  bool erase(const Key &key) { return 0 != entries_.erase(fingerprint(key)); }
+
+  bool contains(const Key &key) const {
+    return entries_.find(fingerprint(key)) != entries_.end();
+  }
+
+  // 关键字的记录次数，未记录时为0
+  uint32_t count(const Key &key) const {
+    auto it = entries_.find(fingerprint(key));
+    return it != entries_.end() ? it->second.count : 0;
+  }
+
+  /// @brief 调整容量，缩小时弹出最旧的指纹
+  template <typename OnDrop> void setCapacity(size_t capacity, OnDrop &&onDrop) {
+    capacity_ = capacity;
+    while (entries_.size() > capacity_) {
+      popOldest(onDrop);
+    }
+    size_t ringSize = ring_.empty() ? 16 : ring_.size();
+    while (ringSize < 2 * capacity_) {
+      ringSize *= 2;
+    }
+    if (ringSize != ring_.size()) {
+      // 环形数组只增长，按原顺序搬到新数组
+      std::vector<uint64_t> ring(ringSize);
+      for (uint64_t seq = head_; seq != tail_; ++seq) {
+        ring[seq & (ringSize - 1)] = ring_[seq & (ring_.size() - 1)];
+      }
+      ring_.swap(ring);
+    }
+  }
+
+  void setCapacity(size_t capacity) {
+    setCapacity(capacity, [](uint64_t) {});
+  }
+
+  size_t size() const { return entries_.size(); }
+  size_t capacity() const { return capacity_; }
+
+  void clear() {
+    entries_.clear();
+    head_ = tail_;
+  }
+
+private:
+  struct Entry {
+    uint64_t seq;   // 最新一次记录在环形数组中的序号
+    uint32_t count; // 记录次数
+  };
+
+  // 弹出环形数组中最旧的记录，记录仍有效时删除指纹
+  template <typename OnDrop> void popOldest(OnDrop &onDrop) {
+    uint64_t fp = ring_[head_ & (ring_.size() - 1)];
+    auto it = entries_.find(fp);
+    if (it != entries_.end() && it->second.seq == head_) {
+      entries_.erase(it);
+      onDrop(fp);
+    }
+    ++head_;
+  }
+
+private:
+  size_t capacity_;                // 最多记录的指纹数
+  uint64_t head_;                  // 最旧记录的序号
+  uint64_t tail_;                  // 下一条记录的序号
+  std::vector<uint64_t> ring_;     // 按记录先后排列的指纹，长度为2的幂
+  FlatMap<uint64_t, Entry> entries_; // 有效指纹到最新记录的映射
+};
+
+} // namespace CacheMgr
\ No newline at end of file
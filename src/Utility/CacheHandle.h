@@ -0,0 +1,93 @@
+/*
+HandleCache:
+共享所有权的缓存值句柄模式，底层缓存存放std::shared_ptr<const Value>而不是值本身：
+    1. 命中时在锁内只复制一个句柄（一次引用计数自增），多KB的值不再在临界区内复制
+    2. 写入时句柄在加锁之前构造，值的分配与复制同样移出临界区
+    3. 句柄指向的值不可修改，被淘汰或覆盖后仍持有句柄的读者可以继续安全读取
+    4. getHandle直接返回句柄，完全避免复制；CacheBase的按值接口在锁外解引用句柄后复制
+Store为保存句柄的底层缓存，只要求提供put(key, Handle&&)与get(key, Handle&)，
+既可以是LRUCache、LFUAvgCache等CacheBase实现，也可以是LRUHashCache、LFUHashCache等分片包装。
+*/
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <utility>
+
+#include "CacheBase.h"
+
+namespace CacheMgr {
+
+// 缓存值句柄，值在放入缓存后不再修改
+template <typename Value> using ValueHandle = std::shared_ptr<const Value>;
+
+template <typename Key, typename Value, typename Store>
+class HandleCache : public CacheBase<Key, Value> {
+public:
+  using Handle = ValueHandle<Value>;
+
+  // 构造参数原样转交给底层缓存
+  template <typename... Args>
+  explicit HandleCache(Args &&...args) : store_(std::forward<Args>(args)...) {}
+
+  ~HandleCache() override = default;
+
+  void put(const Key &key, const Value &val) override {
+    store_.put(key, Handle(std::make_shared<const Value>(val)));
+  }
+
+  void put(const Key &key, Value &&val) override {
+    store_.put(key, Handle(std::make_shared<const Value>(std::move(val))));
+  }
+
+  // 直接放入已有的句柄，多个关键字可以共享同一个值
+  void putHandle(const Key &key, Handle handle) {
+    if (nullptr != handle) {
+      store_.put(key, std::move(handle));
+    }
+  }
+
+  // 返回缓存值的句柄，未命中时返回nullptr
+  Handle getHandle(const Key &key) {
+    Handle handle;
+    if (!store_.get(key, handle)) {
+      return nullptr;
+    }
+    return handle;
+  }
+
+  bool get(const Key &key, Value &val) override {
+    Handle handle = getHandle(key);
+    if (nullptr == handle) {
+      return false;
+    }
+    val = *handle; // 在锁外复制
+    return true;
+  }
+
+  Value get(const Key &key) override {
+    Handle handle = getHandle(key);
+    return nullptr != handle ? *handle : Value{};
+  }
+
+  // visitor在锁外执行，可以在其中再次访问本缓存
+  bool visit(const Key &key,
+             const std::function<void(const Value &)> &visitor) override {
+    Handle handle = getHandle(key);
+    if (nullptr == handle) {
+      return false;
+    }
+    visitor(*handle);
+    return true;
+  }
+
+  CacheStats stats() const override { return store_.stats(); }
+
+  // 访问底层缓存，用于调用其特有的接口
+  Store &store() { return store_; }
+
+private:
+  Store store_; // 保存句柄的底层缓存
+};
+
+} // namespace CacheMgr
\ No newline at end of file
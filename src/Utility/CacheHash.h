@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace CacheMgr {
+
+/// @brief 64位哈希混合（murmur3 fmix64），打散低熵的原始哈希值
+/// @param hash 原始哈希值
+/// @return 混合后的哈希值
+inline uint64_t mixHash(uint64_t hash) {
+  hash ^= hash >> 33;
+  hash *= 0xFF51AFD7ED558CCDull;
+  hash ^= hash >> 33;
+  hash *= 0xC4CEB9FE1A85EC53ull;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+// 在std::hash之上做一次混合，libstdc++中整数的std::hash是恒等映射，
+// 直接取低位或高位都会让连续、等间隔的关键字聚集
+template <typename Key> struct CacheHash {
+  size_t operator()(const Key &key) const {
+    return static_cast<size_t>(
+        mixHash(static_cast<uint64_t>(std::hash<Key>{}(key))));
+  }
+};
+
+} // namespace CacheMgr
\ No newline at end of file
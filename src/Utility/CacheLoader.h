@@ -0,0 +1,92 @@
+/*
+LoadTable:
+读穿加载（read-through）的单飞表，合并同一关键字上并发的未命中：
+    1. 第一个未命中的线程在表中登记一个future，成为该关键字的加载者
+    2. 之后未命中的线程在表中找到这个future，直接等待，不再访问后端
+    3. 加载者把结果写入缓存后再从表中删除登记，
+       晚到的线程要么还能找到future，要么已经能从缓存命中
+每个缓存（分片包装中是每个分片）各自一张表，表锁只在登记与删除时短暂持有，
+加载本身在锁外执行。分片包装的异步加载在包装一层登记，加载线程每次读写都重新经过分片路由，
+不持有任何分片的指针，分片在加载期间被迁出也不受影响。
+*/
+#pragma once
+
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+#include "CacheHash.h"
+#include "CacheStats.h"
+
+namespace CacheMgr {
+
+template <typename Key, typename Value> class LoadTable {
+public:
+  /// @brief 查找或登记关键字的加载
+  /// @param pending 已有加载时传出其future
+  /// @param promise 没有加载时以它的future登记，调用方成为加载者
+  /// @return 调用方是否成为加载者
+  bool join(const Key &key, std::shared_future<Value> &pending,
+            std::promise<Value> &promise) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = pending_.find(key);
+    if (it != pending_.end()) {
+      pending = it->second;
+      return false;
+    }
+    pending_.emplace(key, promise.get_future().share());
+    return true;
+  }
+
+  /// @brief 调用方未命中后的异步加载：已有加载时返回其future，否则在新线程中加载；
+  ///        加载线程先以lookup(key, val)再次查找（不计入命中统计），仍未命中时调用loader并以store写入
+  /// @return 加载结果的future，加载者持有的future析构时会等待加载结束
+  template <typename Lookup, typename Loader, typename Store>
+  std::shared_future<Value> loadAsync(const Key &key, Lookup lookup,
+                                      Loader loader, Store store) {
+    auto promise = std::make_shared<std::promise<Value>>();
+    std::shared_future<Value> pending;
+    if (!join(key, pending, *promise)) {
+      return pending;
+    }
+    return std::async(std::launch::async,
+                      [this, key, lookup, loader, store, promise] {
+                        Value val;
+                        try {
+                          bool found;
+                          {
+                            UncountedLookup uncounted;
+                            found = lookup(key, val);
+                          }
+                          if (!found) {
+                            val = loader(key);
+                            store(key, val);
+                          }
+                          promise->set_value(val);
+                        } catch (...) {
+                          promise->set_exception(std::current_exception());
+                          finish(key);
+                          throw;
+                        }
+                        finish(key);
+                        return val;
+                      })
+        .share();
+  }
+
+  // 加载完成（或失败）后删除登记
+  void finish(const Key &key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_.erase(key);
+  }
+
+private:
+  std::mutex mutex_; // 保护登记表
+  std::unordered_map<Key, std::shared_future<Value>, CacheHash<Key>>
+      pending_; // 进行中的加载
+};
+
+} // namespace CacheMgr
\ No newline at end of file
@@ -0,0 +1,234 @@
+/*
+MissRatioMonitor:
+在线估计未命中率-容量曲线（MRC）的采样监视器，参考SHARDS的空间采样：
+    1. 关键字哈希值的低24位小于阈值时才被采样，采样率R = 阈值 / 2^24，
+       同一关键字要么每次都被采样、要么从不采样，未采样的访问只多一次哈希与比较
+    2. 对采样到的访问计算重用距离：上次访问以来访问过的不同采样关键字数，
+       用按访问时刻编号的树状数组计数，时刻用尽时按上次访问时刻重新编号
+    3. 重用距离按1/R放大后累加到等宽直方图，容量为c的LRU在距离小于c时命中，
+       由直方图的累积和即可得到任意容量下的估计未命中率
+    4. 采样关键字超过上限时采样率减半，并剔除不再满足阈值的关键字（固定容量的SHARDS），
+       此前记录的样本按当时的采样率计权，曲线不需要重新计算
+    5. 热点关键字恰好被采样（或恰好未被采样）时，放大后的访问次数会明显偏离真实值；
+       提供真实访问次数时按SHARDS-adj把差值计入距离最小的桶，修正这部分偏差
+曲线按LRU的栈距离估计，对其他策略是近似值，用于判断加倍或减半容量后的命中率变化。
+采样到的访问在监视器自己的锁内处理，与缓存分片的锁相互独立。
+*/
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "CacheFlatMap.h"
+#include "CacheHash.h"
+
+namespace CacheMgr {
+
+// 估计的未命中率-容量曲线
+struct MissRatioCurve {
+  std::vector<size_t> capacities;  // 容量（条目数），递增
+  std::vector<double> missRatios;  // 对应容量下的估计未命中率
+  double sampledRefs = 0;          // 按采样率放大后的访问次数
+
+  // 任意容量下的估计未命中率，在相邻的两个点之间线性插值
+  double missRatioAt(size_t capacity) const {
+    if (capacities.empty()) {
+      return 1.0;
+    }
+    if (capacity <= capacities.front()) {
+      return missRatios.front();
+    }
+    for (size_t idx = 1; idx < capacities.size(); ++idx) {
+      if (capacity <= capacities[idx]) {
+        double span = static_cast<double>(capacities[idx] - capacities[idx - 1]);
+        double ratio = (capacity - capacities[idx - 1]) / span;
+        return missRatios[idx - 1] +
+               ratio * (missRatios[idx] - missRatios[idx - 1]);
+      }
+    }
+    return missRatios.back();
+  }
+};
+
+template <typename Key, typename Hash = CacheHash<Key>,
+          template <typename, typename> class Index = CacheIndexMap>
+class MissRatioMonitor {
+public:
+  /// @param maxCapacity 曲线覆盖的最大容量，通常取当前容量的数倍
+  /// @param sampleRate 初始采样率，取值(0, 1]
+  /// @param maxTracked 同时跟踪的采样关键字上限，超过后采样率减半
+  /// @param binNum 直方图的桶数，即曲线上的点数
+  explicit MissRatioMonitor(size_t maxCapacity, double sampleRate = 0.001,
+                            size_t maxTracked = 8192, size_t binNum = 64)
+      : threshold_(thresholdOf(sampleRate)), maxTracked_(maxTracked),
+        binWidth_(std::max<size_t>(1, (maxCapacity + binNum - 1) / binNum)),
+        bins_(binNum + 1, 0.0), clock_(0), tree_(2 * maxTracked + 2, 0) {}
+
+  MissRatioMonitor(const MissRatioMonitor &) = delete;
+  MissRatioMonitor &operator=(const MissRatioMonitor &) = delete;
+
+  // 记录一次访问；未被采样时只计算一次哈希，不加锁
+  void access(const Key &key) { access(key, Hash{}(key)); }
+
+  // 调用方已经算过关键字的哈希值时直接传入，未被采样时只多一次比较
+  void access(const Key &key, size_t hash) {
+    uint32_t sample = static_cast<uint32_t>(hash) & (kSampleSpace - 1);
+    if (sample >= threshold_.load(std::memory_order_relaxed)) {
+      return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    record(key, sample);
+  }
+
+  /// @brief 当前的估计曲线，第i个点为容量 (i+1) * 桶宽
+  /// @param totalRefs 同一时段内的真实访问次数（如命中数+未命中数），为0时不修正
+  MissRatioCurve curve(uint64_t totalRefs = 0) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    MissRatioCurve curve;
+    double sampled = coldWeight_;
+    for (double weight : bins_) {
+      sampled += weight;
+    }
+    curve.sampledRefs = sampled;
+    double total = 0 != totalRefs ? static_cast<double>(totalRefs) : sampled;
+    double hits = total - sampled; // SHARDS-adj：差值计入距离最小的桶
+    for (size_t idx = 0; idx + 1 < bins_.size(); ++idx) {
+      hits += bins_[idx];
+      double ratio = total > 0 ? 1.0 - hits / total : 1.0;
+      curve.capacities.push_back((idx + 1) * binWidth_);
+      curve.missRatios.push_back(std::min(1.0, std::max(0.0, ratio)));
+    }
+    return curve;
+  }
+
+  // 当前采样率
+  double sampleRate() const {
+    return static_cast<double>(threshold_.load(std::memory_order_relaxed)) /
+           kSampleSpace;
+  }
+
+  // 清空所有统计，采样率保持不变
+  void reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::fill(bins_.begin(), bins_.end(), 0.0);
+    coldWeight_ = 0;
+    tracked_.clear();
+    std::fill(tree_.begin(), tree_.end(), 0);
+    clock_ = 0;
+  }
+
+private:
+  static constexpr uint32_t kSampleBits = 24;
+  static constexpr uint32_t kSampleSpace = 1u << kSampleBits;
+
+  struct Tracked {
+    uint32_t time;   // 上次访问的时刻
+    uint32_t sample; // 哈希值的采样位，采样率降低时用于剔除
+  };
+
+  static uint32_t thresholdOf(double sampleRate) {
+    double rate = std::min(1.0, std::max(sampleRate, 1.0 / kSampleSpace));
+    return static_cast<uint32_t>(rate * kSampleSpace);
+  }
+
+  void record(const Key &key, uint32_t sample) {
+    if (sample >= threshold_.load(std::memory_order_relaxed)) {
+      return; // 等锁期间采样率已降低
+    }
+    // 按记录时的采样率计权，采样率变化前后的样本可以直接相加
+    double weight = 1.0 / sampleRate();
+    if (clock_ + 1 >= tree_.size()) {
+      renumber();
+    }
+    uint32_t now = ++clock_;
+    auto it = tracked_.find(key);
+    if (it == tracked_.end()) {
+      coldWeight_ += weight;
+      tracked_[key] = Tracked{now, sample};
+      add(now, 1);
+      if (tracked_.size() > maxTracked_) {
+        lowerRate();
+      }
+      return;
+    }
+    uint32_t last = it->second.time;
+    // 两次访问之间访问过的不同采样关键字数，放大为全体关键字数
+    uint64_t distinct = prefix(now - 1) - prefix(last);
+    size_t distance = static_cast<size_t>(distinct * weight);
+    size_t bin = std::min(distance / binWidth_, bins_.size() - 1);
+    bins_[bin] += weight;
+    add(last, -1);
+    add(now, 1);
+    it->second.time = now;
+  }
+
+  // 采样率减半，剔除哈希值不再满足阈值的关键字；阈值降为0后停止采样
+  void lowerRate() {
+    uint32_t threshold = threshold_.load(std::memory_order_relaxed) / 2;
+    threshold_.store(threshold, std::memory_order_relaxed);
+    std::vector<Key> dropped;
+    for (auto &entry : tracked_) {
+      if (entry.second.sample >= threshold) {
+        dropped.push_back(entry.first);
+      }
+    }
+    for (const Key &key : dropped) {
+      tracked_.erase(key);
+    }
+    renumber();
+  }
+
+  // 按上次访问时刻的先后把跟踪中的关键字重新编号为1..n，重建树状数组
+  void renumber() {
+    std::vector<std::pair<uint32_t, Key>> order;
+    order.reserve(tracked_.size());
+    for (auto &entry : tracked_) {
+      order.emplace_back(entry.second.time, entry.first);
+    }
+    std::sort(order.begin(), order.end(),
+              [](const std::pair<uint32_t, Key> &lhs,
+                 const std::pair<uint32_t, Key> &rhs) {
+                return lhs.first < rhs.first;
+              });
+    std::fill(tree_.begin(), tree_.end(), 0);
+    clock_ = 0;
+    for (auto &entry : order) {
+      tracked_[entry.second].time = ++clock_;
+      add(clock_, 1);
+    }
+  }
+
+  // 树状数组：时刻pos的计数加delta
+  void add(uint32_t pos, int delta) {
+    for (; pos < tree_.size(); pos += pos & (~pos + 1)) {
+      tree_[pos] += delta;
+    }
+  }
+
+  // 树状数组：时刻1..pos的计数之和
+  uint64_t prefix(uint32_t pos) const {
+    int64_t sum = 0;
+    for (; pos > 0; pos -= pos & (~pos + 1)) {
+      sum += tree_[pos];
+    }
+    return static_cast<uint64_t>(sum);
+  }
+
+private:
+  std::atomic<uint32_t> threshold_; // 采样阈值，哈希值低24位小于它时采样
+  size_t maxTracked_;               // 跟踪的采样关键字上限
+  size_t binWidth_;                 // 直方图每个桶覆盖的重用距离
+  std::vector<double> bins_;        // 重用距离直方图，最后一个桶收纳超出范围的距离
+  double coldWeight_ = 0;           // 首次访问（冷未命中）的权重
+  uint32_t clock_;                  // 当前时刻
+  std::vector<int32_t> tree_;       // 按时刻编号的树状数组，标记各关键字的最近访问
+  Index<Key, Tracked> tracked_;     // 跟踪中的采样关键字
+  mutable std::mutex mutex_;        // 保护采样访问的处理
+};
+
+} // namespace CacheMgr
\ No newline at end of file
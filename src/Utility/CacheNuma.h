@@ -0,0 +1,468 @@
+/*
+NumaHashCache:
+按NUMA节点分组的分片缓存，用于多路服务器，避免一半的线程在每次命中时都跨插槽访问内存：
+    1. NumaTopology从/sys/devices/system/node读取节点与CPU的对应关系，读取失败时视为单节点；
+       每个节点一组分片（Shard，如LRUHashCache），由绑定到该节点CPU上的线程构造，
+       分片、索引与初始的桶数组按首次访问原则分配在本节点的内存上
+    2. 每个关键字有一个归属节点，默认按哈希的高位均分，也可以设置路由函数把关键字区间固定到某个节点，
+       配合homeNode把请求派发到该节点的线程上，读写全部落在本节点的分片里
+    3. 复制路由（NumaRouting::ReplicateHot）下每个节点另有一个小的热点副本：
+       从其他节点读到的条目在本节点的频次估计（FrequencySketch）达到阈值后复制一份，之后本节点直接命中副本；
+       写入与删除先更新归属节点，再使各节点副本中的旧值失效，只适合读多写少的热点
+    4. 副本与写入之间按关键字哈希分成4096个条带：写入在更新归属节点后递增条带版本，
+       复制前后版本不一致时撤回刚写入的副本，不会留下比归属节点旧的值；
+       条带上从未复制过条目时写入不访问其他节点的副本
+    5. 按调用线程所在的节点分别统计本节点命中、跨节点命中、副本命中、未命中与采样的get延迟
+写入时新分配的条目来自写入线程所在节点的内存，关键字按节点派发时才完全本地。
+分片组需支持(容量, 分片数)构造以及get、put、remove与stats，如LRUHashCache。
+*/
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <pthread.h>
+#include <sched.h>
+
+#include "CacheHash.h"
+#include "CacheSketch.h"
+#include "CacheStats.h"
+
+namespace CacheMgr {
+
+// 节点与CPU的对应关系
+class NumaTopology {
+public:
+  /// @brief 读取本机的NUMA拓扑，读取失败时视为所有CPU同属一个节点
+  static NumaTopology detect() {
+    NumaTopology topology;
+    std::vector<int> nodes;
+    if (readList("/sys/devices/system/node/online", nodes)) {
+      for (int node : nodes) {
+        std::vector<int> cpus;
+        std::string path = "/sys/devices/system/node/node" +
+                           std::to_string(node) + "/cpulist";
+        if (readList(path.c_str(), cpus) && !cpus.empty()) {
+          topology.addNode(std::move(cpus));
+        }
+      }
+    }
+    if (0 == topology.nodeCount()) {
+      topology.addNode(allCpus());
+    }
+    return topology;
+  }
+
+  /// @brief 把本机的CPU按编号顺序均分成nodeNum个节点，用于在单节点机器上模拟多节点
+  static NumaTopology uniform(size_t nodeNum) {
+    std::vector<int> cpus = allCpus();
+    nodeNum = std::max<size_t>(1, nodeNum);
+    NumaTopology topology;
+    for (size_t node = 0; node < nodeNum; ++node) {
+      size_t begin = node * cpus.size() / nodeNum;
+      size_t end = (node + 1) * cpus.size() / nodeNum;
+      if (begin == end) {
+        // CPU少于节点数时多个节点共用一个CPU
+        topology.addNode({cpus[node % cpus.size()]});
+      } else {
+        topology.addNode(std::vector<int>(cpus.begin() + begin, cpus.begin() + end));
+      }
+    }
+    return topology;
+  }
+
+  size_t nodeCount() const { return nodes_.size(); }
+
+  const std::vector<int> &cpusOf(size_t node) const { return nodes_[node]; }
+
+  // CPU所属的节点，未知的CPU归入节点0
+  size_t nodeOfCpu(int cpu) const {
+    return cpu >= 0 && static_cast<size_t>(cpu) < cpuNodes_.size()
+               ? cpuNodes_[cpu]
+               : 0;
+  }
+
+  // 调用线程当前所在的节点，每隔kRefreshCalls次调用重新读取一次所在CPU，跟上线程迁移
+  size_t currentNode() const {
+    struct Cached {
+      int cpu = -1;
+      uint32_t calls = 0;
+    };
+    thread_local Cached cached;
+    if (cached.cpu < 0 || 0 == (++cached.calls & (kRefreshCalls - 1))) {
+      cached.cpu = sched_getcpu();
+    }
+    return nodeOfCpu(cached.cpu);
+  }
+
+  /// @brief 把调用线程绑定到节点的CPU上
+  /// @return 绑定成功返回true
+  bool pin(size_t node) const {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : nodes_[node]) {
+      CPU_SET(cpu, &set);
+    }
+    return 0 == pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+  }
+
+private:
+  // 重新读取所在CPU的间隔，必须是2的幂
+  static constexpr uint32_t kRefreshCalls = 64;
+
+  void addNode(std::vector<int> cpus) {
+    for (int cpu : cpus) {
+      if (static_cast<size_t>(cpu) >= cpuNodes_.size()) {
+        cpuNodes_.resize(cpu + 1, 0);
+      }
+      cpuNodes_[cpu] = static_cast<uint32_t>(nodes_.size());
+    }
+    nodes_.push_back(std::move(cpus));
+  }
+
+  static std::vector<int> allCpus() {
+    std::vector<int> cpus;
+    if (!readList("/sys/devices/system/cpu/online", cpus) || cpus.empty()) {
+      unsigned num = std::max(1u, std::thread::hardware_concurrency());
+      for (unsigned cpu = 0; cpu < num; ++cpu) {
+        cpus.push_back(static_cast<int>(cpu));
+      }
+    }
+    return cpus;
+  }
+
+  // 读取形如"0-3,8-11"的编号列表
+  static bool readList(const char *path, std::vector<int> &items) {
+    std::FILE *file = std::fopen(path, "r");
+    if (nullptr == file) {
+      return false;
+    }
+    char line[4096];
+    bool ok = nullptr != std::fgets(line, sizeof(line), file);
+    std::fclose(file);
+    if (!ok) {
+      return false;
+    }
+    const char *pos = line;
+    while ('\0' != *pos && '\n' != *pos) {
+      char *end = nullptr;
+      long first = std::strtol(pos, &end, 10);
+      if (end == pos || first < 0) {
+        return false;
+      }
+      long last = first;
+      pos = end;
+      if ('-' == *pos) {
+        last = std::strtol(pos + 1, &end, 10);
+        if (end == pos + 1 || last < first) {
+          return false;
+        }
+        pos = end;
+      }
+      for (long item = first; item <= last; ++item) {
+        items.push_back(static_cast<int>(item));
+      }
+      if (',' == *pos) {
+        ++pos;
+      }
+    }
+    return true;
+  }
+
+private:
+  std::vector<std::vector<int>> nodes_; // 各节点的CPU
+  std::vector<uint32_t> cpuNodes_;      // CPU所属的节点
+};
+
+// 关键字的路由方式
+enum class NumaRouting {
+  Partitioned,  // 每个关键字只在归属节点上
+  ReplicateHot, // 另在各节点上复制从其他节点读到的热点
+};
+
+// 一个节点上的线程发起的访问计数
+struct NumaNodeStats {
+  uint64_t localHits = 0;   // 命中本节点的分片
+  uint64_t remoteHits = 0;  // 命中其他节点的分片
+  uint64_t replicaHits = 0; // 命中本节点的热点副本
+  uint64_t misses = 0;      // 未命中
+  LatencyHistogram latency; // 采样的get延迟（纳秒）
+};
+
+template <typename Key, typename Value, typename Shard> class NumaHashCache {
+public:
+  // 关键字到归属节点的路由函数，返回值按节点数取模
+  using Router = std::function<size_t(const Key &)>;
+
+  /// @param capacity 总容量
+  /// @param sliceNum 总分片数，按节点均分，不大于0时取CPU数
+  /// @param routing 路由方式
+  /// @param topology NUMA拓扑
+  NumaHashCache(size_t capacity, int sliceNum,
+                NumaRouting routing = NumaRouting::Partitioned,
+                NumaTopology topology = NumaTopology::detect())
+      : topology_(std::move(topology)), nodeNum_(topology_.nodeCount()),
+        replicate_(NumaRouting::ReplicateHot == routing && nodeNum_ > 1),
+        versions_(new std::atomic<uint64_t>[kStripes]),
+        replicated_(new std::atomic<uint8_t>[kStripes]) {
+    for (size_t idx = 0; idx < kStripes; ++idx) {
+      versions_[idx].store(0, std::memory_order_relaxed);
+      replicated_[idx].store(0, std::memory_order_relaxed);
+    }
+    size_t totalSlices = sliceNum > 0 ? static_cast<size_t>(sliceNum)
+                                      : std::thread::hardware_concurrency();
+    size_t nodeSlices = std::max<size_t>(1, totalSlices / nodeNum_);
+    // 副本的容量从总容量中扣除，各节点的容量向下取整，节点容量之和不超过capacity；
+    // 分片组内部按分片向上取整，每个分片最多多出一个条目
+    size_t replicaCapacity =
+        replicate_ ? std::max<size_t>(1, capacity / (kReplicaShare * nodeNum_)) : 0;
+    size_t homeCapacity =
+        (capacity - std::min(capacity, replicaCapacity * nodeNum_)) / nodeNum_;
+    // 副本容量只有总容量的一小部分，按分片均分后每片只剩几个条目，淘汰近乎随机；
+    // 每个副本分片至少kReplicaSliceEntries个条目，分片数不超过节点的分片数
+    size_t replicaSlices = std::min(
+        nodeSlices, std::max<size_t>(1, replicaCapacity / kReplicaSliceEntries));
+    nodes_.reset(new NodeState[nodeNum_]);
+    for (size_t node = 0; node < nodeNum_; ++node) {
+      buildOn(node, [&, node] {
+        NodeState &state = nodes_[node];
+        state.shard.reset(new Shard(homeCapacity, static_cast<int>(nodeSlices)));
+        if (replicate_) {
+          state.replica.reset(new Shard(replicaCapacity, static_cast<int>(replicaSlices)));
+          state.sketch.reset(new FrequencySketch<Key>(kSketchScale * replicaCapacity));
+        }
+      });
+    }
+  }
+
+  NumaHashCache(const NumaHashCache &) = delete;
+  NumaHashCache &operator=(const NumaHashCache &) = delete;
+
+  /// @brief 设置关键字到归属节点的路由，如把关键字区间固定到某个节点；需在写入任何数据之前调用
+  void setRouter(Router router) { router_ = std::move(router); }
+
+  // 关键字的归属节点，可用于把请求派发到该节点的线程上
+  size_t homeNode(const Key &key) const {
+    if (router_) {
+      return router_(key) % nodeNum_;
+    }
+    uint64_t hash = static_cast<uint64_t>(CacheHash<Key>{}(key));
+    return static_cast<size_t>(((hash >> 32) * nodeNum_) >> 32);
+  }
+
+  size_t nodeCount() const { return nodeNum_; }
+
+  const NumaTopology &topology() const { return topology_; }
+
+  void put(const Key &key, const Value &val) {
+    nodes_[homeNode(key)].shard->put(key, val);
+    invalidate(key);
+  }
+
+  void put(const Key &key, Value &&val) {
+    nodes_[homeNode(key)].shard->put(key, std::move(val));
+    invalidate(key);
+  }
+
+  bool get(const Key &key, Value &val) {
+    size_t node = topology_.currentNode();
+    NodeState &local = nodes_[node];
+    bool sampled = sampleLatency();
+    std::chrono::steady_clock::time_point start;
+    if (sampled) {
+      start = std::chrono::steady_clock::now();
+    }
+    size_t home = homeNode(key);
+    Outcome outcome = Miss;
+    if (home == node || !replicate_) {
+      if (nodes_[home].shard->get(key, val)) {
+        outcome = home == node ? LocalHit : RemoteHit;
+      }
+    } else if (local.replica->get(key, val)) {
+      outcome = ReplicaHit;
+    } else {
+      size_t stripe = stripeOf(key);
+      uint64_t version = versions_[stripe].load(std::memory_order_seq_cst);
+      if (nodes_[home].shard->get(key, val)) {
+        outcome = RemoteHit;
+        replicateIfHot(local, key, val, stripe, version);
+      }
+    }
+    local.counters[counterStripe()].values[outcome].fetch_add(
+        1, std::memory_order_relaxed);
+    if (sampled) {
+      uint64_t ns = static_cast<uint64_t>(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+              std::chrono::steady_clock::now() - start)
+              .count());
+      local.latency[LatencyHistogram::bucketOf(ns)].fetch_add(1, std::memory_order_relaxed);
+    }
+    return Miss != outcome;
+  }
+
+  Value get(const Key &key) {
+    Value val{};
+    get(key, val);
+    return val;
+  }
+
+  // 删除指定缓存，同时使各节点副本中的旧值失效
+  void remove(const Key &key) {
+    nodes_[homeNode(key)].shard->remove(key);
+    invalidate(key);
+  }
+
+  // 各节点分片组的统计之和，不含热点副本
+  CacheStats stats() const {
+    CacheStats total;
+    for (size_t node = 0; node < nodeNum_; ++node) {
+      total += nodes_[node].shard->stats();
+    }
+    return total;
+  }
+
+  /// @brief 节点上的线程发起的访问计数与get延迟直方图
+  NumaNodeStats nodeStats(size_t node) const {
+    NumaNodeStats stats;
+    if (node >= nodeNum_) {
+      return stats;
+    }
+    const NodeState &state = nodes_[node];
+    uint64_t sums[kOutcomeNum] = {};
+    for (const CounterStripe &stripe : state.counters) {
+      for (size_t idx = 0; idx < kOutcomeNum; ++idx) {
+        sums[idx] += stripe.values[idx].load(std::memory_order_relaxed);
+      }
+    }
+    stats.localHits = sums[LocalHit];
+    stats.remoteHits = sums[RemoteHit];
+    stats.replicaHits = sums[ReplicaHit];
+    stats.misses = sums[Miss];
+    for (size_t idx = 0; idx < LatencyHistogram::kBuckets; ++idx) {
+      stats.latency.counts[idx] = state.latency[idx].load(std::memory_order_relaxed);
+    }
+    return stats;
+  }
+
+private:
+  // 版本条带数，必须是2的幂
+  static constexpr size_t kStripes = 4096;
+  // 副本合计占总容量的比例的倒数
+  static constexpr size_t kReplicaShare = 16;
+  // 副本每个分片的最少条目数
+  static constexpr size_t kReplicaSliceEntries = 256;
+  // 频次估计的计数器数量相对副本容量的倍数
+  static constexpr size_t kSketchScale = 8;
+  // 复制到副本所需的估计频次
+  static constexpr uint32_t kHotFrequency = 3;
+  // get延迟的采样间隔，必须是2的幂
+  static constexpr uint32_t kLatencySampleRate = 64;
+  // 每个节点的计数器条带数
+  static constexpr size_t kCounterStripes = 8;
+
+  // get的结果，作为计数器下标
+  enum Outcome : uint32_t {
+    LocalHit,
+    RemoteHit,
+    ReplicaHit,
+    Miss,
+    kOutcomeNum,
+  };
+
+  // 同一节点上的线程分散到不同缓存行上计数
+  struct alignas(64) CounterStripe {
+    std::atomic<uint64_t> values[kOutcomeNum] = {};
+  };
+
+  struct alignas(64) NodeState {
+    std::unique_ptr<Shard> shard;   // 归属本节点的关键字
+    std::unique_ptr<Shard> replica; // 其他节点热点的副本，未开启复制时为空
+    std::unique_ptr<FrequencySketch<Key>> sketch; // 跨节点读取的频次估计
+    std::mutex sketchMutex;         // 保护sketch，争用时跳过这次计数
+    CounterStripe counters[kCounterStripes]; // 本节点线程发起的访问计数
+    std::atomic<uint64_t> latency[LatencyHistogram::kBuckets] = {}; // get延迟直方图
+  };
+
+  // 在绑定到节点CPU上的线程中执行构造，内存按首次访问分配在该节点上
+  template <typename F> void buildOn(size_t node, F &&build) {
+    std::thread builder([this, node, &build] {
+      topology_.pin(node); // 受cpuset限制无法绑定时仍然构造，只是不保证本地
+      build();
+    });
+    builder.join();
+  }
+
+  size_t stripeOf(const Key &key) const {
+    return static_cast<size_t>(CacheHash<Key>{}(key)) & (kStripes - 1);
+  }
+
+  // 跨节点读到的条目频次达到阈值时复制到本节点；复制期间有写入则撤回副本
+  void replicateIfHot(NodeState &local, const Key &key, const Value &val,
+                      size_t stripe, uint64_t version) {
+    std::unique_lock<std::mutex> lock(local.sketchMutex, std::try_to_lock);
+    if (!lock.owns_lock()) {
+      return;
+    }
+    local.sketch->increment(key);
+    if (local.sketch->frequency(key) < kHotFrequency) {
+      return;
+    }
+    lock.unlock();
+    replicated_[stripe].store(1, std::memory_order_seq_cst);
+    local.replica->put(key, val);
+    if (versions_[stripe].load(std::memory_order_seq_cst) != version) {
+      local.replica->remove(key);
+    }
+  }
+
+  // 写入归属节点之后调用，递增条带版本并删除各节点副本中的旧值
+  void invalidate(const Key &key) {
+    if (!replicate_) {
+      return;
+    }
+    size_t stripe = stripeOf(key);
+    versions_[stripe].fetch_add(1, std::memory_order_seq_cst);
+    if (0 == replicated_[stripe].load(std::memory_order_seq_cst)) {
+      return;
+    }
+    for (size_t node = 0; node < nodeNum_; ++node) {
+      nodes_[node].replica->remove(key);
+    }
+  }
+
+  // 每个线程固定使用一个计数器条带，按线程首次计数的顺序轮流分配
+  static size_t counterStripe() {
+    static std::atomic<size_t> nextStripe{0};
+    thread_local size_t stripe =
+        nextStripe.fetch_add(1, std::memory_order_relaxed) % kCounterStripes;
+    return stripe;
+  }
+
+  static bool sampleLatency() {
+    thread_local uint32_t calls = 0;
+    return 0 == (++calls & (kLatencySampleRate - 1));
+  }
+
+private:
+  NumaTopology topology_;                         // NUMA拓扑
+  size_t nodeNum_;                                // 节点数
+  bool replicate_;                                // 是否复制热点
+  Router router_;                                 // 自定义路由，为空时按哈希均分
+  std::unique_ptr<NodeState[]> nodes_;            // 各节点的分片组与计数
+  std::unique_ptr<std::atomic<uint64_t>[]> versions_; // 条带版本
+  std::unique_ptr<std::atomic<uint8_t>[]> replicated_; // 条带上是否复制过条目，只置位不清除
+};
+
+} // namespace CacheMgr
\ No newline at end of file
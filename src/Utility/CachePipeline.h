@@ -0,0 +1,498 @@
+/*
+PipelinedCache:
+在分片缓存之上的两条后台流水线，降低写多读多服务的尾延迟：
+    1. 提前刷新（refresh-ahead）：缓存值带有刷新时刻与到期时刻，读取时已过刷新时刻的条目
+       交给有界的工作线程池在后台重新加载，读取继续返回旧值；
+       markStale可以立即安排刷新；线程池队列已满时放弃本次刷新，条目到期后按未命中处理
+    2. 写回（write-behind）：put写入缓存的同时把条目记入脏表，后台线程按批调用writer写回后端，
+       同一关键字在写回前的多次写入只写回最后一次；被淘汰的脏条目仍留在脏表中等待写回，
+       淘汰不需要同步写后端，未命中时先查脏表，保证读到自己的写入
+    3. 脏表按关键字哈希分为16个条带，写入只锁一个条带；脏条目超过上限时put等待写回（背压）
+    4. 后台刷新与getOrLoad的加载结果都在条带锁内确认关键字没有待写回的新值后才写入缓存，
+       避免旧值覆盖新写入
+    5. getOrLoad把已到期的条目按未命中处理，同一关键字上并发的未命中（包括到期后的第一批读取）
+       由本层的单飞表合并为一次加载
+底层缓存存放StampedValue<Value>，需支持get与put，如LRUHashCache、LFUHashCache。析构时先停止刷新线程池，再把剩余的脏条目全部写回。
+*/
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "CacheFlatMap.h"
+#include "CacheHash.h"
+#include "CacheLoader.h"
+#include "CacheStats.h"
+#include "CacheTimerWheel.h"
+
+namespace CacheMgr {
+
+// 带刷新时刻与到期时刻的缓存值，时刻为TimerWheel::now()的毫秒刻度
+template <typename Value> struct StampedValue {
+  Value value{};                     // 缓存值
+  uint64_t refreshAt = UINT64_MAX;   // 之后的读取触发后台刷新
+  uint64_t expireAt = UINT64_MAX;    // 之后不再命中
+};
+
+// 固定线程数、有界队列的工作线程池，队列满时拒绝新任务而不是阻塞提交者
+class CacheWorkerPool {
+public:
+  CacheWorkerPool(size_t threadNum, size_t queueCapacity)
+      : queueCapacity_(std::max<size_t>(1, queueCapacity)), stopped_(false) {
+    for (size_t idx = 0; idx < std::max<size_t>(1, threadNum); ++idx) {
+      workers_.emplace_back([this] { run(); });
+    }
+  }
+
+  CacheWorkerPool(const CacheWorkerPool &) = delete;
+  CacheWorkerPool &operator=(const CacheWorkerPool &) = delete;
+
+  ~CacheWorkerPool() { shutdown(); }
+
+  // 提交任务，队列已满或已停止时返回false
+  bool trySubmit(std::function<void()> task) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (stopped_ || tasks_.size() >= queueCapacity_) {
+        return false;
+      }
+      tasks_.push_back(std::move(task));
+    }
+    cond_.notify_one();
+    return true;
+  }
+
+  // 停止接收任务，丢弃尚未开始的任务并等待执行中的任务结束
+  void shutdown() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (stopped_) {
+        return;
+      }
+      stopped_ = true;
+      tasks_.clear();
+    }
+    cond_.notify_all();
+    for (std::thread &worker : workers_) {
+      worker.join();
+    }
+  }
+
+private:
+  void run() {
+    while (true) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cond_.wait(lock, [this] { return stopped_ || !tasks_.empty(); });
+        if (stopped_) {
+          return;
+        }
+        task = std::move(tasks_.front());
+        tasks_.pop_front();
+      }
+      task();
+    }
+  }
+
+private:
+  size_t queueCapacity_;                    // 队列容量
+  bool stopped_;                            // 是否已停止
+  std::deque<std::function<void()>> tasks_; // 等待执行的任务
+  std::mutex mutex_;                        // 保护任务队列
+  std::condition_variable cond_;            // 通知工作线程
+  std::vector<std::thread> workers_;        // 工作线程
+};
+
+template <typename Key, typename Value> struct PipelineOptions {
+  // 写入后的存活时间，为0时永不到期，也不提前刷新
+  std::chrono::milliseconds ttl{0};
+  // 存活时间过去该比例后，读取触发后台刷新
+  double refreshAhead = 0.8;
+  // 刷新线程数与刷新队列容量
+  size_t refreshThreads = 2;
+  size_t refreshQueue = 1024;
+  // 加载函数，用于未命中加载与后台刷新；为空时不刷新
+  std::function<Value(const Key &)> loader;
+  // 批量写回函数，为空时不启用写回；抛出异常时这一批在下次写回时重试
+  std::function<void(const std::vector<std::pair<Key, Value>> &)> writer;
+  // 每次调用writer的最大条目数
+  size_t flushBatch = 256;
+  // 写回的最长间隔
+  std::chrono::milliseconds flushInterval{10};
+  // 脏条目上限，超过后put等待写回
+  size_t maxDirty = 65536;
+};
+
+// 流水线自身的计数
+struct PipelineStats {
+  uint64_t refreshes = 0;       // 完成的后台刷新
+  uint64_t refreshFailures = 0; // 加载函数抛出异常的刷新
+  uint64_t refreshDropped = 0;  // 队列已满而放弃的刷新
+  uint64_t flushedEntries = 0;  // 写回的条目数
+  uint64_t flushBatches = 0;    // writer的调用次数
+  uint64_t flushFailures = 0;   // writer抛出异常的次数
+  uint64_t writeStalls = 0;     // 因脏条目超过上限而等待的put次数
+};
+
+template <typename Key, typename Value, typename Cache>
+class PipelinedCache {
+public:
+  using Entry = StampedValue<Value>;
+  using Options = PipelineOptions<Key, Value>;
+  using Batch = std::vector<std::pair<Key, Value>>;
+
+  /// @param options 刷新与写回的配置
+  /// @param cacheArgs 底层缓存的构造参数
+  template <typename... Args>
+  explicit PipelinedCache(Options options, Args &&...cacheArgs)
+      : options_(std::move(options)), cache_(std::forward<Args>(cacheArgs)...),
+        dirtyNum_(0),
+        refreshPool_(options_.refreshThreads, options_.refreshQueue),
+        stopping_(false), flushRequested_(0), flushDone_(0) {
+    if (options_.writer) {
+      flusher_ = std::thread([this] { flushLoop(); });
+    }
+  }
+
+  PipelinedCache(const PipelinedCache &) = delete;
+  PipelinedCache &operator=(const PipelinedCache &) = delete;
+
+  ~PipelinedCache() {
+    refreshPool_.shutdown();
+    if (flusher_.joinable()) {
+      {
+        std::lock_guard<std::mutex> lock(flushMutex_);
+        stopping_ = true;
+      }
+      flushCond_.notify_all();
+      flusher_.join();
+    }
+  }
+
+  // 写入缓存；启用写回时同时记入脏表，由后台线程写回后端
+  void put(const Key &key, const Value &val) {
+    if (!options_.writer) {
+      cache_.put(key, stamp(val));
+      return;
+    }
+    waitForRoom();
+    DirtyStripe &stripe = stripeOf(key);
+    {
+      std::lock_guard<std::mutex> lock(stripe.mutex);
+      cache_.put(key, stamp(val));
+      auto result = stripe.dirty.try_emplace(key, val);
+      if (!result.second) {
+        result.first->second = val; // 写回前的多次写入只保留最后一次
+      } else {
+        dirtyNum_.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+    if (dirtyNum_.load(std::memory_order_relaxed) >= options_.flushBatch) {
+      flushCond_.notify_one();
+    }
+  }
+
+  /// @brief 访问缓存，过了刷新时刻的条目安排后台刷新并返回旧值
+  /// @return 访问结果，命中缓存或命中待写回的脏条目时返回true
+  bool get(const Key &key, Value &val) {
+    Entry entry;
+    uint64_t now = TimerWheel<Key>::now();
+    if (cache_.get(key, entry) && now < entry.expireAt) {
+      if (now >= entry.refreshAt) {
+        scheduleRefresh(key);
+      }
+      val = std::move(entry.value);
+      return true;
+    }
+    return options_.writer && findDirty(key, val);
+  }
+
+  Value get(const Key &key) {
+    Value val{};
+    get(key, val);
+    return val;
+  }
+
+  // 访问缓存，未命中或已到期时用loader同步加载，同一关键字上并发的未命中只加载一次
+  Value getOrLoad(const Key &key) {
+    Value val;
+    if (get(key, val)) {
+      return val;
+    }
+    std::promise<Value> promise;
+    std::shared_future<Value> pending;
+    if (!loads_.join(key, pending, promise)) {
+      return pending.get();
+    }
+    try {
+      // 登记之前可能恰好有一次加载刚刚完成，再次查找不计入统计
+      bool found;
+      {
+        UncountedLookup uncounted;
+        found = get(key, val);
+      }
+      if (!found) {
+        Entry entry = stamp(options_.loader(key));
+        installLoaded(key, entry);
+        val = std::move(entry.value);
+      }
+      promise.set_value(val);
+    } catch (...) {
+      promise.set_exception(std::current_exception());
+      loads_.finish(key);
+      throw;
+    }
+    loads_.finish(key);
+    return val;
+  }
+
+  // 标记条目已过时，立即安排后台刷新，刷新完成前读取仍返回旧值
+  void markStale(const Key &key) { scheduleRefresh(key); }
+
+  // 等待调用前写入的脏条目全部写回（或写回失败）
+  void flush() {
+    if (!options_.writer) {
+      return;
+    }
+    std::unique_lock<std::mutex> lock(flushMutex_);
+    uint64_t target = ++flushRequested_;
+    flushCond_.notify_all();
+    flushCond_.wait(lock, [this, target] { return flushDone_ >= target; });
+  }
+
+  // 尚未写回的脏条目数
+  size_t dirtyCount() const { return dirtyNum_.load(std::memory_order_relaxed); }
+
+  // 底层缓存的运行统计
+  CacheStats stats() const { return cache_.stats(); }
+
+  PipelineStats pipelineStats() const {
+    PipelineStats stats;
+    stats.refreshes = refreshes_.load(std::memory_order_relaxed);
+    stats.refreshFailures = refreshFailures_.load(std::memory_order_relaxed);
+    stats.refreshDropped = refreshDropped_.load(std::memory_order_relaxed);
+    stats.flushedEntries = flushedEntries_.load(std::memory_order_relaxed);
+    stats.flushBatches = flushBatches_.load(std::memory_order_relaxed);
+    stats.flushFailures = flushFailures_.load(std::memory_order_relaxed);
+    stats.writeStalls = writeStalls_.load(std::memory_order_relaxed);
+    return stats;
+  }
+
+  // 底层缓存，用于调用其特有的接口；直接写入的条目不会写回
+  Cache &cache() { return cache_; }
+
+private:
+  // 脏表条带数，必须是2的幂
+  static constexpr size_t kStripes = 16;
+
+  struct alignas(64) DirtyStripe {
+    std::mutex mutex;                  // 保护本条带
+    CacheIndexMap<Key, Value> dirty;   // 等待写回的条目
+    CacheIndexMap<Key, Value> flushing; // 正在写回的条目，写回完成前仍可读取
+  };
+
+  DirtyStripe &stripeOf(const Key &key) {
+    // 取中间的位选条带：ShardedCache与ElasticSlices都按CacheHash的高位选分片，
+    // 与之不相关，一个分片的关键字分散到所有条带上
+    return stripes_[(CacheHash<Key>{}(key) >> 32) & (kStripes - 1)];
+  }
+
+  Entry stamp(Value val) const {
+    Entry entry;
+    entry.value = std::move(val);
+    if (options_.ttl.count() > 0) {
+      uint64_t now = TimerWheel<Key>::now();
+      uint64_t ttl = static_cast<uint64_t>(options_.ttl.count());
+      entry.expireAt = now + ttl;
+      entry.refreshAt = now + static_cast<uint64_t>(ttl * options_.refreshAhead);
+    }
+    return entry;
+  }
+
+  bool findDirty(const Key &key, Value &val) {
+    DirtyStripe &stripe = stripeOf(key);
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    auto it = stripe.dirty.find(key);
+    if (it == stripe.dirty.end()) {
+      it = stripe.flushing.find(key);
+      if (it == stripe.flushing.end()) {
+        return false;
+      }
+    }
+    val = it->second;
+    return true;
+  }
+
+  // 加载得到的新值只在关键字没有待写回的新写入时写入缓存
+  void installLoaded(const Key &key, const Entry &entry) {
+    if (!options_.writer) {
+      cache_.put(key, entry);
+      return;
+    }
+    DirtyStripe &stripe = stripeOf(key);
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    if (0 == stripe.dirty.count(key) && 0 == stripe.flushing.count(key)) {
+      cache_.put(key, entry);
+    }
+  }
+
+  void scheduleRefresh(const Key &key) {
+    if (!options_.loader) {
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(refreshMutex_);
+      if (!refreshing_.insert(key).second) {
+        return; // 已有刷新在进行
+      }
+    }
+    bool submitted = refreshPool_.trySubmit([this, key] {
+      try {
+        installLoaded(key, stamp(options_.loader(key)));
+        refreshes_.fetch_add(1, std::memory_order_relaxed);
+      } catch (...) {
+        refreshFailures_.fetch_add(1, std::memory_order_relaxed); // 保留旧值直到到期
+      }
+      std::lock_guard<std::mutex> lock(refreshMutex_);
+      refreshing_.erase(key);
+    });
+    if (!submitted) {
+      refreshDropped_.fetch_add(1, std::memory_order_relaxed);
+      std::lock_guard<std::mutex> lock(refreshMutex_);
+      refreshing_.erase(key);
+    }
+  }
+
+  // 脏条目超过上限时唤醒写回线程并等待
+  void waitForRoom() {
+    if (dirtyNum_.load(std::memory_order_relaxed) < options_.maxDirty) {
+      return;
+    }
+    writeStalls_.fetch_add(1, std::memory_order_relaxed);
+    std::unique_lock<std::mutex> lock(flushMutex_);
+    uint64_t target = ++flushRequested_;
+    flushCond_.notify_all();
+    flushCond_.wait(lock, [this, target] {
+      return flushDone_ >= target ||
+             dirtyNum_.load(std::memory_order_relaxed) < options_.maxDirty;
+    });
+  }
+
+  void flushLoop() {
+    std::unique_lock<std::mutex> lock(flushMutex_);
+    while (true) {
+      flushCond_.wait_for(lock, options_.flushInterval, [this] {
+        return stopping_ || flushRequested_ > flushDone_ ||
+               dirtyNum_.load(std::memory_order_relaxed) >= options_.flushBatch;
+      });
+      bool stopping = stopping_;
+      uint64_t target = flushRequested_;
+      lock.unlock();
+      bool written = flushAll();
+      lock.lock();
+      flushDone_ = std::max(flushDone_, target);
+      flushCond_.notify_all();
+      if (stopping) {
+        return; // 最后一次写回失败的条目随之丢弃
+      }
+      if (!written) {
+        // 后端失败时等满一个间隔再重试，不空转
+        flushCond_.wait_for(lock, options_.flushInterval,
+                            [this] { return stopping_; });
+      }
+    }
+  }
+
+  // 逐个条带取出脏条目写回，写回期间条目移入flushing以便读取；有写回失败时返回false
+  bool flushAll() {
+    Batch batch;
+    bool allWritten = true;
+    for (DirtyStripe &stripe : stripes_) {
+      {
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        if (stripe.dirty.empty()) {
+          continue;
+        }
+        stripe.flushing.swap(stripe.dirty);
+      }
+      for (auto &entry : stripe.flushing) {
+        batch.emplace_back(entry.first, entry.second);
+      }
+      bool written = writeBatches(batch);
+      batch.clear();
+      std::lock_guard<std::mutex> lock(stripe.mutex);
+      size_t finished = stripe.flushing.size();
+      if (!written) {
+        // 写回失败的条目放回脏表重试，期间已有新写入的只保留新值
+        finished = 0;
+        for (auto &entry : stripe.flushing) {
+          if (!stripe.dirty.try_emplace(entry.first, entry.second).second) {
+            ++finished;
+          }
+        }
+        allWritten = false;
+      }
+      stripe.flushing.clear();
+      dirtyNum_.fetch_sub(finished, std::memory_order_relaxed);
+    }
+    return allWritten;
+  }
+
+  bool writeBatches(const Batch &batch) {
+    for (size_t begin = 0; begin < batch.size(); begin += options_.flushBatch) {
+      size_t end = std::min(batch.size(), begin + options_.flushBatch);
+      try {
+        if (0 == begin && end == batch.size()) {
+          options_.writer(batch);
+        } else {
+          options_.writer(Batch(batch.begin() + begin, batch.begin() + end));
+        }
+      } catch (...) {
+        flushFailures_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      }
+      flushBatches_.fetch_add(1, std::memory_order_relaxed);
+      flushedEntries_.fetch_add(end - begin, std::memory_order_relaxed);
+    }
+    return true;
+  }
+
+private:
+  Options options_;                            // 刷新与写回的配置
+  Cache cache_;                                // 底层缓存
+  DirtyStripe stripes_[kStripes];              // 脏表条带
+  std::atomic<size_t> dirtyNum_;               // 脏条目总数
+  std::mutex refreshMutex_;                    // 保护refreshing_
+  std::unordered_set<Key, CacheHash<Key>> refreshing_; // 正在刷新的关键字
+  CacheWorkerPool refreshPool_;                // 刷新线程池
+  std::mutex flushMutex_;                      // 保护以下写回状态
+  std::condition_variable flushCond_;          // 唤醒写回线程与等待者
+  bool stopping_;                              // 析构中，写回线程做最后一次写回后退出
+  uint64_t flushRequested_;                    // 请求写回的次数
+  uint64_t flushDone_;                         // 已完成的写回请求
+  std::thread flusher_;                        // 写回线程
+  LoadTable<Key, Value> loads_;                // getOrLoad进行中的加载
+  std::atomic<uint64_t> refreshes_{0};
+  std::atomic<uint64_t> refreshFailures_{0};
+  std::atomic<uint64_t> refreshDropped_{0};
+  std::atomic<uint64_t> flushedEntries_{0};
+  std::atomic<uint64_t> flushBatches_{0};
+  std::atomic<uint64_t> flushFailures_{0};
+  std::atomic<uint64_t> writeStalls_{0};
+};
+
+} // namespace CacheMgr
\ No newline at end of file
@@ -0,0 +1,279 @@
+/*
+ShardedCache:
+通用的哈希分片包装，分片可以是任意CacheBase实现（LRU、LFU、ARC、LRU-K、CLOCK等）：
+    1. 分片数向上取整为2的幂，定位分片只需一次移位，不再对分片数取模
+    2. 分片下标取CacheHash（std::hash之上的64位混合）的高位，
+       避免整数关键字的恒等哈希让分片倾斜；
+       分片内部的FlatMap使用哈希低位，两者互不相关
+    3. 总容量按分片数均分（向上取整），各分片独立加锁，不同分片上的操作完全并行
+    4. 批量操作先计算全部关键字的分片并按分片分组，每个分片整批处理、只加一次锁
+分片的构造方式通过工厂函数定制，默认以分片容量调用Shard的单参数构造函数。
+启用未命中率曲线后，读请求复用定位分片时算出的哈希值做采样判断。
+*/
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "CacheBase.h"
+#include "CacheBatch.h"
+#include "CacheHash.h"
+#include "CacheMRC.h"
+#include "CacheSnapshot.h"
+#include "CacheWeight.h"
+
+namespace CacheMgr {
+
+template <typename Key, typename Value, typename Shard,
+          typename Hash = CacheHash<Key>>
+class ShardedCache : public CacheBase<Key, Value> {
+public:
+  using typename CacheBase<Key, Value>::Loader;
+
+  // 按分片容量构造一个分片
+  using ShardFactory = std::function<std::unique_ptr<Shard>(size_t)>;
+
+  // shardNum不大于0时取硬件线程数，实际分片数向上取整为2的幂
+  explicit ShardedCache(size_t capacity, int shardNum)
+      : ShardedCache(capacity, shardNum, [](size_t shardCapacity) {
+          return std::unique_ptr<Shard>(new Shard(shardCapacity));
+        }) {}
+
+  explicit ShardedCache(size_t capacity, int shardNum,
+                        const ShardFactory &factory)
+      : capacity_(capacity), weighted_(false), shardShift_(64) {
+    size_t count = roundShardCount(shardNum);
+    for (size_t bits = count; bits > 1; bits >>= 1) {
+      --shardShift_;
+    }
+    size_t shardCapacity = (capacity_ + count - 1) / count;
+    shards_.reserve(count);
+    for (size_t idx = 0; idx < count; ++idx) {
+      shards_.emplace_back(factory(shardCapacity));
+    }
+  }
+
+  // 按权重计容量：总权重预算按分片数均分，分片以(分片预算, weigher)构造
+  explicit ShardedCache(size_t maxWeight, int shardNum,
+                        const CacheWeigher<Key, Value> &weigher)
+      : ShardedCache(maxWeight, shardNum, [weigher](size_t shardWeight) {
+          return std::unique_ptr<Shard>(new Shard(shardWeight, weigher));
+        }) {
+    weighted_ = true;
+  }
+
+  ~ShardedCache() override = default;
+
+  void put(const Key &key, const Value &val) override {
+    shardOf(key).put(key, val);
+  }
+
+  void put(const Key &key, Value &&val) override {
+    shardOf(key).put(key, std::move(val));
+  }
+
+  // 带存活时间的写入，分片需支持put(key, val, ttl)
+  void put(const Key &key, const Value &val, std::chrono::milliseconds ttl) {
+    shardOf(key).put(key, val, ttl);
+  }
+
+  void put(const Key &key, Value &&val, std::chrono::milliseconds ttl) {
+    shardOf(key).put(key, std::move(val), ttl);
+  }
+
+  bool get(const Key &key, Value &val) override {
+    return readShardOf(key).get(key, val);
+  }
+
+  // visitor在分片的锁内执行
+  bool visit(const Key &key,
+             const std::function<void(const Value &)> &visitor) override {
+    return readShardOf(key).visit(key, visitor);
+  }
+
+  // 未命中时的行为与分片一致
+  Value get(const Key &key) override { return readShardOf(key).get(key); }
+
+  // 每个分片各自合并并发的未命中，不同分片上的加载互不等待
+  Value getOrLoad(const Key &key, const Loader &loader) override {
+    return readShardOf(key).getOrLoad(key, loader);
+  }
+
+  std::shared_future<Value> getOrLoadAsync(const Key &key,
+                                           Loader loader) override {
+    return readShardOf(key).getOrLoadAsync(key, std::move(loader));
+  }
+
+  void putBatch(const Key *keys, const Value *vals, const uint32_t *order,
+                size_t count) override {
+    std::vector<uint32_t> grouped;
+    std::vector<uint32_t> offsets;
+    groupKeys(keys, order, count, grouped, offsets);
+    for (size_t idx = 0; idx < shards_.size(); ++idx) {
+      if (offsets[idx] != offsets[idx + 1]) {
+        shards_[idx]->putBatch(keys, vals, grouped.data() + offsets[idx],
+                               offsets[idx + 1] - offsets[idx]);
+      }
+    }
+  }
+
+  size_t getBatch(const Key *keys, const uint32_t *order, size_t count,
+                  Value *vals, bool *hits) override {
+    if (nullptr != monitor_) {
+      for (size_t i = 0; i < count; ++i) {
+        monitor_->access(keys[detail::batchIndex(order, i)]);
+      }
+    }
+    std::vector<uint32_t> grouped;
+    std::vector<uint32_t> offsets;
+    groupKeys(keys, order, count, grouped, offsets);
+    size_t hitNum = 0;
+    for (size_t idx = 0; idx < shards_.size(); ++idx) {
+      if (offsets[idx] != offsets[idx + 1]) {
+        hitNum += shards_[idx]->getBatch(keys, grouped.data() + offsets[idx],
+                                         offsets[idx + 1] - offsets[idx],
+                                         vals, hits);
+      }
+    }
+    return hitNum;
+  }
+
+  // 逐个分片清理已到期的缓存
+  void purgeExpired() {
+    for (auto &shard : shards_) {
+      shard->purgeExpired();
+    }
+  }
+
+  /// @brief 把各分片的缓存写入快照文件，逐个分片在分片锁内复制，锁外写文件，不停止读写
+  /// @param path 快照文件路径
+  /// @return 写入成功返回true
+  bool saveSnapshot(const std::string &path) {
+    return SnapshotFile<Key, Value>::save(
+        path, Shard::kSnapshotPolicy, shards_.size(),
+        [this](size_t idx) { return shards_[idx]->snapshot(); });
+  }
+
+  /// @brief 从快照文件恢复，条目按当前的分片规则重新分组，每个分片一次加锁批量写入；
+  ///        用于启动时的空缓存，已有的关键字保留现值
+  /// @return 快照完整、校验通过且策略一致时返回true
+  bool loadSnapshot(const std::string &path) {
+    std::vector<SnapshotShard<Key, Value>> grouped(shards_.size());
+    bool ok = SnapshotFile<Key, Value>::load(
+        path, Shard::kSnapshotPolicy, [&](SnapshotShard<Key, Value> &&shard) {
+          for (auto &entry : shard) {
+            grouped[shardIndex(entry.key)].push_back(std::move(entry));
+          }
+        });
+    if (!ok) {
+      return false;
+    }
+    for (size_t idx = 0; idx < shards_.size(); ++idx) {
+      shards_[idx]->restore(std::move(grouped[idx]));
+    }
+    return true;
+  }
+
+  // 各分片统计之和；单个分片的统计通过shard(idx).stats()读取
+  CacheStats stats() const override {
+    CacheStats total;
+    for (const auto &shard : shards_) {
+      total += shard->stats();
+    }
+    return total;
+  }
+
+  // 实际使用的分片数：不大于0时取硬件线程数，再向上取整为2的幂
+  static size_t roundShardCount(int shardNum) {
+    size_t wanted = shardNum > 0 ? static_cast<size_t>(shardNum)
+                                 : std::thread::hardware_concurrency();
+    size_t count = 1;
+    while (count < wanted) {
+      count <<= 1;
+    }
+    return count;
+  }
+
+  // 分片数量
+  size_t shardCount() const { return shards_.size(); }
+
+  // 关键字所在的分片下标
+  size_t shardIndex(const Key &key) const { return shardIndexOf(Hash{}(key)); }
+
+  /// @brief 开启未命中率曲线估计，需在并发访问开始之前调用
+  /// @param maxCapacity 曲线覆盖的最大容量（条目数），为0时取当前容量的4倍；
+  ///        按权重计容量时无法由权重预算推算条目数，必须给出，为0时不开启
+  /// @param sampleRate 读请求的采样率
+  void enableMissRatioCurve(size_t maxCapacity = 0, double sampleRate = 0.001) {
+    if (weighted_ && 0 == maxCapacity) {
+      return;
+    }
+    monitor_.reset(new MissRatioMonitor<Key, Hash>(
+        0 != maxCapacity ? maxCapacity : 4 * capacity_, sampleRate));
+    CacheStats total = stats();
+    monitorBase_ = total.hits + total.misses;
+  }
+
+  // 估计的未命中率-容量曲线，未开启时为空；以开启之后分片统计的读请求数修正采样偏差
+  MissRatioCurve missRatioCurve() const {
+    if (nullptr == monitor_) {
+      return MissRatioCurve();
+    }
+    CacheStats total = stats();
+    return monitor_->curve(total.hits + total.misses - monitorBase_);
+  }
+
+  // 访问指定分片，用于调用分片特有的接口
+  Shard &shard(size_t idx) { return *shards_[idx]; }
+
+private:
+  Shard &shardOf(const Key &key) { return *shards_[shardIndex(key)]; }
+
+  // 读请求定位分片，同时交给未命中率监视器采样
+  Shard &readShardOf(const Key &key) {
+    size_t hash = Hash{}(key);
+    if (nullptr != monitor_) {
+      monitor_->access(key, hash);
+    }
+    return *shards_[shardIndexOf(hash)];
+  }
+
+  size_t shardIndexOf(size_t hash) const {
+    if (64 == shardShift_) {
+      return 0;
+    }
+    return static_cast<size_t>(static_cast<uint64_t>(hash) >> shardShift_);
+  }
+
+  void groupKeys(const Key *keys, const uint32_t *order, size_t count,
+                 std::vector<uint32_t> &grouped,
+                 std::vector<uint32_t> &offsets) const {
+    detail::groupByShard(
+        order, count, shards_.size(),
+        [this, keys](size_t idx) { return shardIndex(keys[idx]); }, grouped,
+        offsets);
+  }
+
+private:
+  // 总容量（按权重计容量时为总权重预算）
+  size_t capacity_;
+  // 是否按权重计容量
+  bool weighted_;
+  // 分片下标对应哈希值的右移位数，单分片时为64
+  unsigned shardShift_;
+  // 分片缓存
+  std::vector<std::unique_ptr<Shard>> shards_;
+  // 未命中率曲线监视器，未开启时为空
+  std::unique_ptr<MissRatioMonitor<Key, Hash>> monitor_;
+  // 开启曲线估计时的累计读请求数
+  uint64_t monitorBase_ = 0;
+};
+
+} // namespace CacheMgr
\ No newline at end of file
@@ -0,0 +1,136 @@
+/*
+FrequencySketch:
+估计关键字近期访问频次的Count-Min Sketch，每个计数器只占4位（上限15）：
+    1. 计数器按16个一组压缩在uint64_t中，表长取不小于容量的2的幂
+    2. 每个关键字在4个不同的字中各取一个计数器，4个计数器位于字内不同的半字节，
+       自增时全部加1，估计值取其中最小者
+    3. 累计自增次数达到采样窗口（容量的10倍）后，所有计数器减半，
+       使频次只反映近期的访问，旧热点随时间衰减
+每个关键字的历史开销摊下来只有几个比特，适合作为准入过滤器判断“新来者是否比淘汰者更热”。
+本类不加锁，由外层缓存负责同步。
+*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "CacheHash.h"
+
+namespace CacheMgr {
+
+namespace detail {
+
+// 为1的位数
+inline unsigned popCount(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+  return static_cast<unsigned>(__builtin_popcountll(value));
+#else
+  unsigned count = 0;
+  for (; 0 != value; value &= value - 1) {
+    ++count;
+  }
+  return count;
+#endif
+}
+
+} // namespace detail
+
+template <typename Key, typename Hash = CacheHash<Key>> class FrequencySketch {
+public:
+  explicit FrequencySketch(size_t capacity) : tableMask_(0), size_(0) {
+    size_t tableSize = 1;
+    while (tableSize < capacity) {
+      tableSize <<= 1;
+    }
+    table_.assign(tableSize, 0);
+    tableMask_ = tableSize - 1;
+    sampleSize_ = 10 * (capacity > 0 ? capacity : 1);
+  }
+
+  // 估计关键字的访问频次，取值范围[0, 15]
+  uint32_t frequency(const Key &key) const {
+    uint64_t hash = hashOf(key);
+    uint32_t start = static_cast<uint32_t>(hash & 3) << 2;
+    uint32_t freq = kMaxCounter;
+    for (uint32_t depth = 0; depth < kDepth; ++depth) {
+      uint64_t word = table_[indexOf(hash, depth)];
+      uint32_t count =
+          static_cast<uint32_t>(word >> ((start + depth) << 2)) & kMaxCounter;
+      freq = count < freq ? count : freq;
+    }
+    return freq;
+  }
+
+  // 记录一次访问，达到采样窗口时整体减半
+  void increment(const Key &key) {
+    uint64_t hash = hashOf(key);
+    uint32_t start = static_cast<uint32_t>(hash & 3) << 2;
+    bool added = false;
+    for (uint32_t depth = 0; depth < kDepth; ++depth) {
+      added |= incrementAt(indexOf(hash, depth), start + depth);
+    }
+    if (added && ++size_ >= sampleSize_) {
+      reset();
+    }
+  }
+
+  // 清空所有计数器
+  void clear() {
+    table_.assign(table_.size(), 0);
+    size_ = 0;
+  }
+
+private:
+  // 每个关键字占用的计数器数量
+  static constexpr uint32_t kDepth = 4;
+  // 4位计数器的上限
+  static constexpr uint32_t kMaxCounter = 15;
+  // 每个半字节的最低位
+  static constexpr uint64_t kOneMask = 0x1111111111111111ull;
+  // 每个半字节右移一位后保留的低3位
+  static constexpr uint64_t kResetMask = 0x7777777777777777ull;
+
+  uint64_t hashOf(const Key &key) const {
+    return static_cast<uint64_t>(Hash{}(key));
+  }
+
+  // 第depth行使用的字下标，不同行使用不同的种子重新打散
+  size_t indexOf(uint64_t hash, uint32_t depth) const {
+    static constexpr uint64_t kSeeds[kDepth] = {
+        0xC3A5C85C97CB3127ull, 0xB492B66FBE98F273ull, 0x9AE16A3B2F90404Full,
+        0xCBF29CE484222325ull};
+    uint64_t h = (hash + kSeeds[depth]) * kSeeds[depth];
+    h += h >> 32;
+    return static_cast<size_t>(h) & tableMask_;
+  }
+
+  // 第index个字中第nibble个计数器加1，已达上限时返回false
+  bool incrementAt(size_t index, uint32_t nibble) {
+    uint32_t shift = nibble << 2;
+    uint64_t mask = static_cast<uint64_t>(kMaxCounter) << shift;
+    if ((table_[index] & mask) == mask) {
+      return false;
+    }
+    table_[index] += static_cast<uint64_t>(1) << shift;
+    return true;
+  }
+
+  // 所有计数器减半，被截掉的奇数部分按4行平摊后从自增次数中扣除
+  void reset() {
+    size_t odd = 0;
+    for (uint64_t &word : table_) {
+      odd += static_cast<size_t>(detail::popCount(word & kOneMask));
+      word = (word >> 1) & kResetMask;
+    }
+    size_ = size_ > (odd >> 2) ? (size_ - (odd >> 2)) >> 1 : 0;
+  }
+
+private:
+  size_t tableMask_;            // 表长减1
+  size_t sampleSize_;           // 采样窗口大小
+  size_t size_;                 // 采样窗口内的自增次数
+  std::vector<uint64_t> table_; // 4位计数器表
+};
+
+} // namespace CacheMgr
\ No newline at end of file
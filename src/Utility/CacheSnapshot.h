@@ -0,0 +1,298 @@
+/*
+CacheSnapshot:
+缓存内容的快照文件，用于发布后热启动，避免空缓存把请求全部压到后端：
+    1. 各策略按淘汰顺序导出常驻条目，最先被淘汰的在前：LRU按最近访问顺序，
+       LFU按频次升序、同频次按加入频次桶的先后，并记录频次；ARC先T1后T2，并记录所在队列；
+       LRU另记录条目在分片内的相对新旧位置，合并多个分片时据此交错
+    2. 导出时逐个分片在分片锁内复制条目，锁外写文件，不停止其他分片的读写
+    3. 文件为紧凑的二进制格式：文件头（魔数、版本、策略、分片数）、逐分片的条目，
+       末尾是FNV-1a校验和；先写临时文件再改名，中途失败不会留下半个快照
+    4. 读取时mmap整个文件顺序解析，按当前的分片规则重新分组，
+       每个分片在一次加锁内批量写入，不逐条检查淘汰，超出容量时舍弃最先被淘汰的条目
+平凡可复制的类型按字节写入，std::string写入长度与内容，其他类型可特化SnapshotCodec。
+存活时间不写入快照，已到期的条目不导出。
+*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace CacheMgr {
+
+// 快照记录的淘汰策略，读取时必须与目标缓存一致
+enum class SnapshotPolicy : uint32_t {
+  LRU = 1,
+  LFU = 2,
+  ARC = 3,
+};
+
+// 快照中的一个条目，meta为策略相关的排序信息：LRU为分片内的新旧位置（越大越新），LFU为访问频次，
+// ARC为所在队列（0为T1，1为T2）；deadline为到期的毫秒刻度，只在分片迁移时携带，不写入快照文件
+template <typename Key, typename Value> struct SnapshotEntry {
+  Key key;
+  Value value;
+  uint32_t meta;
+  uint64_t deadline = UINT64_MAX;
+};
+
+// 一个分片的全部条目，按淘汰顺序排列
+template <typename Key, typename Value>
+using SnapshotShard = std::vector<SnapshotEntry<Key, Value>>;
+
+// 带缓冲的快照写入，写文件时同时累计校验和；也可以追加到内存缓冲区，用于编码单条记录
+class SnapshotWriter {
+public:
+  explicit SnapshotWriter(std::FILE *file)
+      : file_(file), buffer_(nullptr), ok_(true) {}
+
+  explicit SnapshotWriter(std::vector<unsigned char> &buffer)
+      : file_(nullptr), buffer_(&buffer), ok_(true) {}
+
+  void write(const void *data, size_t size) {
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    if (nullptr != buffer_) {
+      buffer_->insert(buffer_->end(), bytes, bytes + size);
+      return;
+    }
+    for (size_t idx = 0; idx < size; ++idx) {
+      checksum_ = (checksum_ ^ bytes[idx]) * kFnvPrime;
+    }
+    ok_ = ok_ && size == std::fwrite(data, 1, size, file_);
+  }
+
+  template <typename T> void writePod(const T &value) {
+    write(&value, sizeof(T));
+  }
+
+  uint64_t checksum() const { return checksum_; }
+  bool ok() const { return ok_; }
+
+  static constexpr uint64_t kFnvBasis = 14695981039346656037ull;
+  static constexpr uint64_t kFnvPrime = 1099511628211ull;
+
+private:
+  std::FILE *file_;                    // 目标文件
+  std::vector<unsigned char> *buffer_; // 目标缓冲区，不为空时不写文件
+  bool ok_;                            // 之前的写入是否全部成功
+  uint64_t checksum_ = kFnvBasis;      // 已写入内容的FNV-1a
+};
+
+// 在mmap的文件内容上顺序读取，越界时置为失败
+class SnapshotReader {
+public:
+  SnapshotReader(const unsigned char *data, size_t size)
+      : data_(data), size_(size), pos_(0), ok_(true) {}
+
+  bool read(void *out, size_t size) {
+    if (!ok_ || size > size_ - pos_) {
+      ok_ = false;
+      return false;
+    }
+    std::memcpy(out, data_ + pos_, size);
+    pos_ += size;
+    return true;
+  }
+
+  template <typename T> bool readPod(T &value) {
+    return read(&value, sizeof(T));
+  }
+
+  // 直接取得接下来size个字节，避免再复制一次
+  const unsigned char *take(size_t size) {
+    if (!ok_ || size > size_ - pos_) {
+      ok_ = false;
+      return nullptr;
+    }
+    const unsigned char *begin = data_ + pos_;
+    pos_ += size;
+    return begin;
+  }
+
+  size_t remaining() const { return size_ - pos_; }
+  bool ok() const { return ok_; }
+
+private:
+  const unsigned char *data_; // 文件内容
+  size_t size_;               // 文件长度
+  size_t pos_;                // 当前读取位置
+  bool ok_;                   // 是否未发生越界
+};
+
+// 关键字与缓存值的编解码，默认支持平凡可复制的类型
+template <typename T, typename = void> struct SnapshotCodec {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "specialize SnapshotCodec for non-trivially-copyable types");
+
+  static void encode(SnapshotWriter &writer, const T &value) {
+    writer.writePod(value);
+  }
+
+  static bool decode(SnapshotReader &reader, T &value) {
+    return reader.readPod(value);
+  }
+};
+
+template <> struct SnapshotCodec<std::string> {
+  static void encode(SnapshotWriter &writer, const std::string &value) {
+    writer.writePod(static_cast<uint32_t>(value.size()));
+    writer.write(value.data(), value.size());
+  }
+
+  static bool decode(SnapshotReader &reader, std::string &value) {
+    uint32_t size = 0;
+    if (!reader.readPod(size)) {
+      return false;
+    }
+    const unsigned char *bytes = reader.take(size);
+    if (nullptr == bytes) {
+      return false;
+    }
+    value.assign(reinterpret_cast<const char *>(bytes), size);
+    return true;
+  }
+};
+
+template <typename Key, typename Value> class SnapshotFile {
+public:
+  using Entry = SnapshotEntry<Key, Value>;
+  using Shard = SnapshotShard<Key, Value>;
+
+  /// @brief 写入快照，逐个分片调用shardAt取得条目（应在分片锁内复制），写完一个再取下一个
+  /// @param path 快照文件路径，先写入path.tmp再改名
+  /// @param policy 缓存的淘汰策略
+  /// @param shardNum 分片数量
+  /// @return 写入并改名成功返回true
+  static bool save(const std::string &path, SnapshotPolicy policy,
+                   size_t shardNum,
+                   const std::function<Shard(size_t)> &shardAt) {
+    std::string tmpPath = path + ".tmp";
+    std::FILE *file = std::fopen(tmpPath.c_str(), "wb");
+    if (nullptr == file) {
+      return false;
+    }
+    SnapshotWriter writer(file);
+    writer.write(kMagic, sizeof(kMagic));
+    writer.writePod(kVersion);
+    writer.writePod(static_cast<uint32_t>(policy));
+    writer.writePod(static_cast<uint64_t>(shardNum));
+    for (size_t idx = 0; idx < shardNum && writer.ok(); ++idx) {
+      Shard shard = shardAt(idx);
+      writer.writePod(static_cast<uint64_t>(shard.size()));
+      for (const Entry &entry : shard) {
+        SnapshotCodec<Key>::encode(writer, entry.key);
+        SnapshotCodec<Value>::encode(writer, entry.value);
+        writer.writePod(entry.meta);
+      }
+    }
+    uint64_t checksum = writer.checksum();
+    writer.writePod(checksum);
+    bool ok = writer.ok();
+    ok = 0 == std::fclose(file) && ok;
+    if (!ok || 0 != std::rename(tmpPath.c_str(), path.c_str())) {
+      std::remove(tmpPath.c_str());
+      return false;
+    }
+    return true;
+  }
+
+  /// @brief 读取快照，文件中的每个分片按顺序交给onShard
+  /// @param policy 目标缓存的淘汰策略，与快照不一致时失败
+  /// @return 文件完整且校验通过返回true；失败时不调用onShard
+  static bool load(const std::string &path, SnapshotPolicy policy,
+                   const std::function<void(Shard &&)> &onShard) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return false;
+    }
+    struct stat info;
+    if (0 != ::fstat(fd, &info) || info.st_size < kMinSize) {
+      ::close(fd);
+      return false;
+    }
+    size_t size = static_cast<size_t>(info.st_size);
+    void *mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (MAP_FAILED == mapped) {
+      return false;
+    }
+    ::madvise(mapped, size, MADV_SEQUENTIAL);
+    const unsigned char *data = static_cast<const unsigned char *>(mapped);
+    std::vector<Shard> shards;
+    bool ok = verify(data, size) && parse(data, size - sizeof(uint64_t),
+                                          policy, shards);
+    ::munmap(mapped, size);
+    if (!ok) {
+      return false;
+    }
+    for (Shard &shard : shards) {
+      onShard(std::move(shard));
+    }
+    return true;
+  }
+
+private:
+  static constexpr char kMagic[8] = {'C', 'M', 'S', 'N', 'A', 'P', '\0', '\0'};
+  static constexpr uint32_t kVersion = 1;
+  static constexpr off_t kMinSize =
+      sizeof(kMagic) + 2 * sizeof(uint32_t) + 2 * sizeof(uint64_t);
+
+  // 末尾8字节是前面全部内容的FNV-1a
+  static bool verify(const unsigned char *data, size_t size) {
+    size_t payload = size - sizeof(uint64_t);
+    uint64_t checksum = SnapshotWriter::kFnvBasis;
+    for (size_t idx = 0; idx < payload; ++idx) {
+      checksum = (checksum ^ data[idx]) * SnapshotWriter::kFnvPrime;
+    }
+    uint64_t stored = 0;
+    std::memcpy(&stored, data + payload, sizeof(stored));
+    return stored == checksum;
+  }
+
+  static bool parse(const unsigned char *data, size_t size,
+                    SnapshotPolicy policy, std::vector<Shard> &shards) {
+    SnapshotReader reader(data, size);
+    char magic[sizeof(kMagic)];
+    uint32_t version = 0;
+    uint32_t storedPolicy = 0;
+    uint64_t shardNum = 0;
+    if (!reader.read(magic, sizeof(magic)) ||
+        0 != std::memcmp(magic, kMagic, sizeof(kMagic)) ||
+        !reader.readPod(version) || kVersion != version ||
+        !reader.readPod(storedPolicy) ||
+        static_cast<uint32_t>(policy) != storedPolicy ||
+        !reader.readPod(shardNum)) {
+      return false;
+    }
+    for (uint64_t shardIdx = 0; shardIdx < shardNum; ++shardIdx) {
+      uint64_t count = 0;
+      if (!reader.readPod(count) || count > reader.remaining()) {
+        return false; // 每个条目至少占1字节，条目数不会超过剩余长度
+      }
+      Shard shard;
+      shard.resize(static_cast<size_t>(count));
+      for (Entry &entry : shard) {
+        if (!SnapshotCodec<Key>::decode(reader, entry.key) ||
+            !SnapshotCodec<Value>::decode(reader, entry.value) ||
+            !reader.readPod(entry.meta)) {
+          return false;
+        }
+      }
+      shards.push_back(std::move(shard));
+    }
+    return 0 == reader.remaining();
+  }
+};
+
+} // namespace CacheMgr
\ No newline at end of file
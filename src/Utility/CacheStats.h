@@ -0,0 +1,289 @@
+/*
+CacheStats:
+缓存内置的运行统计，每个分片各自一份：
+    1. 计数器：命中、未命中、写入、淘汰、到期、影子命中（ARC/CLOCK-Pro）、
+       历史晋升（LRU-K）、老化（LFU-Aging）
+    2. 计数器按线程分散到8个缓存行对齐的条带中，relaxed原子自增，
+       共享锁下的并发读不会争抢同一个缓存行；快照时把各条带相加
+    3. 锁等待时间与持有时间按纳秒的log2分桶记录为直方图，用于判断是否需要增加分片；
+       每个线程每64次加锁采样一次，未采样的加锁不读时钟
+    4. UncountedLookup作用域内当前线程的查找不计入命中与未命中，供读穿加载者在登记后再次查找，
+       一次未命中的加载只记一次未命中
+快照CacheStats是普通的值类型，可以相加，用于汇总多个分片。
+*/
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace CacheMgr {
+
+namespace detail {
+
+// 取最高位的1的位置，value不能为0
+inline unsigned highestBit(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+  return static_cast<unsigned>(63 - __builtin_clzll(value));
+#else
+  unsigned pos = 0;
+  while (0 != (value >>= 1)) {
+    ++pos;
+  }
+  return pos;
+#endif
+}
+
+} // namespace detail
+
+// 延迟直方图，第i个桶统计[2^i, 2^(i+1))纳秒，第0个桶包含不足2纳秒的样本
+struct LatencyHistogram {
+  static constexpr size_t kBuckets = 32;
+
+  uint64_t counts[kBuckets] = {};
+
+  // 样本所在的桶，超出范围的计入最后一个桶
+  static size_t bucketOf(uint64_t ns) {
+    if (ns < 2) {
+      return 0;
+    }
+    size_t bucket = detail::highestBit(ns);
+    return bucket < kBuckets ? bucket : kBuckets - 1;
+  }
+
+  // 样本总数
+  uint64_t total() const {
+    uint64_t sum = 0;
+    for (uint64_t count : counts) {
+      sum += count;
+    }
+    return sum;
+  }
+
+  // 分位数对应的桶上界（纳秒），没有样本时返回0
+  uint64_t percentile(double ratio) const {
+    uint64_t sum = total();
+    if (0 == sum) {
+      return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(ratio * static_cast<double>(sum));
+    uint64_t seen = 0;
+    for (size_t idx = 0; idx < kBuckets; ++idx) {
+      seen += counts[idx];
+      if (seen > rank) {
+        return static_cast<uint64_t>(1) << (idx + 1);
+      }
+    }
+    return static_cast<uint64_t>(1) << kBuckets;
+  }
+
+  LatencyHistogram &operator+=(const LatencyHistogram &other) {
+    for (size_t idx = 0; idx < kBuckets; ++idx) {
+      counts[idx] += other.counts[idx];
+    }
+    return *this;
+  }
+};
+
+// 统计快照
+struct CacheStats {
+  uint64_t hits = 0;        // 命中次数
+  uint64_t misses = 0;      // 未命中次数
+  uint64_t puts = 0;        // 写入次数
+  uint64_t evictions = 0;   // 因容量淘汰的条目数
+  uint64_t expirations = 0; // 因存活时间到期删除的条目数
+  uint64_t ghostHits = 0;   // 写入命中影子记录的次数
+  uint64_t promotions = 0;  // 从访问历史晋升到主缓存的次数
+  uint64_t agingSweeps = 0; // 频次老化的次数
+  LatencyHistogram lockWait; // 采样的锁等待时间
+  LatencyHistogram lockHold; // 采样的锁持有时间
+
+  // 命中率，没有访问时为0
+  double hitRate() const {
+    uint64_t total = hits + misses;
+    return 0 == total ? 0.0 : static_cast<double>(hits) / total;
+  }
+
+  CacheStats &operator+=(const CacheStats &other) {
+    hits += other.hits;
+    misses += other.misses;
+    puts += other.puts;
+    evictions += other.evictions;
+    expirations += other.expirations;
+    ghostHits += other.ghostHits;
+    promotions += other.promotions;
+    agingSweeps += other.agingSweeps;
+    lockWait += other.lockWait;
+    lockHold += other.lockHold;
+    return *this;
+  }
+};
+
+// 分片内的统计记录器，所有记录操作都是无锁的
+class StatsRecorder {
+public:
+  enum Counter : uint32_t {
+    Hit,
+    Miss,
+    Put,
+    Eviction,
+    Expiration,
+    GhostHit,
+    Promotion,
+    AgingSweep,
+    kCounterNum,
+  };
+
+  StatsRecorder() {
+    for (Stripe &stripe : stripes_) {
+      for (auto &value : stripe.values) {
+        value.store(0, std::memory_order_relaxed);
+      }
+    }
+    for (size_t idx = 0; idx < LatencyHistogram::kBuckets; ++idx) {
+      lockWait_[idx].store(0, std::memory_order_relaxed);
+      lockHold_[idx].store(0, std::memory_order_relaxed);
+    }
+  }
+
+  StatsRecorder(const StatsRecorder &) = delete;
+  StatsRecorder &operator=(const StatsRecorder &) = delete;
+
+  void add(Counter counter, uint64_t num = 1) {
+    if (counter <= Miss && !countsLookup()) {
+      return;
+    }
+    stripes_[stripeIndex()].values[counter].fetch_add(
+        num, std::memory_order_relaxed);
+  }
+
+  // 当前线程的查找是否计入命中与未命中，UncountedLookup作用域内为false
+  static bool countsLookup() { return !lookupMuted(); }
+
+  // 当前线程查找统计的屏蔽标记，由UncountedLookup设置
+  static bool &lookupMuted() {
+    thread_local bool muted = false;
+    return muted;
+  }
+
+  // 本次加锁是否需要计时
+  static bool sampleLock() {
+    thread_local uint32_t lockCount = 0;
+    return 0 == (++lockCount & (kLockSampleRate - 1));
+  }
+
+  // 记录一次采样的锁等待与持有时间（纳秒）
+  void recordLock(uint64_t waitNs, uint64_t holdNs) {
+    lockWait_[LatencyHistogram::bucketOf(waitNs)].fetch_add(1, std::memory_order_relaxed);
+    lockHold_[LatencyHistogram::bucketOf(holdNs)].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  CacheStats snapshot() const {
+    uint64_t sums[kCounterNum] = {};
+    for (const Stripe &stripe : stripes_) {
+      for (uint32_t idx = 0; idx < kCounterNum; ++idx) {
+        sums[idx] += stripe.values[idx].load(std::memory_order_relaxed);
+      }
+    }
+    CacheStats stats;
+    stats.hits = sums[Hit];
+    stats.misses = sums[Miss];
+    stats.puts = sums[Put];
+    stats.evictions = sums[Eviction];
+    stats.expirations = sums[Expiration];
+    stats.ghostHits = sums[GhostHit];
+    stats.promotions = sums[Promotion];
+    stats.agingSweeps = sums[AgingSweep];
+    for (size_t idx = 0; idx < LatencyHistogram::kBuckets; ++idx) {
+      stats.lockWait.counts[idx] = lockWait_[idx].load(std::memory_order_relaxed);
+      stats.lockHold.counts[idx] = lockHold_[idx].load(std::memory_order_relaxed);
+    }
+    return stats;
+  }
+
+private:
+  // 计数器条带数
+  static constexpr size_t kStripes = 8;
+  // 锁计时的采样间隔，必须是2的幂
+  static constexpr uint32_t kLockSampleRate = 64;
+
+  struct alignas(64) Stripe {
+    std::atomic<uint64_t> values[kCounterNum];
+  };
+
+  // 每个线程固定使用一个条带，按线程首次记录的顺序轮流分配
+  static size_t stripeIndex() {
+    static std::atomic<size_t> nextStripe{0};
+    thread_local size_t stripe =
+        nextStripe.fetch_add(1, std::memory_order_relaxed) % kStripes;
+    return stripe;
+  }
+
+private:
+  Stripe stripes_[kStripes];                                // 计数器条带
+  std::atomic<uint64_t> lockWait_[LatencyHistogram::kBuckets]; // 锁等待直方图
+  std::atomic<uint64_t> lockHold_[LatencyHistogram::kBuckets]; // 锁持有直方图
+};
+
+// 作用域内当前线程的查找不计入命中与未命中，可以嵌套
+class UncountedLookup {
+public:
+  UncountedLookup() : prev_(StatsRecorder::lookupMuted()) {
+    StatsRecorder::lookupMuted() = true;
+  }
+  ~UncountedLookup() { StatsRecorder::lookupMuted() = prev_; }
+
+  UncountedLookup(const UncountedLookup &) = delete;
+  UncountedLookup &operator=(const UncountedLookup &) = delete;
+
+private:
+  bool prev_; // 进入作用域之前的标记
+};
+
+// 带采样计时的独占锁守卫，用法与std::lock_guard相同
+template <typename Mutex> class TimedLockGuard {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  TimedLockGuard(Mutex &mutex, StatsRecorder &stats)
+      : mutex_(mutex), stats_(stats), sampled_(StatsRecorder::sampleLock()) {
+    if (!sampled_) {
+      mutex_.lock();
+      return;
+    }
+    Clock::time_point start = Clock::now();
+    mutex_.lock();
+    locked_ = Clock::now();
+    waitNs_ = elapsedNs(start, locked_);
+  }
+
+  ~TimedLockGuard() {
+    if (!sampled_) {
+      mutex_.unlock();
+      return;
+    }
+    uint64_t holdNs = elapsedNs(locked_, Clock::now());
+    mutex_.unlock();
+    stats_.recordLock(waitNs_, holdNs);
+  }
+
+  TimedLockGuard(const TimedLockGuard &) = delete;
+  TimedLockGuard &operator=(const TimedLockGuard &) = delete;
+
+private:
+  static uint64_t elapsedNs(Clock::time_point from, Clock::time_point to) {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(to - from)
+            .count());
+  }
+
+private:
+  Mutex &mutex_;             // 被守卫的锁
+  StatsRecorder &stats_;     // 计时结果的记录位置
+  bool sampled_;             // 本次加锁是否计时
+  Clock::time_point locked_; // 获得锁的时刻
+  uint64_t waitNs_ = 0;      // 等待锁的时间
+};
+
+} // namespace CacheMgr
\ No newline at end of file
@@ -0,0 +1,207 @@
+/*
+TieredCache:
+两层缓存：内存中的前端策略缓存 + 本地盘上的淘汰条目层（VictimLog）：
+    1. 前端容量淘汰的条目经淘汰回调交出，按关键字的条带暂存在待降级列表中，
+       当前操作离开前端的锁之后再持有该条带锁追加到日志，前端的锁内不做任何磁盘操作
+    2. get未命中前端时先查找本条带的待降级条目，再查找日志，命中的条目取出并写回前端（提升），
+       提升挤出的条目同样降级到日志
+    3. 提升、put与降级按关键字哈希分到64个条带锁上：put在条带锁内删除日志中的旧记录，
+       写入前端后丢弃本条带中该关键字的待降级条目；旧值要么还在待降级列表中被丢弃，
+       要么已在日志中被删除，不会在之后被追加到日志或提升回前端
+工作集远大于内存时，日志层以低于内存、高于网络的延迟承接前端的淘汰，减少回源。
+前端需支持get、put与setEvictionListener，如LRUCache、LFUAvgCache及其分片版本。
+*/
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "CacheHash.h"
+#include "CacheStats.h"
+#include "CacheVictimLog.h"
+
+namespace CacheMgr {
+
+// 第二层的计数
+struct TierStats {
+  uint64_t demotions = 0;  // 降级到日志的条目数
+  uint64_t dropped = 0;    // 过大或日志不可用而丢弃的淘汰条目数
+  uint64_t tierHits = 0;   // 前端未命中、日志命中并提升的次数
+  uint64_t tierMisses = 0; // 两层都未命中的次数
+};
+
+template <typename Key, typename Value, typename Front>
+class TieredCache {
+public:
+  /// @param logPath 日志文件路径
+  /// @param logBytes 日志文件的最大长度
+  /// @param frontArgs 前端缓存的构造参数
+  template <typename... Args>
+  TieredCache(const std::string &logPath, uint64_t logBytes,
+              Args &&...frontArgs)
+      : front_(std::forward<Args>(frontArgs)...), log_(logPath, logBytes) {
+    front_.setEvictionListener([this](const Key &key, Value &&val) {
+      std::lock_guard<std::mutex> lock(victimMutex_);
+      victims_[stripeIndex(key)].emplace_back(key, std::move(val));
+      ++pending_;
+    });
+  }
+
+  TieredCache(const TieredCache &) = delete;
+  TieredCache &operator=(const TieredCache &) = delete;
+
+  void put(const Key &key, const Value &val) {
+    {
+      std::lock_guard<std::mutex> lock(stripes_[stripeIndex(key)]);
+      log_.erase(key);
+      front_.put(key, val);
+      // 写入前被淘汰、尚未降级的旧值不再追加到日志
+      dropVictims(key);
+    }
+    demote();
+  }
+
+  bool get(const Key &key, Value &val) {
+    if (front_.get(key, val)) {
+      return true;
+    }
+    bool found = false;
+    {
+      std::lock_guard<std::mutex> lock(stripes_[stripeIndex(key)]);
+      // 待降级的条目比日志中的记录新
+      found = takeVictim(key, val);
+      if (found) {
+        log_.erase(key);
+      } else {
+        found = log_.take(key, val);
+      }
+      if (found) {
+        front_.put(key, val);
+      }
+    }
+    if (!found) {
+      tierMisses_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    tierHits_.fetch_add(1, std::memory_order_relaxed);
+    demote();
+    return true;
+  }
+
+  Value get(const Key &key) {
+    Value val{};
+    get(key, val);
+    return val;
+  }
+
+  // 前端缓存的运行统计
+  CacheStats stats() const { return front_.stats(); }
+
+  TierStats tierStats() const {
+    TierStats stats;
+    stats.demotions = demotions_.load(std::memory_order_relaxed);
+    stats.dropped = dropped_.load(std::memory_order_relaxed);
+    stats.tierHits = tierHits_.load(std::memory_order_relaxed);
+    stats.tierMisses = tierMisses_.load(std::memory_order_relaxed);
+    return stats;
+  }
+
+  // 日志中的条目数
+  size_t tierSize() const { return log_.size(); }
+
+  // 前端缓存，用于调用其特有的接口；直接写入不会删除日志中的旧记录
+  Front &front() { return front_; }
+
+private:
+  // 条带锁数量，必须是2的幂
+  static constexpr size_t kStripes = 64;
+
+  using Victims = std::vector<std::pair<Key, Value>>;
+
+  static size_t stripeIndex(const Key &key) {
+    return (CacheHash<Key>{}(key) >> 58) & (kStripes - 1);
+  }
+
+  // 持有关键字的条带锁时调用，丢弃该关键字的待降级条目
+  void dropVictims(const Key &key) {
+    std::lock_guard<std::mutex> lock(victimMutex_);
+    Victims &victims = victims_[stripeIndex(key)];
+    auto it = std::remove_if(
+        victims.begin(), victims.end(),
+        [&key](const std::pair<Key, Value> &victim) { return victim.first == key; });
+    pending_ -= static_cast<size_t>(victims.end() - it);
+    victims.erase(it, victims.end());
+  }
+
+  // 持有关键字的条带锁时调用，取出该关键字最新的待降级条目，并丢弃更早的
+  bool takeVictim(const Key &key, Value &val) {
+    std::lock_guard<std::mutex> lock(victimMutex_);
+    Victims &victims = victims_[stripeIndex(key)];
+    auto latest = std::find_if(
+        victims.rbegin(), victims.rend(),
+        [&key](const std::pair<Key, Value> &victim) { return victim.first == key; });
+    if (latest == victims.rend()) {
+      return false;
+    }
+    val = std::move(latest->second);
+    auto it = std::remove_if(
+        victims.begin(), victims.end(),
+        [&key](const std::pair<Key, Value> &victim) { return victim.first == key; });
+    pending_ -= static_cast<size_t>(victims.end() - it);
+    victims.erase(it, victims.end());
+    return true;
+  }
+
+  // 把暂存的淘汰条目逐个条带追加到日志，在前端的锁外、持有该条带锁时执行，
+  // 与同一关键字的put、提升互斥
+  void demote() {
+    std::vector<size_t> stripes;
+    {
+      std::lock_guard<std::mutex> lock(victimMutex_);
+      if (0 == pending_) {
+        return;
+      }
+      for (size_t idx = 0; idx < kStripes; ++idx) {
+        if (!victims_[idx].empty()) {
+          stripes.push_back(idx);
+        }
+      }
+    }
+    for (size_t idx : stripes) {
+      std::lock_guard<std::mutex> stripe(stripes_[idx]);
+      Victims victims;
+      {
+        std::lock_guard<std::mutex> lock(victimMutex_);
+        victims.swap(victims_[idx]);
+        pending_ -= victims.size();
+      }
+      for (auto &victim : victims) {
+        if (log_.append(victim.first, victim.second)) {
+          demotions_.fetch_add(1, std::memory_order_relaxed);
+        } else {
+          dropped_.fetch_add(1, std::memory_order_relaxed);
+        }
+      }
+    }
+  }
+
+private:
+  Front front_;                                 // 前端缓存
+  VictimLog<Key, Value> log_;                   // 淘汰条目层
+  std::mutex victimMutex_;                      // 保护victims_与pending_
+  Victims victims_[kStripes];                   // 按条带暂存的待降级条目
+  size_t pending_ = 0;                          // 待降级的条目总数
+  std::mutex stripes_[kStripes];                // 提升、写入与降级的条带锁
+  std::atomic<uint64_t> demotions_{0};
+  std::atomic<uint64_t> dropped_{0};
+  std::atomic<uint64_t> tierHits_{0};
+  std::atomic<uint64_t> tierMisses_{0};
+};
+
+} // namespace CacheMgr
\ No newline at end of file
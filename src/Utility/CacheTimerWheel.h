@@ -0,0 +1,245 @@
+/*
+TimerWheel:
+按关键字管理到期时间的分层时间轮，用于缓存条目的存活时间（TTL）：
+    1. 时间以毫秒为刻度，共4层，每层64个槽位，第L层一个槽位覆盖64^L个刻度，
+       4层合计覆盖2^24毫秒（约4.6小时），更远的定时器放入溢出链表
+    2. 定时器按到期刻度与当前刻度的最高不同位选择层级，低层转完一圈时把上一层当前槽位的定时器
+       按剩余时间重新分配到下层（级联），溢出链表在最高层转完一圈时重新分配
+    3. 添加、取消、重设都是O(1)；推进时间时每个定时器最多被级联4次，到期处理均摊O(1)，
+       低层为空时直接跳到下一次级联的刻度，不逐刻度空转
+    4. 定时器存放在下标链表串联的节点池中，前257个槽位是各槽位链表的哨兵
+本类不加锁，由外层缓存负责同步；调用schedule之前需要先advance到当前时间。
+*/
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "CacheFlatMap.h"
+
+namespace CacheMgr {
+
+template <typename Key,
+          template <typename, typename> class Index = CacheIndexMap>
+class TimerWheel {
+public:
+  // 永不到期
+  static constexpr uint64_t kNever = UINT64_MAX;
+
+  TimerWheel() : current_(0), size_(0), freeHead_(kNil), timers_(kSlotNum) {
+    for (uint32_t slot = 0; slot < kSlotNum; ++slot) {
+      timers_[slot].prev = timers_[slot].next = slot;
+    }
+    for (uint32_t level = 0; level <= kLevels; ++level) {
+      levelCount_[level] = 0;
+    }
+  }
+
+  // 当前时间的毫秒刻度
+  static uint64_t now() {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+  }
+
+  bool empty() const { return 0 == size_; }
+  size_t size() const { return size_; }
+
+  // 设置关键字的到期刻度，已有定时器时重设
+  void schedule(const Key &key, uint64_t deadline) {
+    uint32_t idx;
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+      idx = it->second;
+      unlink(idx);
+    } else {
+      idx = allocate(key);
+      index_[key] = idx;
+      ++size_;
+    }
+    timers_[idx].deadline = deadline;
+    // 当前刻度的槽位已经处理过，最早放到下一个刻度
+    place(idx, deadline > current_ ? deadline : current_ + 1);
+  }
+
+  // 取消关键字的定时器
+  void cancel(const Key &key) {
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+      uint32_t idx = it->second;
+      index_.erase(key);
+      unlink(idx);
+      release(idx);
+    }
+  }
+
+  // 关键字是否已到期，没有定时器的关键字永不到期
+  bool expired(const Key &key, uint64_t now) const {
+    auto it = index_.find(key);
+    return it != index_.end() && timers_[it->second].deadline <= now;
+  }
+
+  // 关键字的到期刻度，没有定时器时返回kNever
+  uint64_t deadline(const Key &key) const {
+    auto it = index_.find(key);
+    return it != index_.end() ? timers_[it->second].deadline : kNever;
+  }
+
+  // 推进到now，对每个到期的关键字调用onExpire(key)，回调时定时器已被移除
+  template <typename F> void advance(uint64_t now, F &&onExpire) {
+    while (current_ < now) {
+      if (0 == size_) {
+        current_ = now;
+        return;
+      }
+      // 低层全部为空时，下一次有事可做的刻度是最低非空层的级联边界
+      uint32_t level = 0;
+      while (level < kLevels && 0 == levelCount_[level]) {
+        ++level;
+      }
+      if (level > 0) {
+        uint32_t shift = kBits * level;
+        uint64_t boundary = ((current_ >> shift) + 1) << shift;
+        if (boundary > now) {
+          current_ = now;
+          return;
+        }
+        current_ = boundary - 1;
+      }
+      tick(onExpire);
+    }
+  }
+
+  // 清空所有定时器，当前刻度保持不变
+  void clear() {
+    index_.clear();
+    timers_.resize(kSlotNum);
+    for (uint32_t slot = 0; slot < kSlotNum; ++slot) {
+      timers_[slot].prev = timers_[slot].next = slot;
+    }
+    for (uint32_t level = 0; level <= kLevels; ++level) {
+      levelCount_[level] = 0;
+    }
+    freeHead_ = kNil;
+    size_ = 0;
+  }
+
+private:
+  // 每层槽位数的位数与层数
+  static constexpr uint32_t kBits = 6;
+  static constexpr uint32_t kLevels = 4;
+  static constexpr uint64_t kMask = (1u << kBits) - 1;
+  // 溢出链表的哨兵槽位
+  static constexpr uint32_t kOverflow = kLevels << kBits;
+  // 哨兵槽位总数
+  static constexpr uint32_t kSlotNum = kOverflow + 1;
+  // 空闲链表的结束标记
+  static constexpr uint32_t kNil = UINT32_MAX;
+
+  struct Timer {
+    Key key;           // 关键字
+    uint64_t deadline; // 到期刻度
+    uint32_t prev;     // 槽位链表的前一个定时器
+    uint32_t next;     // 槽位链表的后一个定时器（空闲时串联空闲链表）
+    uint32_t slot;     // 所在槽位
+  };
+
+  static uint32_t levelOf(uint32_t slot) { return slot >> kBits; }
+
+  // 前进一个刻度：先级联，再处理第0层当前槽位中到期的定时器
+  template <typename F> void tick(F &&onExpire) {
+    ++current_;
+    for (uint32_t level = kLevels; level > 0; --level) {
+      uint64_t lowBits = (static_cast<uint64_t>(1) << (kBits * level)) - 1;
+      if (0 != (current_ & lowBits)) {
+        continue;
+      }
+      cascade(kLevels == level
+                  ? kOverflow
+                  : (level << kBits) +
+                        static_cast<uint32_t>((current_ >> (kBits * level)) &
+                                              kMask));
+    }
+    uint32_t slot = static_cast<uint32_t>(current_ & kMask);
+    while (timers_[slot].next != slot) {
+      uint32_t idx = timers_[slot].next;
+      Key key = std::move(timers_[idx].key);
+      index_.erase(key);
+      unlink(idx);
+      release(idx);
+      onExpire(key);
+    }
+  }
+
+  // 把槽位中的定时器按剩余时间重新分配到较低的层级
+  void cascade(uint32_t slot) {
+    uint32_t idx = timers_[slot].next;
+    timers_[slot].prev = timers_[slot].next = slot;
+    while (slot != idx) {
+      uint32_t next = timers_[idx].next;
+      --levelCount_[levelOf(slot)];
+      uint64_t deadline = timers_[idx].deadline;
+      place(idx, deadline > current_ ? deadline : current_);
+      idx = next;
+    }
+  }
+
+  // 按刻度tick与当前刻度的最高不同位选择层级与槽位，挂入槽位链表末尾
+  void place(uint32_t idx, uint64_t tick) {
+    uint32_t slot = kOverflow;
+    for (uint32_t level = 0; level < kLevels; ++level) {
+      uint32_t shift = kBits * (level + 1);
+      if ((tick >> shift) == (current_ >> shift)) {
+        slot = (level << kBits) +
+               static_cast<uint32_t>((tick >> (kBits * level)) & kMask);
+        break;
+      }
+    }
+    Timer &timer = timers_[idx];
+    Timer &dummy = timers_[slot];
+    timer.slot = slot;
+    timer.prev = dummy.prev;
+    timer.next = slot;
+    timers_[dummy.prev].next = idx;
+    dummy.prev = idx;
+    ++levelCount_[levelOf(slot)];
+  }
+
+  void unlink(uint32_t idx) {
+    Timer &timer = timers_[idx];
+    timers_[timer.prev].next = timer.next;
+    timers_[timer.next].prev = timer.prev;
+    --levelCount_[levelOf(timer.slot)];
+  }
+
+  uint32_t allocate(const Key &key) {
+    uint32_t idx = freeHead_;
+    if (kNil == idx) {
+      idx = static_cast<uint32_t>(timers_.size());
+      timers_.emplace_back();
+    } else {
+      freeHead_ = timers_[idx].next;
+    }
+    timers_[idx].key = key;
+    return idx;
+  }
+
+  void release(uint32_t idx) {
+    timers_[idx].next = freeHead_;
+    freeHead_ = idx;
+    --size_;
+  }
+
+private:
+  uint64_t current_;                   // 当前刻度
+  size_t size_;                        // 定时器数量
+  uint32_t freeHead_;                  // 空闲节点链表头
+  size_t levelCount_[kLevels + 1];     // 各层（含溢出链表）的定时器数量
+  Index<Key, uint32_t> index_;         // 关键字到定时器节点的索引
+  std::vector<Timer> timers_;          // 定时器节点池，前kSlotNum个是哨兵
+};
+
+} // namespace CacheMgr
\ No newline at end of file
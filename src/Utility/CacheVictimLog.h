@@ -0,0 +1,206 @@
+/*
+VictimLog:
+存放被前端缓存淘汰的条目的第二层缓存，数据在本地盘（NVMe）上的只追加日志中：
+    1. 日志文件划分为固定大小的段，组成环形：条目编码后追加到内存中的当前段，
+       当前段写满后用pwrite整段写入文件，再开启下一段；环满时复用最旧的段，其中的条目随之失效
+    2. 内存中的索引只保存关键字哈希到（逻辑地址, 长度）的映射，不保存关键字本身；
+       读取时解码记录并比较关键字，哈希冲突时按未命中处理。每段另记录段内条目的哈希，
+       复用该段时据此从索引中删除，不需要回读磁盘
+    3. 当前段的条目直接从内存读取；已写入文件的条目在锁外pread，读完后确认索引未变，
+       期间段被复用或条目被覆盖时按未命中处理
+    4. 同一关键字再次写入时索引指向最新的记录，旧记录成为空洞，随段的复用一起回收
+关键字与缓存值用SnapshotCodec编码。日志文件在打开时清空、析构时删除，重启后不再使用。
+*/
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "CacheFlatMap.h"
+#include "CacheHash.h"
+#include "CacheSnapshot.h"
+
+namespace CacheMgr {
+
+template <typename Key, typename Value, typename Hash = CacheHash<Key>>
+class VictimLog {
+public:
+  /// @param path 日志文件路径，已存在时清空
+  /// @param maxBytes 日志文件的最大长度，向下取整为段长度的整数倍，至少两段
+  /// @param segmentBytes 段长度，也是单条记录的长度上限
+  VictimLog(const std::string &path, uint64_t maxBytes,
+            size_t segmentBytes = kDefaultSegmentBytes)
+      : path_(path), segmentBytes_(segmentBytes),
+        segmentNum_(std::max<uint64_t>(2, maxBytes / segmentBytes)), seq_(0),
+        segmentHashes_(static_cast<size_t>(segmentNum_)) {
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    buffer_.reserve(segmentBytes_);
+  }
+
+  VictimLog(const VictimLog &) = delete;
+  VictimLog &operator=(const VictimLog &) = delete;
+
+  ~VictimLog() {
+    if (fd_ >= 0) {
+      ::close(fd_);
+      ::unlink(path_.c_str());
+    }
+  }
+
+  // 日志文件是否打开成功，失败时所有写入都被丢弃
+  bool isOpen() const { return fd_ >= 0; }
+
+  // 追加一条记录，超过段长度或文件不可用时丢弃并返回false
+  bool append(const Key &key, const Value &val) {
+    if (fd_ < 0) {
+      return false;
+    }
+    std::vector<unsigned char> record;
+    SnapshotWriter writer(record);
+    SnapshotCodec<Key>::encode(writer, key);
+    SnapshotCodec<Value>::encode(writer, val);
+    if (record.size() > segmentBytes_) {
+      return false;
+    }
+    uint64_t hash = static_cast<uint64_t>(Hash{}(key));
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (buffer_.size() + record.size() > segmentBytes_) {
+      seal();
+    }
+    uint64_t address = seq_ * segmentBytes_ + buffer_.size();
+    buffer_.insert(buffer_.end(), record.begin(), record.end());
+    index_[hash] = Location{address, static_cast<uint32_t>(record.size())};
+    segmentHashes_[slotOf(seq_)].push_back(hash);
+    return true;
+  }
+
+  /// @brief 读出并删除关键字的记录，用于把条目提升回前端缓存
+  /// @return 找到且关键字一致时返回true
+  bool take(const Key &key, Value &val) {
+    uint64_t hash = static_cast<uint64_t>(Hash{}(key));
+    std::vector<unsigned char> record;
+    Location loc;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = index_.find(hash);
+      if (it == index_.end()) {
+        return false;
+      }
+      loc = it->second;
+      if (loc.address / segmentBytes_ == seq_) {
+        // 仍在内存中的当前段
+        size_t offset = static_cast<size_t>(loc.address % segmentBytes_);
+        if (!decode(buffer_.data() + offset, loc.size, key, val)) {
+          return false;
+        }
+        index_.erase(hash);
+        return true;
+      }
+    }
+    record.resize(loc.size);
+    off_t offset = static_cast<off_t>(slotOf(loc.address / segmentBytes_) *
+                                          segmentBytes_ +
+                                      loc.address % segmentBytes_);
+    if (static_cast<ssize_t>(loc.size) !=
+        ::pread(fd_, record.data(), loc.size, offset)) {
+      return false;
+    }
+    Value loaded;
+    if (!decode(record.data(), loc.size, key, loaded)) {
+      return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(hash);
+    if (it == index_.end() || it->second.address != loc.address) {
+      return false; // 读取期间段被复用或记录被覆盖，读到的内容不可信
+    }
+    index_.erase(hash);
+    val = std::move(loaded);
+    return true;
+  }
+
+  // 删除关键字的记录，前端写入新值时调用，避免之后读到旧值
+  void erase(const Key &key) {
+    uint64_t hash = static_cast<uint64_t>(Hash{}(key));
+    std::lock_guard<std::mutex> lock(mutex_);
+    index_.erase(hash);
+  }
+
+  // 索引中的条目数
+  size_t size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return index_.size();
+  }
+
+  // 日志文件的最大长度
+  uint64_t capacityBytes() const { return segmentNum_ * segmentBytes_; }
+
+private:
+  static constexpr size_t kDefaultSegmentBytes = 4 << 20;
+
+  struct Location {
+    uint64_t address; // 逻辑地址：段序号 * 段长度 + 段内偏移
+    uint32_t size;    // 记录长度
+  };
+
+  size_t slotOf(uint64_t seq) const {
+    return static_cast<size_t>(seq % segmentNum_);
+  }
+
+  // 当前段写入文件并开启下一段，环满时复用最旧的段
+  void seal() {
+    off_t offset = static_cast<off_t>(slotOf(seq_) * segmentBytes_);
+    if (static_cast<ssize_t>(buffer_.size()) !=
+        ::pwrite(fd_, buffer_.data(), buffer_.size(), offset)) {
+      dropSegment(seq_); // 写入失败，这一段的条目不再可读
+    }
+    buffer_.clear();
+    ++seq_;
+    if (seq_ >= segmentNum_) {
+      dropSegment(seq_ - segmentNum_);
+    }
+  }
+
+  // 从索引中删除仍指向指定段的条目
+  void dropSegment(uint64_t seq) {
+    std::vector<uint64_t> &hashes = segmentHashes_[slotOf(seq)];
+    for (uint64_t hash : hashes) {
+      auto it = index_.find(hash);
+      if (it != index_.end() && it->second.address / segmentBytes_ == seq) {
+        index_.erase(hash);
+      }
+    }
+    hashes.clear();
+  }
+
+  static bool decode(const unsigned char *data, size_t size, const Key &key,
+                     Value &val) {
+    SnapshotReader reader(data, size);
+    Key stored;
+    if (!SnapshotCodec<Key>::decode(reader, stored) || !(stored == key)) {
+      return false; // 哈希冲突
+    }
+    return SnapshotCodec<Value>::decode(reader, val);
+  }
+
+private:
+  std::string path_;                 // 日志文件路径
+  int fd_;                           // 日志文件
+  size_t segmentBytes_;              // 段长度
+  uint64_t segmentNum_;              // 段数量
+  uint64_t seq_;                     // 当前段的序号
+  std::vector<unsigned char> buffer_; // 当前段在内存中的内容
+  std::vector<std::vector<uint64_t>> segmentHashes_; // 各段中条目的关键字哈希
+  FlatMap<uint64_t, Location> index_; // 关键字哈希到记录位置的索引
+  mutable std::mutex mutex_;         // 保护以上状态
+};
+
+} // namespace CacheMgr
\ No newline at end of file
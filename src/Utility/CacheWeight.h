@@ -0,0 +1,61 @@
+/*
+WeightBudget:
+按权重（通常是字节数）限制缓存容量的计重器，替代按条目数计的容量：
+    1. 权重由用户提供的weigher(key, value)计算，同一对key/value必须返回相同的权重，
+       缓存只在写入与淘汰时调用，不额外保存每个条目的权重
+    2. 写入后总权重超过预算时，缓存按各自的淘汰顺序循环淘汰，直到总权重回到预算以内
+    3. 单个条目的权重超过整个预算时拒绝写入，已有的同名条目一并删除，避免读到旧值
+未设置weigher时不启用，缓存仍按条目数计容量。本类不加锁，由外层缓存负责同步。
+*/
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <utility>
+
+namespace CacheMgr {
+
+// 计算条目权重的函数
+template <typename Key, typename Value>
+using CacheWeigher = std::function<size_t(const Key &, const Value &)>;
+
+template <typename Key, typename Value> class WeightBudget {
+public:
+  using Weigher = CacheWeigher<Key, Value>;
+
+  // 不启用权重限制
+  WeightBudget() : maxWeight_(0), weight_(0) {}
+
+  WeightBudget(size_t maxWeight, Weigher weigher)
+      : maxWeight_(maxWeight), weight_(0), weigher_(std::move(weigher)) {}
+
+  // 是否启用了权重限制
+  bool enabled() const { return static_cast<bool>(weigher_); }
+
+  // 条目的权重，未启用时为0
+  size_t weigh(const Key &key, const Value &val) const {
+    return enabled() ? weigher_(key, val) : 0;
+  }
+
+  // 单个条目能否放入预算
+  bool admits(size_t weight) const { return !enabled() || weight <= maxWeight_; }
+
+  // 当前总权重是否超过预算
+  bool over() const { return weight_ > maxWeight_; }
+
+  void add(size_t weight) { weight_ += weight; }
+  void sub(size_t weight) { weight_ -= weight < weight_ ? weight : weight_; }
+  void clear() { weight_ = 0; }
+
+  size_t weight() const { return weight_; }
+  size_t maxWeight() const { return maxWeight_; }
+  // 调整权重预算，缩小后由调用方淘汰到预算以内
+  void setMaxWeight(size_t maxWeight) { maxWeight_ = maxWeight; }
+
+private:
+  size_t maxWeight_; // 权重预算
+  size_t weight_;    // 当前总权重
+  Weigher weigher_;  // 权重函数
+};
+
+} // namespace CacheMgr
\ No newline at end of file